@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_common.h"
+#include "bench_alloc_count.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+
+#define WARMUP_ITERATIONS 100
+#define ITERATIONS 100000
+
+static const char* FORMULAS[] = {
+    "1+2*3",
+    "(1.5+2)*(3-4)/5^2 + 7*8 - 9/3",
+    "sqrt(16)+sin(30)*cos(0.5)-logbase(2, 8)+abs(3-7)+log10(100)+exp(1)",
+    "x*2 + pi",
+};
+
+// One full evaluation: tokenize, shunting yard, parse, evaluate, tear down
+static double evaluate_once(CalcEngine* engine, const char* formula) {
+    TokenizerResult tokens = tokenizeQuery(engine, formula);
+    TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+    ParseResult* ast = parse_expression(engine, postfix);
+    double value = evaluate_ast(ast->root, engine->variables->values, NULL);
+    calc_engine_reset(engine);
+    return value;
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    printf("%-70s %12s %14s %10s\n", "formula", "first call", "steady allocs", "ns/op");
+    for (size_t i = 0; i < sizeof(FORMULAS) / sizeof(FORMULAS[0]); i++) {
+        size_t before = allocation_count;
+        bench_consume(evaluate_once(engine, FORMULAS[i]));
+        size_t first = allocation_count - before;
+
+        for (int r = 0; r < WARMUP_ITERATIONS; r++) {
+            bench_consume(evaluate_once(engine, FORMULAS[i]));
+        }
+
+        before = allocation_count;
+        double start = bench_now_ns();
+        for (int r = 0; r < ITERATIONS; r++) {
+            bench_consume(evaluate_once(engine, FORMULAS[i]));
+        }
+        double per_op = (bench_now_ns() - start) / ITERATIONS;
+        double steady = (double)(allocation_count - before) / ITERATIONS;
+
+        printf("%-70s %12zu %14.2f %10.1f\n", FORMULAS[i], first, steady, per_op);
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
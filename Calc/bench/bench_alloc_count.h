@@ -0,0 +1,40 @@
+#ifndef BENCH_ALLOC_COUNT_H
+#define BENCH_ALLOC_COUNT_H
+
+#include <stddef.h>
+
+/*
+ * Counting allocator for benchmarks that report allocations per operation.
+ * Including this header replaces malloc/calloc/realloc/free for the whole
+ * process (libc's strdup and fopen included), so include it from exactly one
+ * translation unit of a benchmark executable.
+ */
+
+// glibc's own entry points, used by the counting wrappers below
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+static size_t allocation_count;
+
+void* malloc(size_t size) {
+    allocation_count++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    allocation_count++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    allocation_count++;
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+#endif /* BENCH_ALLOC_COUNT_H */
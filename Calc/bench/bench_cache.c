@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bench_common.h"
+#include "computation/batch.h"
+#include "computation/expression_cache.h"
+
+#define FORMULAS 2000
+#define LOOKUPS 200000
+#define VARIABLES "abcdefgh"
+
+static const char* TEMPLATES[] = {
+    "sin(%d)*a + sqrt(b^2 + c^2) - %d/e",
+    "(a+%d)*(b-%d)/(c+1) + logbase(2, d+%d)",
+    "abs(f - %d) + cos(g*%d) * h",
+    "((a*b + %d) - (c*d - %d))^2 / (e + f + %d)",
+};
+
+// Zipf-like choice: low formula indices repeat far more often than high ones
+static size_t pick_formula(unsigned int* seed) {
+    double u = (double)rand_r(seed) / ((double)RAND_MAX + 1.0);
+    return (size_t)(pow(u, 3.0) * FORMULAS);
+}
+
+static void set_variables(CalcEngine* engine, double offset) {
+    for (size_t i = 0; VARIABLES[i]; i++) {
+        char name[2] = { VARIABLES[i], '\0' };
+        if (!hashmapconst_update(engine->variables, name, 1.5 + i + offset)) {
+            hashmapconst_add(engine->variables, name, 1.5 + i + offset);
+        }
+    }
+}
+
+static double run(CalcEngine* engine, char** formulas, const size_t* order, double* checksum) {
+    double start = bench_now_ns();
+    double sum = 0.0;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        BatchResult result = evaluate_expression_text(engine, formulas[order[i]]);
+        if (result.error == COMPUTATION_OK) sum += result.value;
+    }
+    *checksum = sum;
+    return (bench_now_ns() - start) / LOOKUPS;
+}
+
+int main(void) {
+    char** formulas = malloc(FORMULAS * sizeof(char*));
+    size_t* order = malloc(LOOKUPS * sizeof(size_t));
+    if (!formulas || !order) return 1;
+
+    for (size_t i = 0; i < FORMULAS; i++) {
+        char text[160];
+        int n = (int)i;
+        snprintf(text, sizeof(text), TEMPLATES[i % 4], n, n + 1, n + 2);
+        formulas[i] = strdup(text);
+    }
+    unsigned int seed = 42;
+    for (size_t i = 0; i < LOOKUPS; i++) {
+        order[i] = pick_formula(&seed);
+    }
+
+    CalcEngine* uncached = bench_init();
+    CalcEngine* cached = bench_init();
+    if (!uncached || !cached) return 1;
+    expression_cache_set_limit(uncached->expression_cache, 0);
+    set_variables(uncached, 0.0);
+    set_variables(cached, 0.0);
+
+    double checksum_uncached, checksum_cached;
+    double uncached_ns = run(uncached, formulas, order, &checksum_uncached);
+    double cached_ns = run(cached, formulas, order, &checksum_cached);
+    const ExpressionCache* cache = cached->expression_cache;
+    printf("%zu lookups over %d formulas (Zipf-like), default cap %u bytes\n", (size_t)LOOKUPS, FORMULAS, EXPRESSION_CACHE_DEFAULT_BYTES);
+    printf("%-10s %10s %10s %8s\n", "mode", "ns/expr", "hit rate", "check");
+    printf("%-10s %10.1f %10s %8s\n", "uncached", uncached_ns, "-", "-");
+    printf("%-10s %10.1f %9.1f%% %8s\n", "cached", cached_ns, 100.0 * cache->hits / (cache->hits + cache->misses),
+           checksum_cached == checksum_uncached ? "ok" : "MISMATCH");
+
+    // Cached trees read variables when evaluated, so new values must show up on hits
+    set_variables(uncached, 10.0);
+    set_variables(cached, 10.0);
+    run(uncached, formulas, order, &checksum_uncached);
+    run(cached, formulas, order, &checksum_cached);
+    printf("after variable update: %s\n", checksum_cached == checksum_uncached ? "ok" : "MISMATCH");
+    bool ok = checksum_cached == checksum_uncached;
+
+    printf("\n%12s %10s %10s %10s %10s\n", "cap (bytes)", "ns/expr", "hit rate", "evictions", "entries");
+    static const size_t CAPS[] = { 16 * 1024, 64 * 1024, 256 * 1024, 1024 * 1024 };
+    for (size_t c = 0; c < sizeof(CAPS) / sizeof(CAPS[0]); c++) {
+        CalcEngine* engine = bench_init();
+        if (!engine) return 1;
+        expression_cache_set_limit(engine->expression_cache, CAPS[c]);
+        set_variables(engine, 0.0);
+        double checksum;
+        double ns = run(engine, formulas, order, &checksum);
+        cache = engine->expression_cache;
+        printf("%12zu %10.1f %9.1f%% %10zu %10zu\n", CAPS[c], ns, 100.0 * cache->hits / (cache->hits + cache->misses),
+               cache->evictions, cache->entries);
+        bench_shutdown(engine);
+    }
+
+    bench_shutdown(uncached);
+    bench_shutdown(cached);
+    for (size_t i = 0; i < FORMULAS; i++) free(formulas[i]);
+    free(formulas);
+    free(order);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "bench_common.h"
+#include "computation/compiled_expression.h"
+
+static const char* FORMULAS[] = {
+    "x*y + 2",
+    "sqrt(x^2 + y^2) * 0.5 - abs(x - y)",
+    "(x + y) / (1 + x*x) + sin(30) * y",
+};
+
+static const size_t SIZES[] = {1000, 100000, 1000000, 10000000};
+
+static void bench_formula(CalcEngine* engine, const char* formula, size_t rows, double* x, double* y, double* out) {
+    static const char* names[] = {"x", "y"};
+    CompiledExpression* expr = compile_expression(engine, formula, names, 2, NULL);
+    if (!expr) {
+        fprintf(stderr, "failed to compile %s\n", formula);
+        return;
+    }
+
+    const double* columns[] = {x, y};
+    int repeats = rows >= 1000000 ? 3 : (int)(10000000 / rows);
+
+    double start = bench_now_ns();
+    for (int r = 0; r < repeats; r++) {
+        compiled_expression_evaluate_columns(expr, columns, rows, out);
+    }
+    double column_ns = (bench_now_ns() - start) / repeats;
+
+    double mismatch = 0;
+    start = bench_now_ns();
+    for (int r = 0; r < repeats; r++) {
+        for (size_t i = 0; i < rows; i++) {
+            compiled_expression_set_variable(expr, 0, x[i]);
+            compiled_expression_set_variable(expr, 1, y[i]);
+            double value = compiled_expression_evaluate(expr).value;
+            if (r == 0) mismatch = fmax(mismatch, fabs(value - out[i]));
+        }
+    }
+    double row_ns = (bench_now_ns() - start) / repeats;
+
+    printf("%-36s %10zu %16.0f %16.0f %8.2fx %10.2g\n", formula, rows,
+           rows / (column_ns / 1e9), rows / (row_ns / 1e9), row_ns / column_ns, mismatch);
+    compiled_expression_free(expr);
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    size_t max_rows = SIZES[sizeof(SIZES) / sizeof(SIZES[0]) - 1];
+    double* x = malloc(max_rows * sizeof(double));
+    double* y = malloc(max_rows * sizeof(double));
+    double* out = malloc(max_rows * sizeof(double));
+    if (!x || !y || !out) {
+        fprintf(stderr, "allocation failed\n");
+        return 1;
+    }
+    for (size_t i = 0; i < max_rows; i++) {
+        x[i] = (double)(i % 1000) * 0.01;
+        y[i] = 1.0 + (double)(i % 777) * 0.02;
+    }
+
+    printf("column kernels: %s\n", bytecode_column_isa());
+    printf("%-36s %10s %16s %16s %9s %10s\n", "formula", "rows", "columns rows/s", "per-row rows/s", "speedup", "max diff");
+    for (size_t f = 0; f < sizeof(FORMULAS) / sizeof(FORMULAS[0]); f++) {
+        for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++) {
+            bench_formula(engine, FORMULAS[f], SIZES[s], x, y, out);
+        }
+    }
+
+    free(x);
+    free(y);
+    free(out);
+    bench_shutdown(engine);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "computation/tokenizer.h"
+#include "computation/computation.h"
+#include "computation/engine.h"
+
+/**
+ * @brief Monotonic wall clock in nanoseconds
+ */
+static inline double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Creates the engine a benchmark runs in, with tree dumps silenced
+ * @return The engine or NULL on failure
+ */
+static inline CalcEngine* bench_init(void) {
+    CalcEngine* engine = calc_engine_create();
+    if (!engine) {
+        fprintf(stderr, "Benchmark initialization failed\n");
+        return NULL;
+    }
+    engine->verbosity = CALC_VERBOSITY_QUIET;
+    return engine;
+}
+
+/**
+ * @brief Releases the engine created by bench_init
+ */
+static inline void bench_shutdown(CalcEngine* engine) {
+    calc_engine_destroy(engine);
+}
+
+/**
+ * @brief Keeps the optimizer from discarding a computed value
+ */
+static volatile double bench_sink;
+static inline void bench_consume(double value) {
+    bench_sink = value;
+}
+
+#endif /* BENCH_COMMON_H */
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench_common.h"
+#include "computation/compiled_expression.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+
+#define COMPILE_ITERATIONS 20000
+#define EVAL_ITERATIONS 1000000
+#define PIPELINE_ITERATIONS 20000
+
+static const char* FORMULAS[] = {
+    "x*2+y",
+    "x^2 + 2*x*y + y^2",
+    "sqrt(x^2+y^2) * cos(x) - logbase(2, y+1) / (1 + abs(x-y))",
+};
+
+static double bench_compile(CalcEngine* engine, const char* formula, const char* const* names) {
+    double start = bench_now_ns();
+    for (int i = 0; i < COMPILE_ITERATIONS; i++) {
+        CompiledExpression* expr = compile_expression(engine, formula, names, 2, NULL);
+        compiled_expression_free(expr);
+    }
+    return (bench_now_ns() - start) / COMPILE_ITERATIONS;
+}
+
+static double bench_evaluate(CalcEngine* engine, const char* formula, const char* const* names) {
+    CompiledExpression* expr = compile_expression(engine, formula, names, 2, NULL);
+    if (!expr) return -1;
+
+    double start = bench_now_ns();
+    for (int i = 0; i < EVAL_ITERATIONS; i++) {
+        compiled_expression_set_variable(expr, 0, i * 0.001);
+        compiled_expression_set_variable(expr, 1, 1.0 + i * 0.002);
+        bench_consume(compiled_expression_evaluate(expr).value);
+    }
+    double per_eval = (bench_now_ns() - start) / EVAL_ITERATIONS;
+    compiled_expression_free(expr);
+    return per_eval;
+}
+
+static double bench_full_pipeline(CalcEngine* engine, const char* formula) {
+    double start = bench_now_ns();
+    for (int i = 0; i < PIPELINE_ITERATIONS; i++) {
+        TokenizerResult tokens = tokenizeQuery(engine, formula);
+        TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+        ParseResult* ast = parse_expression(engine, postfix);
+        traversal(ast->root, engine->variables->values);
+        bench_consume(ast->root->token->data.num_value);
+        calc_engine_reset(engine);
+    }
+    return (bench_now_ns() - start) / PIPELINE_ITERATIONS;
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    static const char* names[] = {"x", "y"};
+    hashmapconst_add(engine->variables, "x", 0.5f);
+    hashmapconst_add(engine->variables, "y", 1.5f);
+
+    printf("%-60s %14s %14s %16s\n", "formula", "compile ns", "eval ns/op", "re-parse ns/op");
+    for (size_t i = 0; i < sizeof(FORMULAS) / sizeof(FORMULAS[0]); i++) {
+        printf("%-60s %14.1f %14.1f %16.1f\n", FORMULAS[i],
+               bench_compile(engine, FORMULAS[i], names),
+               bench_evaluate(engine, FORMULAS[i], names),
+               bench_full_pipeline(engine, FORMULAS[i]));
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench_common.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+#include "computation/optimizer.h"
+#include "computation/bytecode.h"
+#include "computation/compiled_expression.h"
+
+#define ITERATIONS 2000000
+
+static const char* VARIABLE_NAMES[] = { "x", "y" };
+
+// Generated-config shapes with a repeated subterm
+static const char* FORMULAS[] = {
+    "x*2 + y",
+    "sqrt(x^2+y^2) + sqrt(x^2+y^2)",
+    "sqrt(x^2+y^2)*cos(x) + sqrt(x^2+y^2)*sin(y) - sqrt(x^2+y^2)/(1+sqrt(x^2+y^2))",
+    "(x+y)^2 + (x+y)^3 + (x+y)^4 + (x+y)*(x-y) + (x-y)^2",
+};
+
+static double time_program(BytecodeProgram* program, const double* values, double* result) {
+    double start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        *result = bytecode_evaluate(program, values);
+        bench_consume(*result);
+    }
+    return (bench_now_ns() - start) / ITERATIONS;
+}
+
+static void bench_formula(CalcEngine* engine, const char* formula) {
+    CompileError error;
+    CompiledExpression* expr = compile_expression(engine, formula, VARIABLE_NAMES, 2, &error);
+    if (!expr) {
+        fprintf(stderr, "failed to compile %s\n", formula);
+        return;
+    }
+    compiled_expression_set_variable(expr, 0, 1.25);
+    compiled_expression_set_variable(expr, 1, -0.75);
+
+    // Same expression compiled from the optimized tree, without sharing
+    calc_engine_reset(engine);
+    TokenizerResult tokens = tokenizeQuerySymbols(engine, formula, expr->symbols);
+    TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+    ParseResult* ast = parse_expression(engine, postfix);
+    ASTNode* tree = optimize_ast(engine->arena, ast->root, NULL);
+    BytecodeProgram* unshared = bytecode_compile(tree, expr->variables, expr->variable_count, NULL);
+    if (!unshared) {
+        fprintf(stderr, "failed to compile the tree of %s\n", formula);
+        compiled_expression_free(expr);
+        return;
+    }
+
+    double tree_value, dag_value;
+    double tree_ns = time_program(unshared, expr->values, &tree_value);
+    double dag_ns = time_program(expr->program, expr->values, &dag_value);
+
+    printf("%-82s %6zu %5zu %5zu %9.1f %9.1f %7.2fx %s\n", formula, expr->merged_nodes,
+           unshared->length, expr->program->length, tree_ns, dag_ns, tree_ns / dag_ns,
+           tree_value == dag_value ? "ok" : "MISMATCH");
+
+    bytecode_free(unshared);
+    compiled_expression_free(expr);
+    calc_engine_reset(engine);
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    printf("%-82s %6s %5s %5s %9s %9s %8s\n", "formula", "merged", "tree", "dag", "tree ns", "dag ns", "speedup");
+    for (size_t i = 0; i < sizeof(FORMULAS) / sizeof(FORMULAS[0]); i++) {
+        bench_formula(engine, FORMULAS[i]);
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
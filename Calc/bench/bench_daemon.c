@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "bench_common.h"
+#include "computation/batch.h"
+#include "computation/stage_stats.h"
+#include "server/daemon.h"
+#include "datastructures/histogram.h"
+
+// Load generator for the daemon. With no arguments it serves from a daemon
+// started in this process; --socket PATH drives one started with calc.out --serve.
+
+#define TOTAL_REQUESTS 60000
+#define FORK_REQUESTS 300
+#define DISTINCT_FORMULAS 1000
+#define MAX_DEPTH 256
+
+typedef struct {
+    const char* path;
+    size_t index;
+    size_t requests;
+    size_t depth;          // Requests kept in flight
+    histogram_t latency;   // ns from sending a request to reading its response
+    size_t mismatches;
+    int error;
+} Client;
+
+static size_t formula_argument(size_t client, size_t request) {
+    return (client * 7919 + request) % DISTINCT_FORMULAS;
+}
+
+static double expected_value(size_t k) {
+    return (double)k * 2 + sqrt((double)k) - 1;
+}
+
+static size_t encode_request(char* out, size_t k) {
+    int length = snprintf(out + CALC_DAEMON_HEADER_BYTES, 64, "%zu*2 + sqrt(%zu) - 1", k, k);
+    out[0] = (char)(length >> 24);
+    out[1] = (char)(length >> 16);
+    out[2] = (char)(length >> 8);
+    out[3] = (char)length;
+    return CALC_DAEMON_HEADER_BYTES + (size_t)length;
+}
+
+static int write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return -1;
+        data += written;
+        length -= (size_t)written;
+    }
+    return 0;
+}
+
+static int read_exact(int fd, char* data, size_t length) {
+    while (length > 0) {
+        ssize_t received = read(fd, data, length);
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) return -1;
+        data += received;
+        length -= (size_t)received;
+    }
+    return 0;
+}
+
+static int connect_to(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void* client_main(void* arg) {
+    Client* client = (Client*)arg;
+    histogram_reset(&client->latency);
+
+    int fd = connect_to(client->path);
+    if (fd < 0) {
+        client->error = 1;
+        return NULL;
+    }
+
+    uint64_t sent_at[MAX_DEPTH];
+    char requests[MAX_DEPTH * 72];
+    char response[CALC_DAEMON_HEADER_BYTES + 64];
+    size_t sent = 0;
+
+    for (size_t received = 0; received < client->requests; received++) {
+        // Top the pipeline up, then wait for the oldest response
+        size_t batch = 0;
+        while (sent < client->requests && sent - received < client->depth) {
+            sent_at[sent % client->depth] = stage_clock_ns();
+            batch += encode_request(requests + batch, formula_argument(client->index, sent));
+            sent++;
+        }
+        if (batch && write_all(fd, requests, batch) != 0) {
+            client->error = 1;
+            break;
+        }
+
+        if (read_exact(fd, response, CALC_DAEMON_HEADER_BYTES) != 0) {
+            client->error = 1;
+            break;
+        }
+        const unsigned char* h = (const unsigned char*)response;
+        size_t length = ((size_t)h[0] << 24) | ((size_t)h[1] << 16) | ((size_t)h[2] << 8) | h[3];
+        if (length == 0 || length >= sizeof(response) - CALC_DAEMON_HEADER_BYTES ||
+            read_exact(fd, response + CALC_DAEMON_HEADER_BYTES, length) != 0) {
+            client->error = 1;
+            break;
+        }
+        histogram_record(&client->latency, stage_clock_ns() - sent_at[received % client->depth]);
+
+        response[CALC_DAEMON_HEADER_BYTES + length] = '\0';
+        double expected = expected_value(formula_argument(client->index, received));
+        double value = strtod(response + CALC_DAEMON_HEADER_BYTES + 1, NULL);
+        if (response[CALC_DAEMON_HEADER_BYTES] != CALC_DAEMON_OK ||
+            fabs(value - expected) > 1e-9 * fmax(1.0, fabs(expected))) {
+            client->mismatches++;
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+static void print_row(const char* clients, size_t depth, double per_second, const histogram_t* latency, const char* check) {
+    printf("%-8s %6zu %12.0f %9.1f %9.1f %9.1f %9.1f %7s\n", clients, depth, per_second,
+           histogram_mean(latency) / 1e3,
+           histogram_percentile(latency, 50.0) / 1e3,
+           histogram_percentile(latency, 99.0) / 1e3,
+           histogram_percentile(latency, 99.9) / 1e3, check);
+}
+
+// Runs one load level: clients connections each keeping depth requests in flight
+static bool run_level(const char* path, size_t clients, size_t depth, Client* pool, histogram_t* latency) {
+    size_t per_client = TOTAL_REQUESTS / clients;
+    pthread_t threads[64];
+
+    double start = bench_now_ns();
+    for (size_t c = 0; c < clients; c++) {
+        pool[c] = (Client){ .path = path, .index = c, .requests = per_client, .depth = depth };
+        pthread_create(&threads[c], NULL, client_main, &pool[c]);
+    }
+    histogram_reset(latency);
+    size_t mismatches = 0;
+    int error = 0;
+    for (size_t c = 0; c < clients; c++) {
+        pthread_join(threads[c], NULL);
+        histogram_merge(latency, &pool[c].latency);
+        mismatches += pool[c].mismatches;
+        error |= pool[c].error;
+    }
+    double seconds = (bench_now_ns() - start) / 1e9;
+
+    char label[24];
+    snprintf(label, sizeof(label), "%zu", clients);
+    const char* check = error ? "FAIL" : mismatches ? "MISMATCH" : "ok";
+    print_row(label, depth, per_client * clients / seconds, latency, check);
+    return !error && !mismatches;
+}
+
+// Today's deployment: a new process, and a new engine, for every request
+static bool run_fork_baseline(histogram_t* latency) {
+    histogram_reset(latency);
+    char expression[64];
+    bool ok = true;
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < FORK_REQUESTS; i++) {
+        size_t k = formula_argument(0, i);
+        snprintf(expression, sizeof(expression), "%zu*2 + sqrt(%zu) - 1", k, k);
+        uint64_t began = stage_clock_ns();
+
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) return false;
+        pid_t child = fork();
+        if (child == 0) {
+            CalcEngine* engine = calc_engine_create();
+            engine->verbosity = CALC_VERBOSITY_QUIET;
+            BatchResult result = evaluate_expression_text(engine, expression);
+            ssize_t written = write(pipe_fds[1], &result.value, sizeof(result.value));
+            _exit(written == sizeof(result.value) ? 0 : 1);
+        }
+        close(pipe_fds[1]);
+        double value = 0;
+        ok = ok && child > 0 && read_exact(pipe_fds[0], (char*)&value, sizeof(value)) == 0 &&
+             fabs(value - expected_value(k)) <= 1e-9 * fmax(1.0, fabs(expected_value(k)));
+        close(pipe_fds[0]);
+        if (child > 0) waitpid(child, NULL, 0);
+
+        histogram_record(latency, stage_clock_ns() - began);
+    }
+    double seconds = (bench_now_ns() - start) / 1e9;
+
+    print_row("fork", 1, FORK_REQUESTS / seconds, latency, ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+static void* serve(void* arg) {
+    calc_daemon_run((CalcDaemon*)arg);
+    return NULL;
+}
+
+int main(int argc, char** argv) {
+    const char* external = NULL;
+    size_t only_depth = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            external = argv[++i];
+        } else if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            only_depth = (size_t)strtoul(argv[++i], NULL, 10);
+            if (only_depth == 0 || only_depth > MAX_DEPTH) only_depth = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--socket PATH] [--pipeline DEPTH]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    histogram_t latency;
+    bool ok = true;
+    printf("%d requests per level, latency in us\n", TOTAL_REQUESTS);
+    printf("%-8s %6s %12s %9s %9s %9s %9s %7s\n", "clients", "depth", "req/sec", "mean", "p50", "p99", "p99.9", "check");
+
+    // Forked before any thread exists, so children never inherit a held lock
+    if (!external) {
+        ok = run_fork_baseline(&latency);
+    }
+
+    CalcEngine* engine = NULL;
+    CalcDaemon* daemon = NULL;
+    pthread_t server;
+    char path[64];
+    if (!external) {
+        engine = bench_init();
+        if (!engine) return 1;
+        snprintf(path, sizeof(path), "/tmp/bench_daemon_%ld.sock", (long)getpid());
+        daemon = calc_daemon_create(engine, path, 0);
+        if (!daemon || pthread_create(&server, NULL, serve, daemon) != 0) {
+            fprintf(stderr, "Failed to start the daemon on %s\n", path);
+            return 1;
+        }
+    }
+
+    static Client pool[64];
+    static const size_t CLIENTS[] = { 1, 4, 16, 64 };
+    static const size_t DEPTHS[] = { 1, 16 };
+    for (size_t d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); d++) {
+        size_t depth = only_depth ? only_depth : DEPTHS[d];
+        for (size_t c = 0; c < sizeof(CLIENTS) / sizeof(CLIENTS[0]); c++) {
+            ok = run_level(external ? external : path, CLIENTS[c], depth, pool, &latency) && ok;
+        }
+        if (only_depth) break;
+    }
+
+    if (daemon) {
+        calc_daemon_stop(daemon);
+        pthread_join(server, NULL);
+        calc_daemon_print(stdout, daemon);
+        calc_daemon_destroy(daemon);
+        bench_shutdown(engine);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "bench_common.h"
+#include "computation/compiled_expression.h"
+#include "computation/jit.h"
+
+#define ITERATIONS 5000000
+#define DIFFERENTIAL_SAMPLES 10000
+
+static const char* VARIABLE_NAMES[] = { "x", "y" };
+
+// Covers every opcode the JIT emits, inline and through libm
+static const char* FORMULAS[] = {
+    "x*2 + y",
+    "-(x - y)^3 / (x + 0.5) + -x",
+    "sqrt(x^2+y^2) * cos(x) - logbase(2, y+1) / (1 + abs(x-y))",
+    "sin(x)*tan(y) + exp(-x) - log10(abs(y)+1) + log2(abs(x)+1) + loge(abs(x*y)+1) + log(abs(y)+2)",
+    "((((x*1.01+0.5)*1.01+0.5)*1.01+0.5)*1.01+y)*((x+y)*(x-y)+x*y)/(x*x+y*y+1)",
+};
+
+// Deterministic inputs spanning negatives, zero and large magnitudes
+static double next_value(unsigned long long* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    double unit = (double)(*state >> 11) / 9007199254740992.0;
+    return (unit - 0.5) * 200.0;
+}
+
+static bool same_result(double a, double b) {
+    return a == b || (isnan(a) && isnan(b));
+}
+
+// Compares the native code with traversal() on the expression's own tree
+static size_t differential_check(CompiledExpression* expr, JitFunction native) {
+    size_t token_bytes = sizeof(Token) * expr->postfix->token_count;
+    Token* pristine = malloc(token_bytes);
+    if (!pristine) return DIFFERENTIAL_SAMPLES;
+    memcpy(pristine, expr->postfix->tokens, token_bytes);
+
+    unsigned long long state = 42;
+    size_t mismatches = 0;
+    for (int sample = 0; sample < DIFFERENTIAL_SAMPLES; sample++) {
+        for (size_t slot = 0; slot < expr->variable_count; slot++) {
+            compiled_expression_set_variable(expr, slot, sample == 0 ? 0.0 : next_value(&state));
+        }
+
+        // traversal() overwrites the tokens it evaluates, so each sample starts from a pristine copy
+        memcpy(expr->postfix->tokens, pristine, token_bytes);
+        traversal(expr->ast->root, expr->symbols->values);
+        double expected = expr->ast->root->token->data.num_value;
+
+        if (!same_result(expected, native(expr->values))) {
+            mismatches++;
+        }
+    }
+
+    memcpy(expr->postfix->tokens, pristine, token_bytes);
+    free(pristine);
+    return mismatches;
+}
+
+static void bench_formula(CalcEngine* engine, const char* formula) {
+    CompileError error;
+    CompiledExpression* expr = compile_expression(engine, formula, VARIABLE_NAMES, 2, &error);
+    if (!expr) {
+        fprintf(stderr, "failed to compile %s\n", formula);
+        return;
+    }
+
+    JitFunction native = compiled_expression_enable_jit(expr);
+    if (!native) {
+        printf("%-60s JIT unavailable\n", formula);
+        compiled_expression_free(expr);
+        return;
+    }
+
+    size_t mismatches = differential_check(expr, native);
+
+    compiled_expression_set_variable(expr, 0, 1.25);
+    compiled_expression_set_variable(expr, 1, -0.75);
+
+    double start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        bench_consume(bytecode_evaluate(expr->program, expr->values));
+    }
+    double vm_ns = (bench_now_ns() - start) / ITERATIONS;
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        bench_consume(native(expr->values));
+    }
+    double jit_ns = (bench_now_ns() - start) / ITERATIONS;
+
+    printf("%-60.60s %6zu %9.1f %9.1f %8.2fx %s\n", formula, expr->program->length, vm_ns, jit_ns,
+           vm_ns / jit_ns, mismatches == 0 ? "ok" : "MISMATCH");
+    if (mismatches) {
+        printf("  %zu of %d samples differ from traversal()\n", mismatches, DIFFERENTIAL_SAMPLES);
+    }
+
+    compiled_expression_free(expr);
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    if (!jit_supported()) {
+        printf("JIT not supported on this platform\n");
+        bench_shutdown(engine);
+        return 0;
+    }
+
+    printf("%-60s %6s %9s %9s %9s\n", "formula", "instr", "vm ns", "jit ns", "speedup");
+    for (size_t i = 0; i < sizeof(FORMULAS) / sizeof(FORMULAS[0]); i++) {
+        bench_formula(engine, FORMULAS[i]);
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+
+// Bytes tokenized per input size, so short and long inputs run for similar times
+#define BYTES_PER_SIZE (64u * 1024u * 1024u)
+
+// Mixes every token class: numbers, operators, unary signs, functions, constants, variables
+static const char FRAGMENT[] = "Sin(x1) * 2.5 + logbase(2, 8) - -3^2 / (PI + 17.25e-1) + ";
+
+static const size_t INPUT_SIZES[] = { 64, 1000, 16 * 1024, 1024 * 1024 };
+
+// Builds an input of roughly size bytes by repeating FRAGMENT and closing with a number
+static char* make_input(size_t size) {
+    size_t fragment_length = strlen(FRAGMENT);
+    char* input = malloc(size + fragment_length + 2);
+    if (!input) return NULL;
+
+    size_t length = 0;
+    while (length + fragment_length < size) {
+        memcpy(input + length, FRAGMENT, fragment_length);
+        length += fragment_length;
+    }
+    input[length++] = '1';
+    input[length] = '\0';
+    return input;
+}
+
+static void bench_size(CalcEngine* engine, size_t size) {
+    char* input = make_input(size);
+    if (!input) {
+        fprintf(stderr, "failed to build a %zu byte input\n", size);
+        return;
+    }
+    size_t length = strlen(input);
+
+    // The first call registers x1 as an unknown variable; later calls only look it up
+    TokenizerResult tokens = tokenizeQuery(engine, input);
+    size_t token_count = tokens.token_count;
+    TokenizerError error = tokens.error;
+    calc_engine_reset(engine);
+    if (error != TOKEN_SUCCESS) {
+        printf("%10zu %10s %12s %14s %14s\n", length, "-", "error", "-", "-");
+        free(input);
+        return;
+    }
+
+    size_t iterations = BYTES_PER_SIZE / length + 1;
+    double start = bench_now_ns();
+    for (size_t i = 0; i < iterations; i++) {
+        tokens = tokenizeQuery(engine, input);
+        bench_consume((double)tokens.token_count);
+        calc_engine_reset(engine);
+    }
+    double elapsed = bench_now_ns() - start;
+
+    double per_call = elapsed / iterations;
+    printf("%10zu %10zu %12.0f %14.1f %14.1f\n", length, token_count, per_call,
+           (double)length * iterations / elapsed * 1e3, (double)token_count * iterations / elapsed * 1e3);
+    free(input);
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    printf("%10s %10s %12s %14s %14s\n", "bytes", "tokens", "ns/call", "MB/sec", "Mtokens/sec");
+    for (size_t i = 0; i < sizeof(INPUT_SIZES) / sizeof(INPUT_SIZES[0]); i++) {
+        bench_size(engine, INPUT_SIZES[i]);
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "bench_common.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+#include "computation/optimizer.h"
+
+#define ITERATIONS 1000000
+
+// Shapes typical of generated configs: unit conversions and identity padding around variables
+static const char* FORMULAS[] = {
+    "pi/180*2*x",
+    "(x*1 + 0) * (2^10 / 1024) + y^1",
+    "sqrt(16)*x + logbase(2, 8)*y - (3*4 - 12) + --z",
+    "x*y + z",
+};
+
+static double time_evaluation(const ASTNode* root, const double* variables, double* value) {
+    double start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        *value = evaluate_ast(root, variables, NULL);
+        bench_consume(*value);
+    }
+    return (bench_now_ns() - start) / ITERATIONS;
+}
+
+static void bench_formula(CalcEngine* engine, hashmapconst_t* symbols, const char* formula) {
+    calc_engine_reset(engine);
+    TokenizerResult tokens = tokenizeQuerySymbols(engine, formula, symbols);
+    TokenizerResult* postfix = tokens.error == TOKEN_SUCCESS ? shunt_yard_algo(engine, &tokens) : NULL;
+    ParseResult* ast = postfix ? parse_expression(engine, postfix) : NULL;
+    if (!ast || ast->error != AST_OK || !ast->root) {
+        fprintf(stderr, "failed to parse %s\n", formula);
+        return;
+    }
+
+    double before_value, after_value;
+    double before_ns = time_evaluation(ast->root, symbols->values, &before_value);
+
+    OptimizeStats stats;
+    ASTNode* optimized = optimize_ast(engine->arena, ast->root, &stats);
+    double after_ns = time_evaluation(optimized, symbols->values, &after_value);
+
+    bool same = before_value == after_value || (isnan(before_value) && isnan(after_value));
+    printf("%-50s %6zu %6zu %12.1f %12.1f %8.2fx %s\n", formula, stats.nodes_before, stats.nodes_after,
+           before_ns, after_ns, before_ns / after_ns, same ? "ok" : "MISMATCH");
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    // Symbols stay variables in the tree instead of being substituted as numbers
+    hashmapconst_t* symbols = hashmapconst_create();
+    if (!symbols) return 1;
+    hashmapconst_add(symbols, "x", 1.5);
+    hashmapconst_add(symbols, "y", -2.25);
+    hashmapconst_add(symbols, "z", 4.0);
+
+    printf("%-50s %6s %6s %12s %12s %9s\n", "formula", "nodes", "after", "eval ns", "folded ns", "speedup");
+    for (size_t i = 0; i < sizeof(FORMULAS) / sizeof(FORMULAS[0]); i++) {
+        bench_formula(engine, symbols, FORMULAS[i]);
+    }
+
+    calc_engine_reset(engine);
+    hashmapconst_destroy(symbols);
+    bench_shutdown(engine);
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+
+#define ITERATIONS 200000
+
+static const char* FORMULAS[] = {
+    "1+2*3",
+    "(1.5+2)*(3-4)/5^2 + 7*8 - 9/3",
+    "2^3^2 - 4*5/6 + 7 - 8*9^2 / (1+2) - 3*4 + 5/6 - 7^2",
+    "sqrt(16)+sin(30)*cos(0.5)-logbase(2, 8)+abs(3-7)+log10(100)+exp(1)",
+};
+
+// Times shunt_yard_algo() + parse_expression() on pre-tokenized input
+static void bench_formula(CalcEngine* engine, const char* formula) {
+    TokenizerResult tokens = tokenizeQuery(engine, formula);
+    if (tokens.error != TOKEN_SUCCESS) {
+        fprintf(stderr, "failed to tokenize %s\n", formula);
+        calc_engine_reset(engine);
+        return;
+    }
+
+    // Keep the infix tokens outside the arena so every iteration can reset it
+    Token* infix = malloc(tokens.token_count * sizeof(Token));
+    memcpy(infix, tokens.tokens, tokens.token_count * sizeof(Token));
+    tokens.tokens = infix;
+    calc_engine_reset(engine);
+
+    double start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+        ParseResult* ast = parse_expression(engine, postfix);
+        bench_consume(ast->root ? 1.0 : 0.0);
+        calc_engine_reset(engine);
+    }
+    double per_parse = (bench_now_ns() - start) / ITERATIONS;
+
+    printf("%-70s %8zu %12.1f %14.0f\n", formula, tokens.token_count, per_parse, 1e9 / per_parse);
+    free(infix);
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    printf("%-70s %8s %12s %14s\n", "formula", "tokens", "parse ns", "parses/sec");
+    for (size_t i = 0; i < sizeof(FORMULAS) / sizeof(FORMULAS[0]); i++) {
+        bench_formula(engine, FORMULAS[i]);
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
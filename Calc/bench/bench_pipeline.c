@@ -0,0 +1,100 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench_common.h"
+#include "computation/batch.h"
+#include "computation/pipeline.h"
+#include "computation/expression_cache.h"
+
+#define EXPRESSION_COUNT 200000
+#define ASSIGNMENT_EVERY 5000
+
+// Distinct formulas with an occasional assignment barrier, so every line is tokenized and parsed
+static char** build_corpus(size_t count) {
+    static const char* templates[] = {
+        "%zu*2+sqrt(%zu) - y",
+        "(%zu+1)*(%zu-3)/7 + sin(y)",
+        "sin(%zu)+cos(%zu)*logbase(2, 8)",
+        "abs(%zu-500)^2 + exp(1) - %zu/3",
+    };
+    char** lines = malloc(count * sizeof(char*));
+    char buffer[128];
+    for (size_t i = 0; i < count; i++) {
+        if (i % ASSIGNMENT_EVERY == ASSIGNMENT_EVERY - 1) {
+            snprintf(buffer, sizeof(buffer), "y = %zu", i % 17);
+        } else {
+            snprintf(buffer, sizeof(buffer), templates[i % 4], i % 997, i % 113);
+        }
+        lines[i] = strdup(buffer);
+    }
+    return lines;
+}
+
+static bool same_results(const BatchResult* expected, const BatchResult* results, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (expected[i].error != results[i].error ||
+            (expected[i].error == COMPUTATION_OK && expected[i].value != results[i].value)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+    // Both sides parse every line; the cache would hide the stages being overlapped
+    expression_cache_set_limit(engine->expression_cache, 0);
+    hashmapconst_intern(engine->variables, "y", 0);
+
+    char** lines = build_corpus(EXPRESSION_COUNT);
+    BatchResult* expected = malloc(EXPRESSION_COUNT * sizeof(BatchResult));
+    BatchResult* results = malloc(EXPRESSION_COUNT * sizeof(BatchResult));
+
+    CalcEngine* serial = calc_engine_clone(engine);
+    double start = bench_now_ns();
+    for (size_t i = 0; i < EXPRESSION_COUNT; i++) {
+        expected[i] = evaluate_expression_text(serial, lines[i]);
+    }
+    double baseline = (bench_now_ns() - start) / 1e9;
+    calc_engine_destroy(serial);
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("%d expressions (an assignment every %d), %ld online CPUs\n", EXPRESSION_COUNT, ASSIGNMENT_EVERY, online);
+    printf("%-10s %14s %10s %8s\n", "depth", "expr/sec", "speedup", "order");
+    printf("%-10s %14.0f %10s %8s\n", "serial", EXPRESSION_COUNT / baseline, "1.00x", "-");
+
+    bool ok = true;
+    static const size_t DEPTHS[] = { 1, 8, 64, 512 };
+    for (size_t d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); d++) {
+        CalcEngine* session = calc_engine_clone(engine);
+        PipelineEvaluator* evaluator = pipeline_evaluator_create(session, DEPTHS[d]);
+        if (!session || !evaluator) return 1;
+
+        start = bench_now_ns();
+        int status = pipeline_evaluate(evaluator, lines, EXPRESSION_COUNT, results);
+        double seconds = (bench_now_ns() - start) / 1e9;
+
+        bool same = status == 0 && same_results(expected, results, EXPRESSION_COUNT);
+        ok = ok && same;
+        char label[16];
+        snprintf(label, sizeof(label), "%zu", DEPTHS[d]);
+        printf("%-10s %14.0f %9.2fx %8s\n", label, EXPRESSION_COUNT / seconds, baseline / seconds,
+               same ? "ok" : "MISMATCH");
+
+        if (d + 1 == sizeof(DEPTHS) / sizeof(DEPTHS[0])) {
+            printf("\n");
+            pipeline_evaluator_print(stdout, evaluator);
+        }
+        pipeline_evaluator_destroy(evaluator);
+        calc_engine_destroy(session);
+    }
+
+    for (size_t i = 0; i < EXPRESSION_COUNT; i++) free(lines[i]);
+    free(lines);
+    free(expected);
+    free(results);
+    bench_shutdown(engine);
+    return ok ? 0 : 1;
+}
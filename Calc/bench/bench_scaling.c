@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench_common.h"
+#include "computation/batch.h"
+
+#define EXPRESSION_COUNT 200000
+
+static char** build_corpus(size_t count) {
+    static const char* templates[] = {
+        "%zu*2+sqrt(%zu)",
+        "(%zu+1)*(%zu-3)/7",
+        "sin(%zu)+cos(%zu)*logbase(2, 8)",
+        "abs(%zu-500)^2 + exp(1) - %zu/3",
+    };
+    char** lines = malloc(count * sizeof(char*));
+    char buffer[128];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(buffer, sizeof(buffer), templates[i % 4], i % 997, i % 113);
+        lines[i] = strdup(buffer);
+    }
+    return lines;
+}
+
+static double run_with_threads(CalcEngine* engine, size_t threads, char** lines, BatchResult* results) {
+    BatchEvaluator* evaluator = batch_evaluator_create(engine, threads);
+    if (!evaluator) return -1;
+
+    double start = bench_now_ns();
+    batch_evaluate(evaluator, lines, EXPRESSION_COUNT, results);
+    double seconds = (bench_now_ns() - start) / 1e9;
+
+    batch_evaluator_destroy(evaluator);
+    return seconds;
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    char** lines = build_corpus(EXPRESSION_COUNT);
+    BatchResult* expected = malloc(EXPRESSION_COUNT * sizeof(BatchResult));
+    BatchResult* results = malloc(EXPRESSION_COUNT * sizeof(BatchResult));
+
+    double start = bench_now_ns();
+    for (size_t i = 0; i < EXPRESSION_COUNT; i++) {
+        expected[i] = evaluate_expression_text(engine, lines[i]);
+    }
+    double baseline = (bench_now_ns() - start) / 1e9;
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t counts[] = {1, 2, 4, 8, online > 0 ? (size_t)online : 1};
+
+    printf("%zu expressions, %ld online CPUs\n", (size_t)EXPRESSION_COUNT, online);
+    printf("%-10s %14s %10s %12s %8s\n", "threads", "expr/sec", "speedup", "efficiency", "order");
+    printf("%-10s %14.0f %10s %12s %8s\n", "serial", EXPRESSION_COUNT / baseline, "1.00x", "-", "-");
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        double seconds = run_with_threads(engine, counts[c], lines, results);
+        bool ordered = true;
+        for (size_t i = 0; i < EXPRESSION_COUNT; i++) {
+            if (results[i].error != expected[i].error || results[i].value != expected[i].value) {
+                ordered = false;
+                break;
+            }
+        }
+        double speedup = baseline / seconds;
+        printf("%-10zu %14.0f %9.2fx %11.0f%% %8s\n", counts[c], EXPRESSION_COUNT / seconds,
+               speedup, 100.0 * speedup / counts[c], ordered ? "ok" : "MISMATCH");
+    }
+
+    for (size_t i = 0; i < EXPRESSION_COUNT; i++) free(lines[i]);
+    free(lines);
+    free(expected);
+    free(results);
+    bench_shutdown(engine);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bench_common.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+#include "computation/result_sink.h"
+#include "datastructures/histogram.h"
+
+#define EVALUATIONS 200000
+#define LEGACY_EVALUATIONS 20000
+#define FORMULA "x*2 + sqrt(x) - 1"
+
+typedef enum { RUN_NO_SINK, RUN_LEGACY, RUN_SINK } RunKind;
+
+static size_t count_lines(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) return 0;
+    size_t lines = 0;
+    for (int c; (c = fgetc(file)) != EOF;) {
+        if (c == '\n') lines++;
+    }
+    fclose(file);
+    return lines;
+}
+
+// Times compute_ast() call by call; RUN_LEGACY adds the open/write/close it used to do
+static void run(CalcEngine* engine, ParseResult* ast, RunKind kind, const char* path, size_t evaluations,
+                histogram_t* latency) {
+    unsigned int x = hashmapconst_get_entry(engine->variables, "x")->slot;
+    histogram_reset(latency);
+    for (size_t i = 0; i < evaluations; i++) {
+        engine->variables->values[x] = (double)i;
+        uint64_t start = stage_clock_ns();
+        ComputationResult result = compute_ast(engine, ast);
+        if (kind == RUN_LEGACY) {
+            FILE* file = fopen(path, "w");
+            fprintf(file, "%f\n", result.value);
+            fclose(file);
+        }
+        histogram_record(latency, stage_clock_ns() - start);
+    }
+}
+
+static void print_row(const char* name, const histogram_t* latency, const char* check) {
+    printf("%-10s %9.0f %9llu %9llu %9llu %9s\n", name, histogram_mean(latency),
+           (unsigned long long)histogram_percentile(latency, 50.0),
+           (unsigned long long)histogram_percentile(latency, 99.0),
+           (unsigned long long)histogram_percentile(latency, 99.9), check);
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    char path[] = "/tmp/bench_sink_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return 1;
+    close(fd);
+
+    TokenizerResult tokens = tokenizeQuery(engine, FORMULA);
+    ParseResult* ast = parse_expression(engine, shunt_yard_algo(engine, &tokens));
+    if (!ast || ast->error != AST_OK) return 1;
+
+    histogram_t latency;
+    bool ok = true;
+    printf("compute_ast(\"%s\") latency in ns\n", FORMULA);
+    printf("%-10s %9s %9s %9s %9s %9s\n", "sink", "mean", "p50", "p99", "p99.9", "lines");
+
+    run(engine, ast, RUN_NO_SINK, path, EVALUATIONS, &latency);
+    print_row("none", &latency, "-");
+
+    run(engine, ast, RUN_LEGACY, path, LEGACY_EVALUATIONS, &latency);
+    print_row("legacy", &latency, "-");
+
+    static const ResultSinkMode MODES[] = { RESULT_SINK_DISABLED, RESULT_SINK_BUFFERED, RESULT_SINK_ASYNC };
+    static const char* NAMES[] = { "off", "buffered", "async" };
+    for (size_t m = 0; m < sizeof(MODES) / sizeof(MODES[0]); m++) {
+        remove(path);
+        engine->result_sink = result_sink_open(MODES[m], path);
+        if (!engine->result_sink) return 1;
+        run(engine, ast, RUN_SINK, path, EVALUATIONS, &latency);
+        size_t stalls = engine->result_sink->stalls;
+        if (result_sink_close(engine->result_sink) != 0) ok = false;
+        engine->result_sink = NULL;
+
+        // Every result must reach the file once the sink is closed
+        size_t lines = MODES[m] == RESULT_SINK_DISABLED ? 0 : count_lines(path);
+        bool complete = MODES[m] == RESULT_SINK_DISABLED || lines == EVALUATIONS;
+        ok = ok && complete;
+        char check[32];
+        snprintf(check, sizeof(check), "%s", complete ? (MODES[m] == RESULT_SINK_DISABLED ? "-" : "ok") : "LOST");
+        print_row(NAMES[m], &latency, check);
+        if (stalls) printf("%-10s %zu writes waited on a full ring\n", "", stalls);
+    }
+
+    remove(path);
+    bench_shutdown(engine);
+    return ok ? 0 : 1;
+}
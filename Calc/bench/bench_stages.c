@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench_common.h"
+#include "bench_alloc_count.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+#include "computation/optimizer.h"
+
+// Every measurement is repeated and the median reported, so reruns agree
+#define REPEATS 5
+#define WARMUP_ITERATIONS 50
+// Iterations shrink with expression size so each measurement takes similar time
+#define WORK_PER_MEASUREMENT 100000
+#define MIN_ITERATIONS 100
+#define MAX_ITERATIONS 10000
+
+#define DEEP_LEVELS 40
+#define LONG_TERMS 60
+
+typedef struct {
+    const char* name;
+    const char* category;
+    char text[2048];
+} CorpusEntry;
+
+typedef enum {
+    STAGE_TOKENIZE,
+    STAGE_SHUNT_YARD,
+    STAGE_PARSE,
+    STAGE_COMPUTE,
+    STAGE_PIPELINE,
+    STAGE_COUNT
+} Stage;
+
+static const char* STAGE_NAMES[STAGE_COUNT] = {
+    "tokenizeQuery", "shunt_yard_algo", "parse_expression", "compute_ast", "pipeline"
+};
+
+typedef struct {
+    size_t iterations;
+    double ns_per_op;
+    double allocs_per_op;
+} Measurement;
+
+// Inputs the stages see on every iteration, kept outside the engine arena
+typedef struct {
+    const char* text;
+    TokenizerResult infix;      // Heap copy of tokenizeQuery's output
+    TokenizerResult postfix;    // Heap copy of shunt_yard_algo's output
+} StageInput;
+
+static void build_corpus(CorpusEntry* corpus, size_t* count) {
+    size_t n = 0;
+
+    corpus[n++] = (CorpusEntry){ "short", "short", "1+2*3" };
+    corpus[n++] = (CorpusEntry){ "constants", "short", "2*pi - e/3" };
+
+    CorpusEntry* entry = &corpus[n++];
+    *entry = (CorpusEntry){ "long", "long", "" };
+    size_t len = 0;
+    for (int i = 0; i < LONG_TERMS; i++) {
+        len += snprintf(entry->text + len, sizeof(entry->text) - len, "%s%d.25*%d", i ? (i % 2 ? " + " : " - ") : "", i + 1, i % 7 + 2);
+    }
+
+    entry = &corpus[n++];
+    *entry = (CorpusEntry){ "deep", "deeply nested", "" };
+    len = 0;
+    for (int i = 0; i < DEEP_LEVELS; i++) entry->text[len++] = '(';
+    len += snprintf(entry->text + len, sizeof(entry->text) - len, "1.5");
+    for (int i = 0; i < DEEP_LEVELS; i++) {
+        len += snprintf(entry->text + len, sizeof(entry->text) - len, "*1.01+0.5)");
+    }
+
+    corpus[n++] = (CorpusEntry){ "functions", "function-heavy",
+        "sqrt(16)+sin(30)*cos(0.5)-logbase(2, 8)+abs(3-7)+log10(100)+exp(1)+tan(0.3)+log2(64)" };
+    corpus[n++] = (CorpusEntry){ "variables", "variable-heavy",
+        "a*b + c*d - e/f + g^h - a*c + b*d - e*g + f/h" };
+
+    *count = n;
+}
+
+static size_t iterations_for(size_t token_count) {
+    size_t iterations = WORK_PER_MEASUREMENT / (token_count + 4);
+    if (iterations < MIN_ITERATIONS) return MIN_ITERATIONS;
+    if (iterations > MAX_ITERATIONS) return MAX_ITERATIONS;
+    return iterations;
+}
+
+static Token* copy_tokens(const Token* tokens, size_t count) {
+    Token* copy = malloc(count * sizeof(Token) + 1);
+    if (copy) memcpy(copy, tokens, count * sizeof(Token));
+    return copy;
+}
+
+static bool prepare_input(CalcEngine* engine, const char* text, StageInput* input) {
+    input->text = text;
+
+    calc_engine_reset(engine);
+    TokenizerResult tokens = tokenizeQuery(engine, text);
+    TokenizerResult* postfix = tokens.error == TOKEN_SUCCESS ? shunt_yard_algo(engine, &tokens) : NULL;
+    if (!postfix || postfix->error != TOKEN_SUCCESS) return false;
+
+    input->infix = tokens;
+    input->infix.tokens = copy_tokens(tokens.tokens, tokens.token_count);
+    input->postfix = *postfix;
+    input->postfix.tokens = copy_tokens(postfix->tokens, postfix->token_count);
+    calc_engine_reset(engine);
+    return input->infix.tokens && input->postfix.tokens;
+}
+
+static double run_pipeline(CalcEngine* engine, const char* text) {
+    calc_engine_reset(engine);
+    TokenizerResult tokens = tokenizeQuery(engine, text);
+    TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+    ParseResult* ast = parse_expression(engine, postfix);
+    optimize_parse_result(engine, ast);
+    return compute_ast(engine, ast).value;
+}
+
+// Runs one stage iterations times; only the stage itself sits inside the loop
+static void run_stage(CalcEngine* engine, Stage stage, StageInput* input, size_t iterations) {
+    switch (stage) {
+        case STAGE_TOKENIZE:
+            for (size_t i = 0; i < iterations; i++) {
+                bench_consume((double)tokenizeQuery(engine, input->text).token_count);
+                calc_engine_reset(engine);
+            }
+            break;
+        case STAGE_SHUNT_YARD:
+            for (size_t i = 0; i < iterations; i++) {
+                bench_consume((double)shunt_yard_algo(engine, &input->infix)->token_count);
+                calc_engine_reset(engine);
+            }
+            break;
+        case STAGE_PARSE:
+            for (size_t i = 0; i < iterations; i++) {
+                bench_consume(parse_expression(engine, &input->postfix)->root ? 1.0 : 0.0);
+                calc_engine_reset(engine);
+            }
+            break;
+        case STAGE_COMPUTE: {
+            // compute_ast() leaves the tree intact, so one tree serves every iteration
+            ParseResult* ast = parse_expression(engine, &input->postfix);
+            for (size_t i = 0; i < iterations; i++) {
+                bench_consume(compute_ast(engine, ast).value);
+            }
+            calc_engine_reset(engine);
+            break;
+        }
+        case STAGE_PIPELINE:
+            for (size_t i = 0; i < iterations; i++) {
+                bench_consume(run_pipeline(engine, input->text));
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static Measurement measure(CalcEngine* engine, Stage stage, StageInput* input) {
+    Measurement m = { iterations_for(input->infix.token_count), 0.0, 0.0 };
+    double samples[REPEATS];
+
+    run_stage(engine, stage, input, WARMUP_ITERATIONS);
+
+    size_t allocations = 0;
+    for (int r = 0; r < REPEATS; r++) {
+        size_t before = allocation_count;
+        double start = bench_now_ns();
+        run_stage(engine, stage, input, m.iterations);
+        samples[r] = (bench_now_ns() - start) / (double)m.iterations;
+        allocations += allocation_count - before;
+    }
+
+    qsort(samples, REPEATS, sizeof(double), compare_doubles);
+    m.ns_per_op = samples[REPEATS / 2];
+    m.allocs_per_op = (double)allocations / (double)(m.iterations * REPEATS);
+    return m;
+}
+
+static void json_string(FILE* out, const char* text) {
+    fputc('"', out);
+    for (const char* p = text; *p; p++) {
+        if (*p == '"' || *p == '\\') fputc('\\', out);
+        fputc(*p, out);
+    }
+    fputc('"', out);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--json FILE]\n", program);
+    fprintf(stderr, "  --json FILE   Also write the results as JSON to FILE (- for stdout)\n");
+}
+
+int main(int argc, char** argv) {
+    const char* json_path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    // Values for the variable-heavy entries, so they compute finite results
+    const char* names = "abcdefgh";
+    for (size_t i = 0; names[i]; i++) {
+        char name[2] = { names[i], '\0' };
+        hashmapconst_add(engine->variables, name, 1.5 + (double)i);
+    }
+
+    static CorpusEntry corpus[16];
+    size_t corpus_count = 0;
+    build_corpus(corpus, &corpus_count);
+
+    static Measurement results[16][STAGE_COUNT];
+    static size_t token_counts[16];
+    bool ok[16] = { false };
+
+    printf("%-12s %-16s %7s %-17s %10s %12s %10s\n", "expression", "category", "tokens", "stage", "ns/op", "ops/sec", "allocs/op");
+    for (size_t c = 0; c < corpus_count; c++) {
+        StageInput input = {0};
+        ok[c] = prepare_input(engine, corpus[c].text, &input);
+        if (!ok[c]) {
+            fprintf(stderr, "failed to prepare %s\n", corpus[c].name);
+            free(input.infix.tokens);
+            free(input.postfix.tokens);
+            continue;
+        }
+        token_counts[c] = input.infix.token_count;
+
+        for (int s = 0; s < STAGE_COUNT; s++) {
+            Measurement m = measure(engine, (Stage)s, &input);
+            results[c][s] = m;
+            printf("%-12s %-16s %7zu %-17s %10.1f %12.0f %10.2f\n", corpus[c].name, corpus[c].category,
+                   token_counts[c], STAGE_NAMES[s], m.ns_per_op, 1e9 / m.ns_per_op, m.allocs_per_op);
+        }
+
+        free(input.infix.tokens);
+        free(input.postfix.tokens);
+    }
+
+    if (json_path) {
+        FILE* out = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+        if (!out) {
+            perror(json_path);
+            bench_shutdown(engine);
+            return 1;
+        }
+
+        fprintf(out, "{\n  \"benchmark\": \"stages\",\n  \"repeats\": %d,\n  \"results\": [", REPEATS);
+        bool first = true;
+        for (size_t c = 0; c < corpus_count; c++) {
+            if (!ok[c]) continue;
+            for (int s = 0; s < STAGE_COUNT; s++) {
+                const Measurement* m = &results[c][s];
+                fprintf(out, "%s\n    {\"expression\": ", first ? "" : ",");
+                json_string(out, corpus[c].name);
+                fprintf(out, ", \"category\": ");
+                json_string(out, corpus[c].category);
+                fprintf(out, ", \"text\": ");
+                json_string(out, corpus[c].text);
+                fprintf(out, ", \"tokens\": %zu, \"stage\": \"%s\", \"iterations\": %zu, "
+                             "\"ns_per_op\": %.1f, \"ops_per_sec\": %.0f, \"allocs_per_op\": %.2f}",
+                        token_counts[c], STAGE_NAMES[s], m->iterations, m->ns_per_op, 1e9 / m->ns_per_op, m->allocs_per_op);
+                first = false;
+            }
+        }
+        fprintf(out, "\n  ]\n}\n");
+        if (out != stdout) fclose(out);
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench_common.h"
+#include "computation/versioned_variables.h"
+
+#define RUN_MS 300
+#define WRITE_PAUSE_US 20
+#define MAX_THREADS 8
+
+// Every write sets a = k and b = -k together, so both formulas are 0 in any consistent state
+static const char* FORMULAS[] = { "a + b", "(a + b) * 3 + sqrt(c) - sqrt(c)" };
+
+typedef enum { MODE_SNAPSHOT, MODE_RWLOCK } Mode;
+
+typedef struct {
+    Mode mode;
+    VersionedVariables* versions;
+    pthread_rwlock_t lock;         // MODE_RWLOCK: guards shared
+    hashmapconst_t* shared;        // MODE_RWLOCK: the one table, updated in place
+    atomic_bool stop;
+} Shared;
+
+typedef struct {
+    Shared* shared;
+    CalcEngine* engine;
+    size_t operations;
+    size_t torn;                   // Reads that mixed two versions (or failed)
+} Worker;
+
+static BatchResult read_rwlock(Shared* shared, CalcEngine* engine, hashmapconst_t* unknown, const char* formula) {
+    pthread_rwlock_rdlock(&shared->lock);
+    VariableSnapshot view = { shared->shared, 0, 0, NULL };
+    BatchResult result = variable_snapshot_evaluate(engine, &view, unknown, formula);
+    pthread_rwlock_unlock(&shared->lock);
+    return result;
+}
+
+static void* reader_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Shared* shared = worker->shared;
+    int reader = shared->mode == MODE_SNAPSHOT ? versioned_variables_register_reader(shared->versions) : -1;
+    hashmapconst_t* unknown = hashmapconst_create();
+
+    for (size_t i = 0; !atomic_load_explicit(&shared->stop, memory_order_relaxed); i++) {
+        const char* formula = FORMULAS[i % 2];
+        BatchResult result = shared->mode == MODE_SNAPSHOT
+            ? versioned_variables_evaluate(shared->versions, reader, worker->engine, formula)
+            : read_rwlock(shared, worker->engine, unknown, formula);
+        if (result.error != COMPUTATION_OK || result.value != 0) worker->torn++;
+        worker->operations++;
+    }
+
+    if (reader >= 0) versioned_variables_unregister_reader(shared->versions, reader);
+    hashmapconst_destroy(unknown);
+    return NULL;
+}
+
+static void* writer_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+    Shared* shared = worker->shared;
+    struct timespec pause = { 0, WRITE_PAUSE_US * 1000L };
+
+    for (double k = 1; !atomic_load_explicit(&shared->stop, memory_order_relaxed); k++) {
+        if (shared->mode == MODE_SNAPSHOT) {
+            hashmapconst_t* copy = versioned_variables_begin_write(shared->versions);
+            if (!copy) break;
+            hashmapconst_update(copy, "a", k);
+            hashmapconst_update(copy, "b", -k);
+            versioned_variables_commit(shared->versions, copy);
+        } else {
+            pthread_rwlock_wrlock(&shared->lock);
+            hashmapconst_update(shared->shared, "a", k);
+            hashmapconst_update(shared->shared, "b", -k);
+            pthread_rwlock_unlock(&shared->lock);
+        }
+        worker->operations++;
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+static bool run(Mode mode, CalcEngine* engine, int readers, size_t* reclaimed) {
+    Shared shared = { .mode = mode };
+    atomic_init(&shared.stop, false);
+    shared.versions = versioned_variables_create(engine->variables);
+    shared.shared = hashmapconst_clone(engine->variables);
+    pthread_rwlock_init(&shared.lock, NULL);
+
+    Worker workers[MAX_THREADS + 1] = {0};
+    pthread_t threads[MAX_THREADS + 1];
+    for (int i = 0; i <= readers; i++) {
+        workers[i].shared = &shared;
+        workers[i].engine = calc_engine_clone(engine);
+    }
+
+    double start = bench_now_ns();
+    pthread_create(&threads[0], NULL, writer_main, &workers[0]);
+    for (int i = 1; i <= readers; i++) {
+        pthread_create(&threads[i], NULL, reader_main, &workers[i]);
+    }
+    usleep(RUN_MS * 1000);
+    atomic_store(&shared.stop, true);
+    for (int i = 0; i <= readers; i++) pthread_join(threads[i], NULL);
+    double seconds = (bench_now_ns() - start) / 1e9;
+
+    size_t reads = 0, torn = 0;
+    for (int i = 1; i <= readers; i++) {
+        reads += workers[i].operations;
+        torn += workers[i].torn;
+    }
+
+    // With every reader gone, one more write frees all the retired snapshots
+    bool drained = true;
+    if (mode == MODE_SNAPSHOT) {
+        versioned_variables_assign(shared.versions, "c", 4);
+        drained = shared.versions->retired_count == 0;
+        *reclaimed = shared.versions->reclaimed;
+    }
+
+    printf("%-9s %8d %14.0f %12.0f %8zu %10s\n", mode == MODE_SNAPSHOT ? "snapshot" : "rwlock",
+           readers, reads / seconds, workers[0].operations / seconds, torn,
+           torn == 0 && drained ? "ok" : "FAIL");
+
+    for (int i = 0; i <= readers; i++) calc_engine_destroy(workers[i].engine);
+    pthread_rwlock_destroy(&shared.lock);
+    hashmapconst_destroy(shared.shared);
+    versioned_variables_destroy(shared.versions);
+    return torn == 0 && drained;
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+    hashmapconst_intern(engine->variables, "a", 0);
+    hashmapconst_intern(engine->variables, "b", 0);
+    hashmapconst_intern(engine->variables, "c", 9);
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("One writer publishing a=k, b=-k every %d us; readers evaluate \"%s\" and \"%s\" (%ld online CPUs)\n",
+           WRITE_PAUSE_US, FORMULAS[0], FORMULAS[1], online);
+    printf("%-9s %8s %14s %12s %8s %10s\n", "mode", "readers", "reads/sec", "writes/sec", "torn", "check");
+
+    bool ok = true;
+    static const int READERS[] = { 1, 2, 4, 8 };
+    size_t reclaimed = 0, total_reclaimed = 0;
+    for (size_t r = 0; r < sizeof(READERS) / sizeof(READERS[0]); r++) {
+        ok = run(MODE_SNAPSHOT, engine, READERS[r], &reclaimed) && ok;
+        total_reclaimed += reclaimed;
+        ok = run(MODE_RWLOCK, engine, READERS[r], &reclaimed) && ok;
+    }
+    printf("Snapshots reclaimed across snapshot runs: %zu\n", total_reclaimed);
+
+    bench_shutdown(engine);
+    return ok ? 0 : 1;
+}
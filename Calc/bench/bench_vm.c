@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "bench_common.h"
+#include "computation/bytecode.h"
+#include "computation/shunt_yard_algo.h"
+#include "computation/AST_tree.h"
+
+#define ITERATIONS 500000
+#define DEEP_TERMS 60
+
+typedef struct {
+    const char* name;
+    char text[1024];
+} Case;
+
+static void build_deep(char* out, size_t size) {
+    // ((((1.5*1.01+0.5)*1.01+0.5)*1.01+0.5)...) nested DEEP_TERMS levels
+    size_t len = 0;
+    for (int i = 0; i < DEEP_TERMS && len < size - 1; i++) out[len++] = '(';
+    len += snprintf(out + len, size - len, "1.5");
+    for (int i = 0; i < DEEP_TERMS && len < size - 16; i++) {
+        len += snprintf(out + len, size - len, "*1.01+0.5)");
+    }
+}
+
+static void bench_case(CalcEngine* engine, const Case* c) {
+    TokenizerResult tokens = tokenizeQuery(engine, c->text);
+    TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+    ParseResult* ast = parse_expression(engine, postfix);
+    if (!ast || ast->error != AST_OK) {
+        fprintf(stderr, "failed to parse %s\n", c->name);
+        return;
+    }
+
+    BytecodeProgram* program = bytecode_compile(ast->root, NULL, 0, NULL);
+    size_t token_bytes = sizeof(Token) * postfix->token_count;
+    Token* pristine = malloc(token_bytes);
+    memcpy(pristine, postfix->tokens, token_bytes);
+
+    ComputationError error = COMPUTATION_OK;
+    double expected = evaluate_ast(ast->root, engine->variables->values, &error);
+    double vm_value = bytecode_evaluate(program, NULL);
+
+    // traversal() destroys the tree, so each iteration restores the tokens first
+    double start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        memcpy(postfix->tokens, pristine, token_bytes);
+        traversal(ast->root, engine->variables->values);
+        bench_consume(ast->root->token->data.num_value);
+    }
+    double traversal_ns = (bench_now_ns() - start) / ITERATIONS;
+    memcpy(postfix->tokens, pristine, token_bytes);
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        bench_consume(evaluate_ast(ast->root, engine->variables->values, NULL));
+    }
+    double walker_ns = (bench_now_ns() - start) / ITERATIONS;
+
+    start = bench_now_ns();
+    for (int i = 0; i < ITERATIONS; i++) {
+        bench_consume(bytecode_evaluate(program, NULL));
+    }
+    double vm_ns = (bench_now_ns() - start) / ITERATIONS;
+
+    printf("%-10s %6zu %14.1f %14.1f %10.1f %8.2fx %s\n", c->name, program->length,
+           traversal_ns, walker_ns, vm_ns, traversal_ns / vm_ns,
+           (expected == vm_value || (isnan(expected) && isnan(vm_value))) ? "ok" : "MISMATCH");
+
+    free(pristine);
+    bytecode_free(program);
+    calc_engine_reset(engine);
+}
+
+int main(void) {
+    CalcEngine* engine = bench_init();
+    if (!engine) return 1;
+
+    static Case cases[] = {
+        {"shallow", "1.5*2+3"},
+        {"medium", "(1.5+2)*(3-4)/5^2 + 7*8 - 9/3"},
+        {"functions", "sqrt(16)+sin(30)*cos(0.5)-logbase(2, 8)+abs(3-7)+log10(100)+exp(1)"},
+        {"deep", ""},
+    };
+    build_deep(cases[3].text, sizeof(cases[3].text));
+
+    printf("%-10s %6s %14s %14s %10s %9s\n", "case", "ops", "traversal ns", "evaluate ns", "vm ns", "speedup");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        bench_case(engine, &cases[i]);
+    }
+
+    bench_shutdown(engine);
+    return 0;
+}
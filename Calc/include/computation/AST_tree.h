@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "datastructures/hashset.h"
+#include "datastructures/arena.h"
 
 // Debug logging macro
 #define LOGS(fmt, ...) fprintf(stderr, "[%s:%d] " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__)
@@ -58,31 +59,33 @@ typedef struct {
 
 /**
  * @brief Stack structure for AST construction
- * @future Add overflow protection and dynamic resizing
+ * @future Add overflow protection
  */
 typedef struct ASTStack {
     ASTNode** nodes;   // Array of node pointers
     size_t capacity;   // Maximum capacity
     size_t size;       // Current size
+    arena_t* arena;    // Arena the stack and its growth are allocated from
 } ASTStack;
 
 // Function declarations
 
 /**
  * @brief Creates a new AST node from a token
+ * @param arena Arena that owns the node until it is reset
  * @param token The token to create the node from
  * @return ASTResult containing the created node or error information
- * @future Add memory pool allocation for better performance
  */
-ASTResult ast_create_node(Token* token);
+ASTResult ast_create_node(arena_t* arena, Token* token);
 
 /**
  * @brief Creates a new stack for AST construction
+ * @param arena Arena that owns the stack until it is reset
  * @param initial_capacity Initial size of the stack
  * @return Pointer to created stack or NULL if allocation fails
  * @future Add error reporting mechanism
  */
-ASTStack* ast_create_stack(size_t initial_capacity);
+ASTStack* ast_create_stack(arena_t* arena, size_t initial_capacity);
 
 /**
  * @brief Pushes a node onto the stack
@@ -109,20 +112,6 @@ ASTNode* ast_pop(ASTStack* stack);
  */
 ASTResult ast_peek(ASTStack* stack);
 
-/**
- * @brief Frees an AST node and all its children
- * @param node Pointer to the node pointer to free
- * @future Add memory leak detection
- */
-void ast_free_node(ASTNode** node);
-
-/**
- * @brief Frees a stack and all its contents
- * @param stack The stack to free
- * @future Add cleanup verification
- */
-void ast_free_stack(ASTStack* stack);
-
 /**
  * @brief Sets the left child of a node
  * @param parent Parent node
@@ -177,31 +166,39 @@ void print_tree(ParseResult* result);
 
 /**
  * @brief Parses a token stream into an AST
+ * @param engine Engine whose function registry gives each function's argument count
  * @param tokens Token stream to parse
- * @return Parse result containing AST or error information
+ * @return Parse result containing AST or error information, or NULL if the
+ *         arena is exhausted; the result and its nodes live in the engine's
+ *         arena until calc_engine_reset()
  * @future Add recovery mechanisms for syntax errors
  */
-ParseResult* parse_expression(const TokenizerResult* tokens);
+ParseResult* parse_expression(const CalcEngine* engine, const TokenizerResult* tokens);
 
 /**
- * @brief Prints just the value of a node's token
- * @param node Node whose token to print
- * @future Add formatting options
+ * @brief Counts the nodes of a tree
+ * @param node Root of the tree (may be NULL)
+ * @return Number of nodes reachable through left, right and child
  */
-void print_token_just_val(ASTNode* node);
+size_t ast_count_nodes(const ASTNode* node);
 
 /**
- * @brief Initializes the set of supported functions
- * @return Initialized hashset of supported functions
- * @future Add configuration file support
+ * @brief Copies a tree and its tokens into caller-provided storage
+ * @param node Root of the tree to copy (may be NULL)
+ * @param nodes Room for ast_count_nodes(node) nodes
+ * @param tokens Room for as many tokens, one per copied node
+ * @return Root of the copy, which stays valid as long as nodes and tokens do
+ *
+ * Used to keep a tree past calc_engine_reset(); the tokens still point at the
+ * same variable entries and function table rows.
  */
-hashset_t* init_SUPPORTED_FUNCTIONS_();
+ASTNode* ast_copy_tree(const ASTNode* node, ASTNode* nodes, Token* tokens);
 
 /**
- * @brief Cleans up an AST and frees all associated memory
- * @param ast_root Root of the AST to clean up
- * @future Add memory leak detection
+ * @brief Prints just the value of a node's token
+ * @param node Node whose token to print
+ * @future Add formatting options
  */
-void cleanup_ast(ParseResult* ast_root);
+void print_token_just_val(ASTNode* node);
 
 #endif // AST_TREE_H
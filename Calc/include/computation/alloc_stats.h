@@ -0,0 +1,101 @@
+#ifndef ALLOC_STATS_H
+#define ALLOC_STATS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "stage_stats.h"
+
+// Index of the counters for allocations made outside every pipeline stage
+#define ALLOC_STAGE_OTHER CALC_STAGE_COUNT
+
+/**
+ * @brief Heap activity attributed to one pipeline stage
+ */
+typedef struct {
+    size_t allocations;      // malloc/calloc/realloc/strdup calls that returned memory
+    size_t frees;            // calc_free calls
+    size_t bytes;            // Bytes requested
+    size_t peak_live_bytes;  // Highest live heap usage seen while the stage was running
+} AllocCounters;
+
+/**
+ * @brief Snapshot of the counting allocator
+ */
+typedef struct {
+    AllocCounters stages[CALC_STAGE_COUNT + 1];  // Per stage, then ALLOC_STAGE_OTHER
+    size_t live_bytes;                           // Bytes currently allocated
+    size_t peak_live_bytes;                      // Highest live_bytes since the last reset
+    size_t unexpected;                           // Allocations made while forbidden
+} AllocReport;
+
+// Stage the calling thread is in, set by the stage entry points
+extern _Thread_local int alloc_stats_stage;
+
+/**
+ * @brief Attributes the calling thread's allocations to a stage
+ * @param stage Stage being entered (a CalcStage or ALLOC_STAGE_OTHER)
+ * @return The previous stage, to pass to alloc_stats_leave_stage()
+ */
+static inline int alloc_stats_enter_stage(int stage) {
+    int previous = alloc_stats_stage;
+    alloc_stats_stage = stage;
+    return previous;
+}
+
+/**
+ * @brief Restores the stage that was current before alloc_stats_enter_stage()
+ * @param previous Value returned by alloc_stats_enter_stage()
+ */
+static inline void alloc_stats_leave_stage(int previous) {
+    alloc_stats_stage = previous;
+}
+
+/**
+ * @brief Installs the counting allocator for the whole library
+ *
+ * The counting allocator forwards to the C library allocator it replaces and
+ * sizes blocks with malloc_usable_size(), so it can be enabled and disabled at
+ * any time, even while blocks from the C library allocator are live. Blocks of
+ * a custom allocator cannot be sized that way, so it refuses to replace one
+ * installed with calc_set_allocator(). Counters are atomic, so worker threads
+ * may allocate concurrently.
+ *
+ * @return 0 on success (or when already enabled), -1 when a custom allocator is installed
+ */
+int alloc_stats_enable(void);
+
+/**
+ * @brief Restores the allocator that was installed before alloc_stats_enable()
+ */
+void alloc_stats_disable(void);
+
+/**
+ * @brief Zeroes every counter; live bytes keep counting from the current value
+ */
+void alloc_stats_reset(void);
+
+/**
+ * @brief Makes every following allocation count as unexpected
+ * @param forbid true to start the zero-allocation check, false to end it
+ *
+ * Used to check that a warmed-up evaluation loop does not touch the heap:
+ * enable counting, run the loop once, forbid, run it again and check that
+ * AllocReport::unexpected stayed zero. The first unexpected allocation is
+ * reported on stderr with its size and stage.
+ */
+void alloc_stats_forbid(bool forbid);
+
+/**
+ * @brief Copies the current counters
+ * @param report Receives the snapshot
+ */
+void alloc_stats_report(AllocReport* report);
+
+/**
+ * @brief Prints allocations, frees, bytes and peak live bytes per stage
+ * @param out Stream to write to
+ */
+void alloc_stats_print(FILE* out);
+
+#endif /* ALLOC_STATS_H */
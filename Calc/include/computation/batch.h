@@ -0,0 +1,83 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tokenizer.h"
+#include "computation.h"
+#include "engine.h"
+#include "concurrency/work_stealing_pool.h"
+
+/**
+ * @brief Outcome of one batch expression
+ */
+typedef struct {
+    double value;            // Result when error == COMPUTATION_OK
+    ComputationError error;  // Evaluation status
+} BatchResult;
+
+/**
+ * @brief Parallel evaluator for independent expressions
+ *
+ * Every worker runs in its own clone of the caller's engine, so unknown names
+ * inserted by the tokenizer never race. "VAR = EXPRESSION" lines act as
+ * barriers: everything before them finishes, the assignment runs on the
+ * caller's engine, and workers refresh their variables before continuing.
+ * Names the workers registered are copied into the caller's engine at each
+ * barrier, so the caller ends up knowing the same names a serial run would.
+ */
+typedef struct BatchEvaluator {
+    CalcEngine* engine;                  // Caller's session; receives assignments
+    WorkStealingPool* pool;
+    CalcEngine** workers;                // Per-worker clones of engine
+    unsigned long* worker_versions;      // variables_version each clone was refreshed at
+    size_t* worker_slots;                // Slots each clone had when its names were last adopted
+    unsigned long variables_version;     // Bumped by every assignment
+} BatchEvaluator;
+
+/**
+ * @brief Reports whether a line containing '=' is not of the form "VAR = EXPRESSION"
+ * @param input Raw input line
+ * @param tokens Tokens produced for the line
+ * @return true when the line must be rejected
+ */
+bool is_malformed_assignment(const char* input, const TokenizerResult* tokens);
+
+/**
+ * @brief Tokenizes, parses and evaluates one line with no diagnostic or file output
+ * @param engine Engine to evaluate in
+ * @param input Expression or "VAR = EXPRESSION" (which updates the engine's variables)
+ * @return Value and status of the evaluation
+ * @note Resets the engine's arena before tokenizing. Expressions seen before
+ *       come from the engine's expression cache without being re-parsed.
+ */
+BatchResult evaluate_expression_text(CalcEngine* engine, const char* input);
+
+/**
+ * @brief Creates a parallel evaluator
+ * @param engine Session the lines are evaluated in; must outlive the evaluator
+ * @param threads Worker threads, or 0 for one per online CPU
+ * @return The evaluator or NULL on failure
+ */
+BatchEvaluator* batch_evaluator_create(CalcEngine* engine, size_t threads);
+
+/**
+ * @brief Evaluates lines in parallel, writing results in input order
+ * @param evaluator Evaluator to run on
+ * @param lines Input expressions
+ * @param count Number of lines
+ * @param results Receives count results; results[i] belongs to lines[i]
+ * @return 0 on success, -1 on failure
+ */
+int batch_evaluate(BatchEvaluator* evaluator, char* const* lines, size_t count, BatchResult* results);
+
+/**
+ * @brief Stops the workers and frees the evaluator
+ * @param evaluator Evaluator to destroy (may be NULL)
+ *
+ * The workers' stage statistics and cache counters are merged into the
+ * caller's engine first.
+ */
+void batch_evaluator_destroy(BatchEvaluator* evaluator);
+
+#endif /* BATCH_H */
@@ -0,0 +1,140 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "AST_tree.h"
+#include "datastructures/hashmapforconst.h"
+
+/**
+ * @brief Operations understood by the bytecode VM
+ *
+ * Every instruction writes exactly one register: the register with the same
+ * index as the instruction. Operands name earlier registers, so a program is
+ * a linear, already-scheduled form of the expression tree.
+ */
+typedef enum {
+    OP_CONST = 0,   // r[i] = value
+    OP_LOAD_VAR,    // r[i] = variables[a]
+    OP_ADD,         // r[i] = r[a] + r[b]
+    OP_SUB,         // r[i] = r[a] - r[b]
+    OP_MUL,         // r[i] = r[a] * r[b]
+    OP_DIV,         // r[i] = r[a] / r[b]
+    OP_POW,         // r[i] = pow(r[a], r[b])
+    OP_NEG,         // r[i] = -r[a]
+    OP_SIN,         // r[i] = sin(r[a]) with r[a] in degrees
+    OP_COS,         // r[i] = cos(r[a])
+    OP_TAN,         // r[i] = tan(r[a])
+    OP_LOG,         // r[i] = log(r[a]), also used for loge
+    OP_SQRT,        // r[i] = sqrt(r[a])
+    OP_EXP,         // r[i] = exp(r[a])
+    OP_ABS,         // r[i] = fabs(r[a])
+    OP_LOG10,       // r[i] = log10(r[a])
+    OP_LOG2,        // r[i] = log2(r[a])
+    OP_LOGBASE,     // r[i] = log(r[b]) / log(r[a])
+    OP_COUNT
+} OpCode;
+
+/**
+ * @brief A single 16-byte VM instruction
+ */
+typedef struct {
+    uint32_t op;              // OpCode
+    union {
+        double value;         // Immediate for OP_CONST
+        struct {
+            uint32_t a;       // First operand register, or variable slot for OP_LOAD_VAR
+            uint32_t b;       // Second operand register
+        } operands;
+    } arg;
+} Instruction;
+
+/**
+ * @brief Error codes for bytecode compilation
+ */
+typedef enum {
+    BYTECODE_OK = 0,            // Compiled successfully
+    BYTECODE_NULL_INPUT,        // No tree was provided
+    BYTECODE_MEMORY_ERROR,      // Memory allocation failed
+    BYTECODE_INVALID_NODE,      // Malformed node or unsupported token
+    BYTECODE_UNKNOWN_FUNCTION,  // Function with no matching opcode
+    BYTECODE_UNKNOWN_VARIABLE   // Variable not present in the slot list
+} BytecodeError;
+
+/**
+ * @brief A compiled, linear program
+ */
+typedef struct {
+    Instruction* code;       // Instructions; the last one produces the result
+    size_t length;           // Number of instructions (and registers)
+    size_t capacity;         // Allocated instruction slots
+    double* registers;       // Scratch registers used by bytecode_evaluate
+} BytecodeProgram;
+
+/**
+ * @brief Compiles an AST into a bytecode program
+ * @param root Root of the expression tree (assignments are not supported)
+ * @param variables Variable entries; a TOKEN_VARIABLE compiles to a load of its index in this list
+ * @param variable_count Number of entries in variables
+ * @param error Optional out-parameter receiving the compilation status
+ * @return The compiled program or NULL on error
+ */
+BytecodeProgram* bytecode_compile(const ASTNode* root, hashmapconst_entry_t* const* variables, size_t variable_count, BytecodeError* error);
+
+/**
+ * @brief Runs a program using caller-provided registers
+ * @param program Compiled program
+ * @param variables Variable values indexed by slot
+ * @param registers Scratch space of at least program->length doubles
+ * @return The value of the last instruction
+ *
+ * Reentrant: distinct callers may run the same program concurrently as long
+ * as each uses its own registers.
+ */
+double bytecode_run(const BytecodeProgram* program, const double* variables, double* registers);
+
+/**
+ * @brief Runs a program using its own scratch registers
+ * @param program Compiled program
+ * @param variables Variable values indexed by slot
+ * @return The value of the last instruction
+ */
+double bytecode_evaluate(BytecodeProgram* program, const double* variables);
+
+/**
+ * @brief Number of rows processed per register block by bytecode_run_columns
+ */
+#define BYTECODE_COLUMN_BLOCK 256
+
+/**
+ * @brief Evaluates a program over whole columns of variable values
+ * @param program Compiled program
+ * @param columns columns[slot] points at rows contiguous values of that variable
+ * @param rows Number of rows
+ * @param out Receives rows results
+ * @return 0 on success, -1 on invalid input or allocation failure
+ *
+ * Rows are processed in blocks of BYTECODE_COLUMN_BLOCK: each instruction runs
+ * once per block through SSE2/AVX2 kernels (selected at runtime) for + - * /,
+ * negation, abs, sqrt and squaring, and through libm loops otherwise.
+ */
+int bytecode_run_columns(const BytecodeProgram* program, const double* const* columns, size_t rows, double* out);
+
+/**
+ * @brief Names the kernel set used by bytecode_run_columns ("avx2", "sse2" or "scalar")
+ */
+const char* bytecode_column_isa(void);
+
+/**
+ * @brief Prints a human-readable listing of a program to stderr
+ * @param program Program to disassemble
+ */
+void bytecode_print(const BytecodeProgram* program);
+
+/**
+ * @brief Frees a program
+ * @param program Program to free (may be NULL)
+ */
+void bytecode_free(BytecodeProgram* program);
+
+#endif /* BYTECODE_H */
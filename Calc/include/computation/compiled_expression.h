@@ -0,0 +1,112 @@
+#ifndef COMPILED_EXPRESSION_H
+#define COMPILED_EXPRESSION_H
+
+#include <stddef.h>
+#include "tokenizer.h"
+#include "AST_tree.h"
+#include "computation.h"
+#include "bytecode.h"
+#include "jit.h"
+#include "engine.h"
+#include "datastructures/hashmapforconst.h"
+
+/**
+ * @brief Error codes for expression compilation
+ */
+typedef enum {
+    COMPILE_OK = 0,          // Expression compiled successfully
+    COMPILE_NULL_INPUT,      // Input was null or empty
+    COMPILE_TOKENIZER_ERROR, // Tokenizer rejected the input
+    COMPILE_SYNTAX_ERROR,    // Shunting yard or parser rejected the input
+    COMPILE_ASSIGNMENT,      // "VAR = EXPRESSION" cannot be compiled into a handle
+    COMPILE_DUPLICATE_VARIABLE, // A name appears twice in var_names (case-insensitively)
+    COMPILE_MEMORY_ERROR     // Memory allocation failed
+} CompileError;
+
+/**
+ * @brief An expression tokenized, converted to postfix and parsed once,
+ *        ready to be evaluated repeatedly against new variable values
+ *
+ * Variables are owned by the handle: they live in its private symbol table
+ * and never leak into the engine's variables.
+ */
+typedef struct CompiledExpression {
+    hashmapconst_t* symbols;          // Variables bound to this expression
+    hashmapconst_entry_t** variables; // Symbol entries indexed by variable slot
+    size_t variable_count;            // Number of variable slots
+    arena_t* arena;                   // Owns the postfix tokens and the tree
+    TokenizerResult* postfix;         // Postfix tokens the AST points into
+    ParseResult* ast;                 // Optimized expression DAG (common subexpressions shared)
+    size_t merged_nodes;              // Tree nodes merged away by common-subexpression elimination
+    BytecodeProgram* program;         // Linear program run by compiled_expression_evaluate
+    double* values;                   // Current variable values indexed by slot
+    JitProgram* jit;                  // Native code, once compiled_expression_enable_jit succeeded
+} CompiledExpression;
+
+/**
+ * @brief Compiles an expression into a reusable handle
+ * @param engine Engine providing functions and constants; must outlive the handle
+ * @param input Expression text, e.g. "x^2 + 2*x*y"
+ * @param var_names Names to bind as variables, in slot order (may be NULL); must be distinct
+ * @param var_count Number of entries in var_names
+ * @param error Optional out-parameter receiving the compilation status
+ * @return The compiled handle or NULL on error
+ *
+ * Identifiers that are neither listed in var_names nor known to the engine
+ * are appended as extra slots in order of first appearance. Identifiers the
+ * engine knows (pi, e, ...) are substituted at compile time.
+ */
+CompiledExpression* compile_expression(CalcEngine* engine, const char* input, const char* const* var_names, size_t var_count, CompileError* error);
+
+/**
+ * @brief Looks up the slot of a variable by name
+ * @param expr Compiled expression
+ * @param name Variable name (case insensitive)
+ * @return Slot index or -1 if the expression has no such variable
+ */
+int compiled_expression_variable_index(const CompiledExpression* expr, const char* name);
+
+/**
+ * @brief Binds a new value to a variable slot
+ * @param expr Compiled expression
+ * @param index Slot index returned by compiled_expression_variable_index
+ * @param value New value
+ */
+void compiled_expression_set_variable(CompiledExpression* expr, size_t index, double value);
+
+/**
+ * @brief Translates the expression's program to native code for hot loops
+ * @param expr Compiled expression
+ * @return The native function (also used by compiled_expression_evaluate from
+ *         now on), or NULL if the JIT is unsupported here or failed; the
+ *         bytecode program keeps working either way
+ *
+ * The function takes the variable values by slot (expr->values layout) and
+ * stays valid until compiled_expression_free().
+ */
+JitFunction compiled_expression_enable_jit(CompiledExpression* expr);
+
+/**
+ * @brief Evaluates the compiled expression with the current variable values
+ * @param expr Compiled expression
+ * @return ComputationResult with value or error information
+ */
+ComputationResult compiled_expression_evaluate(CompiledExpression* expr);
+
+/**
+ * @brief Evaluates the compiled expression over columns of variable values
+ * @param expr Compiled expression
+ * @param columns columns[slot] holds rows values for the variable in that slot
+ * @param rows Number of rows
+ * @param out Receives one result per row
+ * @return 0 on success, -1 on error
+ */
+int compiled_expression_evaluate_columns(const CompiledExpression* expr, const double* const* columns, size_t rows, double* out);
+
+/**
+ * @brief Frees a compiled expression and everything it owns
+ * @param expr Compiled expression to free (may be NULL)
+ */
+void compiled_expression_free(CompiledExpression* expr);
+
+#endif /* COMPILED_EXPRESSION_H */
@@ -15,7 +15,8 @@ typedef enum {
     COMPUTATION_DIVISION_BY_ZERO, // Division by zero attempted
     COMPUTATION_INVALID_OPERATION,// Invalid mathematical operation
     COMPUTATION_UNDEFINED_FUNCTION,// Function not found in supported set
-    COMPUTATION_MEMORY_ERROR     // Memory allocation failed
+    COMPUTATION_MEMORY_ERROR,    // Memory allocation failed
+    COMPUTATION_DEPENDENCY_CYCLE // Reactive assignment would make a variable depend on itself
 } ComputationError;
 
 /**
@@ -30,15 +31,42 @@ typedef struct {
 
 /**
  * @brief Computes result from an AST
+ * @param engine Engine whose variables receive assignments, whose
+ *               verbosity controls the tree dump and whose result
+ *               sink (if any) receives the value
  * @param result Parse result containing AST to evaluate
  * @return ComputationResult with value or error information
  */
-ComputationResult compute_ast(ParseResult* result);
+ComputationResult compute_ast(CalcEngine* engine, ParseResult* result);
 
 /**
- * @brief Traverses AST for computation
+ * @brief Evaluates a "VAR = EXPRESSION" tree and stores the value in VAR
+ * @param engine Engine holding the variable; in reactive mode the formula is
+ *               recorded and the variable's dependents are recomputed
+ * @param assignment Tree whose root is the TOKEN_EQUALITY node
+ * @param value Receives the assigned value
+ * @return COMPUTATION_OK, or the evaluation error (the variable is unchanged)
+ */
+ComputationError compute_assignment(CalcEngine* engine, const ASTNode* assignment, double* value);
+
+/**
+ * @brief Traverses AST for computation, folding each result into its node's token
  * @param node Current node being processed
+ * @param variables Values of the symbol table the tree's variables were resolved against
+ * @note Destructive: operator and function nodes are rewritten to TOKEN_NUMBER,
+ *       so the tree can only be evaluated once. Prefer evaluate_ast().
+ */
+void traversal(ASTNode* node, const double* variables);
+
+/**
+ * @brief Evaluates an AST without modifying any node or token
+ * @param node Root of the (sub)tree to evaluate
+ * @param variables Values of the symbol table the tree's variables were resolved
+ *                  against, indexed by token slot (may be NULL for constant trees)
+ * @param error Optional out-parameter; set to the first error encountered and
+ *              left untouched on success (initialize it to COMPUTATION_OK)
+ * @return The computed value, or NaN on error
  */
-void traversal(ASTNode* node);
+double evaluate_ast(const ASTNode* node, const double* variables, ComputationError* error);
 
 #endif /* COMPUTATION_H */
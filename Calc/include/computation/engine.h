@@ -0,0 +1,128 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "tokenizer.h"
+#include "datastructures/hashset.h"
+#include "datastructures/hashmapforconst.h"
+#include "datastructures/arena.h"
+#include "stage_stats.h"
+
+/**
+ * @brief How much a session prints to stderr besides errors; each level adds to the one before
+ */
+typedef enum {
+    CALC_VERBOSITY_QUIET,   // Nothing: no diagnostic is even formatted
+    CALC_VERBOSITY_RESULT,  // REPL results and batch run summaries
+    CALC_VERBOSITY_TOKENS,  // The tokens of each REPL input
+    CALC_VERBOSITY_TREE,    // The tree compute_ast() evaluates
+    CALC_VERBOSITY_TRACE    // The tree before and after optimization
+} CalcVerbosity;
+
+/*
+ * Highest verbosity compiled in. Building with -DCALC_MAX_VERBOSITY=N
+ * (make MAX_VERBOSITY=N) makes CALC_VERBOSE() a constant false above N, so
+ * the compiler drops those diagnostics along with their branch.
+ */
+#ifndef CALC_MAX_VERBOSITY
+#define CALC_MAX_VERBOSITY CALC_VERBOSITY_TRACE
+#endif
+#define CALC_VERBOSE(engine, level) ((level) <= CALC_MAX_VERBOSITY && (engine)->verbosity >= (level))
+
+struct ExpressionCache;
+struct ReactiveGraph;
+struct ResultSink;
+
+/**
+ * @brief State of one calculator session
+ *
+ * Every pipeline stage takes the engine it runs in, so independent sessions
+ * share nothing mutable and can run on different threads without locks. The
+ * function registry is never modified after creation, which lets clones share
+ * it; the variable environment and scratch buffers are private to each engine.
+ *
+ * Tokens, postfix arrays, parse results and AST nodes produced by the stages
+ * are bump-allocated from the engine's arena and are all released together by
+ * calc_engine_reset(), so steady-state evaluation does no heap allocation.
+ *
+ * Callers driving the stages time them with STAGE_TIMER_START/STAGE_TIMER_LAP
+ * into stage_stats, which belongs to the engine and so needs no locking.
+ */
+struct CalcEngine {
+    hashset_t* functions;           // Function registry: name -> argument count
+    bool owns_functions;            // False for clones sharing their parent's registry
+    hashmapconst_t* variables;      // Variable environment (constants, assignments, unknown names)
+    int unknown_variables;          // Identifiers first seen as unknown variables in this session
+    CalcVerbosity verbosity;        // Diagnostics to print (see CALC_VERBOSE)
+
+    Token* token_scratch;           // Operator stack and output queue used by shunt_yard_algo
+    size_t token_scratch_capacity;  // Tokens that fit in token_scratch
+    arena_t* arena;                 // Owns everything the stages allocate for an expression
+    StageStats* stage_stats;        // Per-stage latency histograms (NULL with STAGE_STATS=0)
+    struct ExpressionCache* expression_cache; // Parsed trees of recent inputs (see expression_cache.h)
+    struct ReactiveGraph* reactive; // Variable dependency graph, NULL unless reactive mode is on (see reactive.h)
+    struct ResultSink* result_sink; // Log compute_ast() appends results to; NULL logs nothing. Owned by the caller
+};
+
+/**
+ * @brief Creates a session with the built-in functions and constants
+ * @return The engine or NULL on allocation failure
+ */
+CalcEngine* calc_engine_create(void);
+
+/**
+ * @brief Parses a verbosity name: quiet, result, tokens, tree or trace
+ * @param name Name to parse
+ * @param verbosity Receives the level
+ * @return 0 on success, -1 for an unknown name
+ */
+int calc_verbosity_parse(const char* name, CalcVerbosity* verbosity);
+
+/**
+ * @brief Creates a session sharing another engine's function registry
+ * @param engine Engine to copy
+ * @return The clone or NULL on allocation failure
+ *
+ * The clone starts with a private copy of engine's variables, its own
+ * scratch buffers, empty stage statistics and an empty expression cache with
+ * the same memory cap. Clones are never reactive: they see the variables'
+ * values but not their formulas. engine must outlive the clone.
+ */
+CalcEngine* calc_engine_clone(const CalcEngine* engine);
+
+/**
+ * @brief Replaces an engine's variables with a copy of another engine's
+ * @param engine Engine to update
+ * @param source Engine whose variables are copied
+ * @return 0 on success, -1 on allocation failure (engine is left unchanged)
+ *
+ * The engine's expression cache and reactive graph point into the old
+ * variables and are cleared.
+ */
+int calc_engine_copy_variables(CalcEngine* engine, const CalcEngine* source);
+
+/**
+ * @brief Returns a token buffer of at least count entries owned by the engine
+ * @param engine Engine owning the buffer
+ * @param count Number of tokens needed
+ * @return The buffer (valid until the next call) or NULL on allocation failure
+ */
+Token* calc_engine_token_scratch(CalcEngine* engine, size_t count);
+
+/**
+ * @brief Releases every token array, parse result and AST node allocated by the stages
+ * @param engine Engine to reset
+ *
+ * Results of earlier tokenizeQuery, shunt_yard_algo and parse_expression calls
+ * must not be used afterwards.
+ */
+void calc_engine_reset(CalcEngine* engine);
+
+/**
+ * @brief Frees an engine and, unless it is a clone, its function registry
+ * @param engine Engine to destroy (may be NULL)
+ */
+void calc_engine_destroy(CalcEngine* engine);
+
+#endif /* ENGINE_H */
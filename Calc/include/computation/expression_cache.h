@@ -0,0 +1,108 @@
+#ifndef EXPRESSION_CACHE_H
+#define EXPRESSION_CACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "AST_tree.h"
+#include "engine.h"
+
+// Memory cap of the cache every new engine starts with
+#define EXPRESSION_CACHE_DEFAULT_BYTES (1u << 20)
+
+/**
+ * @brief One cached expression: its normalized text and optimized tree
+ *
+ * The entry, its nodes, tokens and key live in a single allocation of
+ * `bytes` bytes.
+ */
+typedef struct CachedExpression {
+    struct CachedExpression* hash_next;  // Next entry in the same bucket
+    struct CachedExpression* newer;      // Neighbour towards the most recently used end
+    struct CachedExpression* older;      // Neighbour towards the least recently used end
+    uint64_t hash;                       // Hash of key
+    size_t bytes;                        // Size of the allocation holding the entry
+    size_t key_length;                   // Length of key
+    const char* key;                     // Normalized input text
+    ParseResult result;                  // Optimized tree, variables referenced by entry
+} CachedExpression;
+
+/**
+ * @brief Bounded LRU cache of parsed expressions, keyed by normalized input
+ */
+typedef struct ExpressionCache {
+    CachedExpression** buckets;   // Hash chains
+    size_t bucket_count;          // Power of two
+    size_t entries;               // Expressions cached
+    CachedExpression* newest;     // Most recently used entry
+    CachedExpression* oldest;     // Least recently used entry, evicted first
+    size_t max_bytes;             // Memory cap for entries and buckets (0 disables the cache)
+    size_t bytes;                 // Memory currently used by entries and buckets
+
+    size_t hits;                  // Lookups answered from the cache
+    size_t misses;                // Lookups that had to tokenize, convert and parse
+    size_t evictions;             // Entries dropped to stay under max_bytes
+} ExpressionCache;
+
+/**
+ * @brief Creates an empty cache
+ * @param max_bytes Memory cap (0 creates a disabled cache)
+ * @return The cache or NULL on allocation failure
+ */
+ExpressionCache* expression_cache_create(size_t max_bytes);
+
+/**
+ * @brief Drops every entry; the counters are kept
+ * @param cache Cache to clear (may be NULL)
+ *
+ * Must be called whenever the variable environment the entries point into is
+ * replaced (calc_engine_copy_variables() does this).
+ */
+void expression_cache_clear(ExpressionCache* cache);
+
+/**
+ * @brief Changes the memory cap, evicting least recently used entries to meet it
+ * @param cache Cache to resize
+ * @param max_bytes New cap (0 empties and disables the cache)
+ */
+void expression_cache_set_limit(ExpressionCache* cache, size_t max_bytes);
+
+/**
+ * @brief Returns the optimized tree for an expression, from the cache when possible
+ * @param engine Engine owning the cache; on a miss its arena holds the pipeline's
+ *        intermediate results, so reset it first as for tokenizeQuery()
+ * @param input Expression text
+ * @return The parse result to evaluate (check its error), or NULL when the input
+ *         must take the uncached path: assignments, and engines without a cache
+ *
+ * The key is the input lowercased with whitespace removed, except that one
+ * space is kept between two words so "a b" and "ab" stay distinct. A hit
+ * skips tokenizing, the shunting yard, parsing and optimization. On a miss the
+ * expression is compiled with every engine variable kept as a reference to
+ * its entry rather than substituted as a number, so a cached tree always
+ * evaluates with the variables' current values. The result stays valid until
+ * the next call on the same engine or calc_engine_reset().
+ */
+ParseResult* expression_cache_parse(CalcEngine* engine, const char* input);
+
+/**
+ * @brief Adds another cache's hit, miss and eviction counters to cache
+ * @param cache Cache receiving the counts (may be NULL)
+ * @param other Cache whose counters are added, e.g. a batch worker's (may be NULL)
+ */
+void expression_cache_merge_counters(ExpressionCache* cache, const ExpressionCache* other);
+
+/**
+ * @brief Prints the counters, entry count and memory use
+ * @param out Stream to write to
+ * @param cache Cache to describe; NULL prints that caching is disabled
+ */
+void expression_cache_print(FILE* out, const ExpressionCache* cache);
+
+/**
+ * @brief Frees the cache and every entry
+ * @param cache Cache to destroy (may be NULL)
+ */
+void expression_cache_destroy(ExpressionCache* cache);
+
+#endif /* EXPRESSION_CACHE_H */
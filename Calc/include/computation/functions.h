@@ -0,0 +1,52 @@
+#ifndef FUNCTIONS_H
+#define FUNCTIONS_H
+
+#include <stddef.h>
+
+/**
+ * @brief Built-in functions, numbered so evaluation can dispatch through a table
+ */
+typedef enum {
+    FUNC_SIN = 0,   // sin(x) with x in degrees
+    FUNC_COS,       // cos(x)
+    FUNC_TAN,       // tan(x)
+    FUNC_LOG,       // natural logarithm
+    FUNC_SQRT,      // sqrt(x)
+    FUNC_EXP,       // exp(x)
+    FUNC_ABS,       // fabs(x)
+    FUNC_LOG10,     // log10(x)
+    FUNC_LOG2,      // log2(x)
+    FUNC_LOGE,      // natural logarithm (alias of log)
+    FUNC_LOGBASE,   // logbase(base, x) = log(x) / log(base)
+    FUNC_COUNT
+} FunctionId;
+
+/**
+ * @brief Everything the pipeline needs to know about a built-in function
+ *
+ * Tokens carry a pointer to their function's entry, so the parser reads the
+ * arity and the evaluator calls the implementation without any string lookup.
+ */
+typedef struct {
+    const char* name;                      // Lowercase name as written in expressions
+    FunctionId id;                         // Index of this entry in FUNCTION_TABLE
+    int arity;                             // Number of arguments (1 or 2)
+    double (*unary)(double);               // Implementation when arity is 1
+    double (*binary)(double, double);      // Implementation when arity is 2
+} FunctionInfo;
+
+/**
+ * @brief Function table indexed by FunctionId, built at compile time
+ */
+extern const FunctionInfo FUNCTION_TABLE[FUNC_COUNT];
+
+/**
+ * @brief Looks up a built-in function by id in O(1)
+ * @param id Function id (must be below FUNC_COUNT)
+ * @return The function's table entry
+ */
+static inline const FunctionInfo* function_info(FunctionId id) {
+    return &FUNCTION_TABLE[id];
+}
+
+#endif /* FUNCTIONS_H */
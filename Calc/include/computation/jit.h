@@ -0,0 +1,46 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "bytecode.h"
+
+/**
+ * @brief Native code for one expression: takes the variable values by slot, returns the result
+ */
+typedef double (*JitFunction)(const double* variables);
+
+/**
+ * @brief An executable page holding a compiled expression
+ */
+typedef struct {
+    void* code;             // mmap'd page(s), read + execute only once compiled
+    size_t size;            // Bytes mapped at code
+    JitFunction function;   // Entry point at the start of code
+} JitProgram;
+
+/**
+ * @brief Tells whether this build can generate native code (x86-64 Unix only)
+ */
+bool jit_supported(void);
+
+/**
+ * @brief Lowers a bytecode program to x86-64 SSE2 machine code
+ * @param program Program to translate (built by bytecode_compile)
+ * @return The native program, or NULL if the JIT is unsupported or mapping fails
+ *
+ * Each VM register becomes a stack slot; + - * / sqrt, negation and abs are
+ * inlined, pow and the other functions call libm with the same argument
+ * conversions as traversal(), so results match the tree evaluator bit for bit.
+ * The page is written first and then remapped read + execute (never both
+ * writable and executable). The function is reentrant.
+ */
+JitProgram* jit_compile(const BytecodeProgram* program);
+
+/**
+ * @brief Unmaps and frees a native program
+ * @param jit Program to free (may be NULL)
+ */
+void jit_free(JitProgram* jit);
+
+#endif /* JIT_H */
@@ -0,0 +1,58 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <stddef.h>
+#include "AST_tree.h"
+#include "datastructures/arena.h"
+
+/**
+ * @brief Counters describing what an optimization pass changed
+ */
+typedef struct {
+    size_t nodes_before;    // Nodes in the tree before the pass
+    size_t nodes_after;     // Nodes in the tree after the pass
+    size_t folded;          // Constant subtrees replaced by a single number
+    size_t simplified;      // Identities applied (x*1, x+0, x^1, --x, ...)
+} OptimizeStats;
+
+/**
+ * @brief Folds constant subtrees and applies algebraic identities
+ * @param arena Arena that owns the tree; folded numbers get fresh tokens from it
+ * @param root Root of the tree to optimize (an assignment's target is left alone)
+ * @param stats Optional out-parameter receiving what changed
+ * @return Root of the optimized tree (possibly a different node than root)
+ *
+ * Constant subtrees are folded with evaluate_ast(), so a folded tree evaluates
+ * to the same value as the original. Identities applied: x*1, 1*x, x/1, x+0,
+ * 0+x, x-0, x^1, +x and --x all become x. Tokens are never modified in place,
+ * since compiled expressions keep reading their postfix token array.
+ */
+ASTNode* optimize_ast(arena_t* arena, ASTNode* root, OptimizeStats* stats);
+
+/**
+ * @brief Merges identical subtrees so each distinct subexpression exists once
+ * @param arena Arena used for the temporary lookup table
+ * @param root Root of the tree to convert
+ * @param merged Optional out-parameter receiving the number of nodes merged away
+ * @return Root of the resulting DAG
+ *
+ * Nodes are hash-consed bottom-up on their operator, function, number bits or
+ * variable entry plus the identities of their already-merged children, so
+ * sqrt(x^2+y^2) written four times becomes one shared node. The result is a
+ * DAG: evaluate_ast() still evaluates it correctly (shared nodes once per
+ * use), while bytecode_compile() emits each shared node once. Assignments are
+ * never merged.
+ */
+ASTNode* share_common_subexpressions(arena_t* arena, ASTNode* root, size_t* merged);
+
+/**
+ * @brief Optimizes a successfully parsed expression in the engine's arena
+ * @param engine Engine that parsed the expression; at CALC_VERBOSITY_TRACE the
+ *        tree is printed with print_tree() before and after the pass
+ * @param result Parse result whose root is replaced by the optimized tree
+ *
+ * Parse results carrying an error are left untouched.
+ */
+void optimize_parse_result(CalcEngine* engine, ParseResult* result);
+
+#endif /* OPTIMIZER_H */
@@ -0,0 +1,121 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "engine.h"
+#include "batch.h"
+#include "concurrency/spsc_queue.h"
+#include "datastructures/arena.h"
+
+// Queue capacity used when pipeline_evaluator_create() is given 0
+#define PIPELINE_DEFAULT_DEPTH 64
+
+/**
+ * @brief The three pipeline stages, each on its own thread
+ */
+typedef enum {
+    PIPELINE_TOKENIZE,   // tokenizeQuery (the calling thread)
+    PIPELINE_PARSE,      // shunt_yard_algo, parse_expression and optimize_parse_result
+    PIPELINE_EVALUATE,   // evaluate_ast, and whole assignments
+    PIPELINE_STAGE_COUNT
+} PipelineStage;
+
+/**
+ * @brief Time one stage spent working and blocked, accumulated over every run
+ */
+typedef struct {
+    uint64_t busy_ns;          // Processing expressions
+    uint64_t input_wait_ns;    // Waiting for the previous stage (or for a free slot)
+    uint64_t output_wait_ns;   // Waiting for room in the next stage's queue
+} PipelineStageTimes;
+
+/**
+ * @brief One expression travelling through the pipeline, with the arena that holds its tokens and tree
+ */
+typedef struct PipelineSlot {
+    const char* line;
+    size_t index;              // Position of line in the current run
+    bool assignment;           // Evaluated whole by the evaluate stage in the caller's engine
+    bool rejected;             // Failed to tokenize or parse; result is already an error
+    arena_t* arena;
+    TokenizerResult tokens;
+    ParseResult* ast;
+} PipelineSlot;
+
+/**
+ * @brief Evaluator that overlaps tokenizing, parsing and evaluating consecutive expressions
+ *
+ * The caller's thread tokenizes, a second thread parses and a third
+ * evaluates, connected by bounded SPSC queues: while expression N is
+ * evaluated, N+1 is parsed and N+2 tokenized. Each expression occupies a
+ * slot whose arena its tokens and tree are allocated in; the evaluate stage
+ * hands slots back through a third queue, so the number of slots bounds the
+ * work in flight and a slow stage holds the ones before it back.
+ *
+ * Tokenizing substitutes variable values, so "VAR = EXPRESSION" lines are
+ * barriers as in BatchEvaluator: the tokenizer waits until the evaluate
+ * stage has applied the assignment to the caller's engine, then refreshes
+ * its variables. Between barriers the tokenizer's clone registers unknown
+ * names in its own table, and the evaluate stage registers the same names in
+ * the caller's engine in the same order, so both tables hand out the same
+ * slots and the session ends up as a serial run would leave it. The
+ * expression cache is not consulted.
+ */
+typedef struct PipelineEvaluator {
+    CalcEngine* engine;                      // Caller's session; the evaluate stage runs in it
+    CalcEngine* stage_engines[PIPELINE_EVALUATE]; // Clones for the tokenize and parse stages
+    PipelineSlot* slots;
+    size_t slot_count;
+    SpscQueue tokenized;                     // Tokenize -> parse
+    SpscQueue parsed;                        // Parse -> evaluate
+    SpscQueue free_slots;                    // Evaluate -> tokenize
+
+    // Current run
+    size_t count;
+    BatchResult* results;
+    size_t applied;                          // Lines up to the last assignment evaluated
+    pthread_mutex_t applied_lock;            // Guards applied
+    pthread_cond_t applied_changed;          // Signalled when an assignment has been evaluated
+
+    size_t expressions;                      // Evaluated over every run
+    PipelineStageTimes times[PIPELINE_STAGE_COUNT];
+} PipelineEvaluator;
+
+/**
+ * @brief Creates a pipelined evaluator
+ * @param engine Session the lines are evaluated in; must outlive the evaluator
+ * @param depth Capacity of each stage queue, or 0 for PIPELINE_DEFAULT_DEPTH
+ * @return The evaluator or NULL on allocation failure
+ */
+PipelineEvaluator* pipeline_evaluator_create(CalcEngine* engine, size_t depth);
+
+/**
+ * @brief Evaluates lines through the three stages, writing results in input order
+ * @param evaluator Evaluator to run on
+ * @param lines Input expressions
+ * @param count Number of lines
+ * @param results Receives count results; results[i] belongs to lines[i]
+ * @return 0 on success, -1 if the stage threads could not be started or the
+ *         variables could not be copied (the lines after that point are errors)
+ */
+int pipeline_evaluate(PipelineEvaluator* evaluator, char* const* lines, size_t count, BatchResult* results);
+
+/**
+ * @brief Prints each stage's busy and blocked time and each queue's occupancy, naming the bottleneck
+ * @param out Stream to write to
+ * @param evaluator Evaluator to describe
+ */
+void pipeline_evaluator_print(FILE* out, const PipelineEvaluator* evaluator);
+
+/**
+ * @brief Frees the evaluator
+ * @param evaluator Evaluator to destroy (may be NULL)
+ *
+ * The stage clones' statistics are merged into the caller's engine first.
+ */
+void pipeline_evaluator_destroy(PipelineEvaluator* evaluator);
+
+#endif /* PIPELINE_H */
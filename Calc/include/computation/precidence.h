@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 
 // Size of the hashmap used for operator precedence lookup
 #define HASHMAP_SIZE 17
@@ -26,8 +27,35 @@ typedef struct Operator {
     struct Operator *next; // Next operator in case of hash collision
 } Operator;
 
+/**
+ * @brief Precedence and associativity of a single-character operator
+ */
+typedef struct {
+    bool is_operator;      // False for characters that are not operators
+    int precedence;        // Operator precedence level
+    Associativity assoc;   // Operator's associativity direction
+} OperatorInfo;
+
+// Stack precedence of a unary sign: above '*' and '/', below '^' (-2^2 is -(2^2))
+#define UNARY_PRECEDENCE 3
+
+/**
+ * @brief Operator table indexed by character, built at compile time
+ */
+extern const OperatorInfo OPERATOR_TABLE[256];
+
+/**
+ * @brief Looks up a single-character operator in O(1) without allocating
+ * @param symbol Operator character (e.g. '+', '^', '=')
+ * @return Operator info; is_operator is false for any other character
+ */
+static inline const OperatorInfo* operator_info(char symbol) {
+    return &OPERATOR_TABLE[(unsigned char)symbol];
+}
+
 /**
  * @brief Hashmap structure for storing operator information
+ * @note Allocates on every innit_precidence(); the pipeline uses operator_info() instead
  */
 typedef struct {
     Operator *buckets[HASHMAP_SIZE]; // Array of operator linked lists
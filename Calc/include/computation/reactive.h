@@ -0,0 +1,106 @@
+#ifndef REACTIVE_H
+#define REACTIVE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "AST_tree.h"
+#include "computation.h"
+#include "engine.h"
+#include "datastructures/hashmapforconst.h"
+
+/**
+ * @brief One variable in the dependency graph
+ */
+typedef struct {
+    hashmapconst_entry_t* variable;  // Entry in the engine's variables; its slot indexes the value
+    ASTNode* formula;                // Right-hand side of the last assignment, NULL for plain inputs
+    uint32_t* dependencies;          // Nodes the formula reads, without duplicates
+    size_t dependency_count;
+    uint32_t* dependents;            // Nodes whose formulas read this variable
+    size_t dependent_count;
+    size_t dependent_capacity;
+    uint32_t mark;                   // Traversal epoch that last visited the node
+} ReactiveNode;
+
+/**
+ * @brief Dependency graph of the variables assigned in reactive mode
+ *
+ * Edges point from a variable to the variables whose formulas read it. The
+ * graph is kept acyclic: an assignment that would close a cycle is rejected.
+ */
+typedef struct ReactiveGraph {
+    ReactiveNode* nodes;
+    size_t node_count;
+    size_t node_capacity;
+
+    hashmapconst_entry_t** index_keys;  // Open-addressed map from variable entry to node id
+    uint32_t* index_values;
+    size_t index_capacity;              // Power of two
+
+    uint32_t epoch;                     // Bumped before every traversal
+    uint32_t* order;                    // Scratch: affected nodes in post-order
+    uint32_t* stack_nodes;              // Scratch: iterative depth-first search
+    size_t* stack_next;
+    uint32_t* scratch_dependencies;     // Scratch: dependencies of the formula being assigned
+    size_t scratch_capacity;            // Entries in each scratch array
+
+    size_t edges;                       // Dependency edges in the graph
+    size_t last_recomputed;             // Variables recomputed by the last assignment
+    size_t total_recomputed;            // Variables recomputed since the graph was created
+} ReactiveGraph;
+
+/**
+ * @brief Switches an engine to reactive mode
+ * @param engine Engine to switch
+ * @return 0 on success, -1 on allocation failure
+ *
+ * From now on the tokenizer keeps the engine's variables as references
+ * instead of substituting their values, every "VAR = EXPRESSION" records the
+ * variables the expression reads, and reassigning a variable recomputes
+ * exactly the variables that depend on it, in topological order. Values
+ * assigned before the switch are treated as plain inputs.
+ */
+int reactive_enable(CalcEngine* engine);
+
+/**
+ * @brief Leaves reactive mode; variables keep their current values
+ * @param engine Engine to switch back
+ */
+void reactive_disable(CalcEngine* engine);
+
+/**
+ * @brief Forgets every formula and edge (used when the variables are replaced)
+ * @param graph Graph to clear (may be NULL)
+ */
+void reactive_graph_clear(ReactiveGraph* graph);
+
+/**
+ * @brief Assigns a formula to a variable and recomputes its dependents
+ * @param engine Engine in reactive mode
+ * @param target Variable being assigned
+ * @param expression Right-hand side; it is copied, so it may live in the arena
+ * @param value Receives the variable's new value
+ * @return COMPUTATION_OK, COMPUTATION_DEPENDENCY_CYCLE if the formula reads
+ *         target directly or through other formulas, the error of evaluating
+ *         expression, or COMPUTATION_MEMORY_ERROR; nothing changes on error
+ *
+ * Runs in time proportional to the variables downstream of target, not to
+ * the size of the graph.
+ */
+ComputationError reactive_assign(CalcEngine* engine, hashmapconst_entry_t* target, const ASTNode* expression, double* value);
+
+/**
+ * @brief Prints the number of variables, formulas and edges and the recompute counters
+ * @param out Stream to write to
+ * @param graph Graph to describe; NULL prints that reactive mode is off
+ */
+void reactive_graph_print(FILE* out, const ReactiveGraph* graph);
+
+/**
+ * @brief Frees a graph and the formulas it owns
+ * @param graph Graph to destroy (may be NULL)
+ */
+void reactive_graph_destroy(ReactiveGraph* graph);
+
+#endif /* REACTIVE_H */
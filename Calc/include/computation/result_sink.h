@@ -0,0 +1,99 @@
+#ifndef RESULT_SINK_H
+#define RESULT_SINK_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+// Results the asynchronous sink can hold before the evaluating thread has to wait
+#define RESULT_SINK_RING_CAPACITY (1u << 14)
+// Log file compute_ast() used to overwrite; the CLI's default sink appends to it
+#define RESULT_SINK_DEFAULT_PATH "computation.txt"
+
+/**
+ * @brief How a sink gets results to its log file
+ */
+typedef enum {
+    RESULT_SINK_DISABLED,  // Results are counted and dropped; no file is opened
+    RESULT_SINK_BUFFERED,  // Formatted into a stdio buffer on the caller's thread
+    RESULT_SINK_ASYNC      // Pushed onto a lock-free ring; a writer thread formats them
+} ResultSinkMode;
+
+/**
+ * @brief Destination for evaluation results, one "%.17g" line per result
+ *
+ * A sink has a single producer: the thread evaluating in the engine it is
+ * attached to. Results are appended in order and none are dropped; when the
+ * asynchronous ring is full the producer waits for the writer.
+ */
+typedef struct ResultSink {
+    ResultSinkMode mode;
+    FILE* file;                   // Append log (NULL when disabled)
+    char* buffer;                 // stdio buffer of file
+    double* ring;                 // RESULT_SINK_RING_CAPACITY results (async only)
+    pthread_t writer;
+
+    // Written by the producer only
+    atomic_size_t head;           // Next slot the producer fills
+    size_t written;               // Results accepted by result_sink_write()
+    size_t stalls;                // Writes that found the ring full and had to wait
+
+    // Written by the writer thread; kept off the producer's cache line
+    _Alignas(64) atomic_size_t tail; // Next slot the writer drains
+    atomic_size_t flushed;        // Results the writer has formatted and flushed to the file
+    atomic_int stopping;          // Set by result_sink_close() to end the writer
+    atomic_int failed;            // A write or flush failed; set by whichever thread saw it
+} ResultSink;
+
+/**
+ * @brief Parses a mode name ("off", "buffered" or "async")
+ * @param name Name to parse
+ * @param mode Receives the mode
+ * @return 0 on success, -1 for an unknown name
+ */
+int result_sink_parse_mode(const char* name, ResultSinkMode* mode);
+
+/**
+ * @brief Opens a sink appending to a file
+ * @param mode How results reach the file
+ * @param path Log file (ignored when disabled)
+ * @return The sink, or NULL if the file cannot be opened or memory or the
+ *         writer thread cannot be obtained
+ */
+ResultSink* result_sink_open(ResultSinkMode mode, const char* path);
+
+/**
+ * @brief Records one result
+ * @param sink Sink to write to (NULL records nothing)
+ * @param value Result to record
+ * @return 0, or -1 once any write to the log has failed
+ *
+ * In asynchronous mode this only stores value in the ring; no formatting or
+ * system call happens on the caller's thread unless the ring is full.
+ */
+int result_sink_write(ResultSink* sink, double value);
+
+/**
+ * @brief Waits until every result written so far is in the operating system's hands
+ * @param sink Sink to flush (NULL is a no-op)
+ * @return 0, or -1 if any write or flush has failed
+ */
+int result_sink_flush(ResultSink* sink);
+
+/**
+ * @brief Prints the mode, results written, ring stalls and error state
+ * @param out Stream to write to
+ * @param sink Sink to describe (NULL prints that results are not logged)
+ */
+void result_sink_print(FILE* out, const ResultSink* sink);
+
+/**
+ * @brief Flushes every pending result, stops the writer and closes the file
+ * @param sink Sink to close (may be NULL)
+ * @return 0, or -1 if any result could not be written
+ */
+int result_sink_close(ResultSink* sink);
+
+#endif /* RESULT_SINK_H */
@@ -7,9 +7,11 @@
 /**
  * @brief Converts infix notation to postfix notation using Shunting Yard algorithm
  * 
+ * @param engine Engine whose scratch buffers hold the operator stack and output queue
  * @param tokens Input tokens in infix notation
- * @return TokenizerResult* Output tokens in postfix notation, or NULL if error
+ * @return TokenizerResult* Output tokens in postfix notation, or NULL if error;
+ *         allocated from the engine's arena and released by calc_engine_reset()
  */
-TokenizerResult* shunt_yard_algo(TokenizerResult* tokens);
+TokenizerResult* shunt_yard_algo(CalcEngine* engine, TokenizerResult* tokens);
 
 #endif /* SHUNT_YARD_ALGO_H */
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef STAGE_STATS_H
+#define STAGE_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "datastructures/histogram.h"
+
+/**
+ * @brief Pipeline stages with their own latency histogram
+ */
+typedef enum {
+    CALC_STAGE_TOKENIZE,     // tokenizeQuery
+    CALC_STAGE_SHUNT_YARD,   // shunt_yard_algo
+    CALC_STAGE_PARSE,        // parse_expression (AST construction)
+    CALC_STAGE_OPTIMIZE,     // optimize_parse_result
+    CALC_STAGE_EVALUATE,     // compute_ast / evaluate_ast
+    CALC_STAGE_COUNT
+} CalcStage;
+
+/**
+ * @brief Per-stage latency histograms of one engine, in nanoseconds
+ */
+typedef struct StageStats {
+    histogram_t stages[CALC_STAGE_COUNT];
+} StageStats;
+
+/**
+ * @brief Reads the monotonic clock
+ * @return Nanoseconds since an arbitrary fixed point
+ */
+static inline uint64_t stage_clock_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Records the time since *timer for a stage and restarts the timer
+ * @param stats Histograms to record into (NULL records nothing)
+ * @param stage Stage that just finished
+ * @param timer Start of the stage; set to now so the next stage starts here
+ */
+static inline void stage_stats_lap(StageStats* stats, CalcStage stage, uint64_t* timer) {
+    uint64_t now = stage_clock_ns();
+    if (stats) {
+        histogram_record(&stats->stages[stage], now - *timer);
+    }
+    *timer = now;
+}
+
+/*
+ * Timers placed around the pipeline stages. Building with
+ * -DCALC_NO_STAGE_STATS (make STAGE_STATS=0) turns them into nothing, so the
+ * instrumented code paths do not even read the clock.
+ */
+#ifndef CALC_NO_STAGE_STATS
+#define STAGE_STATS_ENABLED 1
+#define STAGE_TIMER_START(timer) uint64_t timer = stage_clock_ns()
+#define STAGE_TIMER_LAP(engine, stage, timer) stage_stats_lap((engine)->stage_stats, (stage), &(timer))
+#else
+#define STAGE_STATS_ENABLED 0
+#define STAGE_TIMER_START(timer) ((void)0)
+#define STAGE_TIMER_LAP(engine, stage, timer) ((void)0)
+#endif
+
+/**
+ * @brief Allocates empty per-stage histograms
+ * @return The statistics or NULL on allocation failure
+ */
+StageStats* stage_stats_create(void);
+
+/**
+ * @brief Empties every histogram
+ * @param stats Statistics to clear (may be NULL)
+ */
+void stage_stats_reset(StageStats* stats);
+
+/**
+ * @brief Adds another engine's timings, e.g. a batch worker's, to stats
+ * @param stats Statistics receiving the timings
+ * @param other Statistics to add (unchanged, may be NULL)
+ */
+void stage_stats_merge(StageStats* stats, const StageStats* other);
+
+/**
+ * @brief Prints count, p50, p99, p99.9, max and mean per stage
+ * @param out Stream to write to
+ * @param stats Statistics to print; NULL prints that nothing is being collected
+ */
+void stage_stats_print(FILE* out, const StageStats* stats);
+
+/**
+ * @brief Frees statistics created by stage_stats_create()
+ * @param stats Statistics to free (may be NULL)
+ */
+void stage_stats_destroy(StageStats* stats);
+
+#endif /* STAGE_STATS_H */
@@ -10,9 +10,11 @@
 #define TOKENIZER_H
 
 #include <stddef.h>  // For size_t
+#include <stdio.h>   // For FILE
 #include <stdbool.h> // For boolean type
 #include "datastructures/hashset.h" // Include hashset header for supported functions
 #include "datastructures/hashmapforconst.h"// For constants like pi and e
+#include "functions.h"               // Built-in function table
 
 // Debug logging macro
 #define LOGS(fmt, ...) fprintf(stderr, "[%s:%d] " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__)
@@ -50,18 +52,15 @@ typedef enum {
     TOKEN_UNARY_POSITIVE
 } UnaryOperator;
 
-// Global set of supported mathematical functions
-// IMPROVEMENT: Consider making this const after initialization
-extern hashset_t* SUPPORTED_FUNCTIONS;
-
-extern hashmapconst_t* VARIABLES;
+// Session state (function registry, variables, scratch buffers); defined in engine.h
+typedef struct CalcEngine CalcEngine;
 
 
 // Union to store different types of token data efficiently
 typedef union {
     double num_value;      // For TOKEN_NUMBER: stores numeric values
     char operator_value;   // For TOKEN_OPERATOR: stores operator symbol
-    hashset_entry_t* function_name;   // For TOKEN_FUNCTION: stores function name (dynamically allocated)
+    const FunctionInfo* function;     // For TOKEN_FUNCTION: entry in FUNCTION_TABLE (id, arity, implementation)
     hashmapconst_entry_t* var_name;       // For TOKEN_VARIABLE: stores variable name (dynamically allocated)
     char equality;        // For TOKEN_EQUALITY: stores equality symbol
     char parenthesis;     // For TOKEN_PARENTHESIS: stores parenthesis character
@@ -72,16 +71,10 @@ typedef union {
 // Complete token structure combining type and data
 typedef struct {
     TokenType type;    // Type identifier for the token
+    unsigned int slot; // For TOKEN_VARIABLE: index of the value in its symbol table's values array
     TokenData data;    // Actual data stored in the token
 } Token;
 
-// Structure for managing arrays of string tokens
-// IMPROVEMENT: Add capacity field for better memory management
-typedef struct {
-    char **tokens;     // Array of token strings (dynamically allocated)
-    size_t size;       // Current number of tokens in the array
-} TokenArrChar;
-
 // Structure for returning tokenization results
 typedef struct {
     Token* tokens;         // Array of processed tokens
@@ -97,25 +90,29 @@ typedef struct {
 // Function declarations
 // IMPROVEMENT: Add error parameter to functions that can fail
 hashset_t* init_SUPPORTED_FUNCTIONS_();
-// Frees memory allocated for tokens
-void cleanup_tokens(Token* tokens,size_t size);
-
-// Adds proper spacing around operators and special characters
-TokenizerError replace_characters(const char *input, char *output, size_t output_size);
+// Creates the variable table pre-populated with constants such as pi and e
+hashmapconst_t* init_VARIABLES_();
 
 // Converts string to lowercase for case-insensitive processing
 TokenizerError to_lowercase(char *str, size_t max_len);
-// Frees memory allocated for token array
-void free_token_array(TokenArrChar *token_array);
 
 // Validates function names against supported functions set
  bool is_valid_function(hashset_t* SUPPORTED_FUNCTIONS,const char *str);
 
-// Core tokenization function
-Token* tokenize(const char *str, const char *delim, size_t *token_count, TokenizerError *error);
+// Core tokenization function: a single pass over str that classifies tokens in place, matching
+// identifiers case-insensitively without copying them. Unknown identifiers are added to the
+// engine's variables. The returned tokens live in the engine's arena until calc_engine_reset()
+Token* tokenize(CalcEngine* engine, const char *str, size_t *token_count, TokenizerError *error);
+
+// Tokenization that resolves identifiers found in (or unknown to the engine's variables) against
+// a caller-owned symbol table and leaves them as TOKEN_VARIABLE instead of substituting them
+Token* tokenize_symbols(CalcEngine* engine, const char *str, hashmapconst_t* symbols, size_t *token_count, TokenizerError *error);
 
 // High-level tokenization interface
-TokenizerResult tokenizeQuery(const char *input_string);
+TokenizerResult tokenizeQuery(CalcEngine* engine, const char *input_string);
+
+// High-level tokenization interface with a caller-owned symbol table (see tokenize_symbols)
+TokenizerResult tokenizeQuerySymbols(CalcEngine* engine, const char *input_string, hashmapconst_t* symbols);
 
 // Debugging function to print token information
 void print_token(const Token* token);
@@ -124,7 +121,22 @@ void print_token(const Token* token);
 void run_tests(void);
 
 // Interactive input processor
-void process_custom_input(void);
+void process_custom_input(CalcEngine* engine);
+
+// Non-interactive evaluator: one expression per input line, one result per output line
+int process_batch_input(CalcEngine* engine, FILE* in, FILE* out);
+
+// Batch evaluator spread over a work-stealing pool of threads (0 = one per CPU)
+int process_parallel_batch_input(CalcEngine* engine, FILE* in, FILE* out, size_t threads);
+
+// Batch evaluator whose tokenize, parse and evaluate stages run on three threads (0 depth = default)
+int process_pipeline_batch_input(CalcEngine* engine, FILE* in, FILE* out, size_t depth, bool print_stats);
+
+// Columnar evaluator: EXPRESSION over every row of a CSV whose header names the variables
+int process_column_input(CalcEngine* engine, const char* expression, FILE* in, FILE* out);
+
+// Daemon: serves requests on a Unix domain socket until SIGINT or SIGTERM (0 workers = one per CPU)
+int process_daemon(CalcEngine* engine, const char* path, size_t threads);
 
 // User interface menu
 void display_menu(void);
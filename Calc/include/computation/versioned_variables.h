@@ -0,0 +1,180 @@
+#ifndef VERSIONED_VARIABLES_H
+#define VERSIONED_VARIABLES_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "datastructures/hashmapforconst.h"
+#include "engine.h"
+#include "batch.h"
+
+// Reader threads that can be registered with one VersionedVariables at a time
+#define VERSIONED_VARIABLES_MAX_READERS 64
+
+/**
+ * @brief One published version of a variable environment
+ *
+ * Nothing modifies variables once the snapshot is published; a later write
+ * publishes a copy instead. Slots keep their numbers from version to version
+ * (hashmapconst_clone() preserves them), so the values of version n are a
+ * prefix-compatible layout for every later version.
+ */
+typedef struct VariableSnapshot {
+    hashmapconst_t* variables;           // Immutable once published
+    unsigned long version;               // 1 for the initial environment, +1 per write
+    uint64_t retired_epoch;              // Global epoch when a newer version replaced it
+    struct VariableSnapshot* next_retired;
+} VariableSnapshot;
+
+/**
+ * @brief Registration of one reader thread (epoch 0 while it holds no snapshot)
+ */
+typedef struct {
+    _Alignas(64) atomic_uint_fast64_t epoch; // Global epoch seen when the current pin began
+    atomic_int in_use;
+    hashmapconst_t* unknown;             // Names not in the pinned snapshot; they read as 0
+} VariableReader;
+
+/**
+ * @brief Variable environment readers evaluate against without locks while writers publish new versions
+ *
+ * Readers pin the current snapshot, evaluate against it and unpin: a pin is
+ * two loads and a store, never a lock, and every variable of an expression
+ * comes from the same version. A writer copies the current snapshot, changes
+ * the copy and publishes it with one atomic exchange (copy-on-write); writers
+ * are serialized by writer_lock, which readers never take.
+ *
+ * Superseded snapshots are reclaimed by epochs: publishing retires the old
+ * snapshot at the current global epoch and advances it. A reader stores the
+ * global epoch before loading the current snapshot, so a snapshot retired at
+ * epoch E can only still be in use by a reader whose pin epoch is at most E;
+ * once every pinned reader shows a later epoch, the snapshot is freed.
+ */
+typedef struct VersionedVariables {
+    _Atomic(VariableSnapshot*) current;
+    atomic_uint_fast64_t epoch;          // Global epoch, advanced by every publication
+    VariableReader readers[VERSIONED_VARIABLES_MAX_READERS];
+
+    pthread_mutex_t writer_lock;         // Held from versioned_variables_begin_write() to commit or abort
+    hashmapconst_t* writer_unknown;      // Names an assignment reads that are not defined (writers only)
+    VariableSnapshot* retired;           // Superseded snapshots not freed yet (writers only)
+    size_t retired_count;
+    size_t published;                    // Versions published after the initial one
+    size_t reclaimed;                    // Superseded snapshots freed
+} VersionedVariables;
+
+/**
+ * @brief Creates an environment whose first version is a copy of a variable table
+ * @param initial Variables to start from, e.g. an engine's (copied, not kept)
+ * @return The environment or NULL on allocation failure
+ */
+VersionedVariables* versioned_variables_create(const hashmapconst_t* initial);
+
+/**
+ * @brief Registers the calling thread as a reader
+ * @param versions Environment to read
+ * @return Reader index for pin/unpin, or -1 when every reader slot is taken
+ */
+int versioned_variables_register_reader(VersionedVariables* versions);
+
+/**
+ * @brief Releases a reader index; the reader must not hold a pin
+ * @param versions Environment the reader was registered with
+ * @param reader Index returned by versioned_variables_register_reader()
+ */
+void versioned_variables_unregister_reader(VersionedVariables* versions, int reader);
+
+/**
+ * @brief Pins the current snapshot for a reader; it stays valid until the matching unpin
+ * @param versions Environment to read
+ * @param reader The calling thread's reader index (pins do not nest)
+ * @return The snapshot, which must not be modified
+ */
+const VariableSnapshot* versioned_variables_pin(VersionedVariables* versions, int reader);
+
+/**
+ * @brief Ends a reader's pin
+ * @param versions Environment the snapshot came from
+ * @param reader The calling thread's reader index
+ */
+void versioned_variables_unpin(VersionedVariables* versions, int reader);
+
+/**
+ * @brief Starts a write: locks out other writers and returns a private copy of the current version
+ * @param versions Environment to change
+ * @return The copy to modify (hashmapconst_update(), hashmapconst_intern()), or
+ *         NULL on allocation failure (no lock is held then)
+ */
+hashmapconst_t* versioned_variables_begin_write(VersionedVariables* versions);
+
+/**
+ * @brief Publishes a copy from versioned_variables_begin_write() as the new version
+ * @param versions Environment to change
+ * @param variables The modified copy; owned by the environment from now on
+ * @return The new version number, or 0 on allocation failure (the copy is discarded)
+ *
+ * Snapshots no pinned reader can still see are freed before returning.
+ */
+unsigned long versioned_variables_commit(VersionedVariables* versions, hashmapconst_t* variables);
+
+/**
+ * @brief Discards a copy from versioned_variables_begin_write() and releases the writer lock
+ */
+void versioned_variables_abort(VersionedVariables* versions, hashmapconst_t* variables);
+
+/**
+ * @brief Sets one variable (adding it if new) and publishes the result as a new version
+ * @return The new version number, or 0 on allocation failure
+ */
+unsigned long versioned_variables_assign(VersionedVariables* versions, const char* name, double value);
+
+/**
+ * @brief Evaluates "VAR = EXPRESSION" against the current version and publishes the result
+ * @param versions Environment to change
+ * @param engine Writer's engine, used for its function registry and scratch buffers
+ * @param input The assignment
+ * @return Assigned value and status; nothing is published unless it is COMPUTATION_OK
+ *
+ * The target is taken from the text before '=', so a name that is already
+ * defined can be assigned again; the expression reads the current version.
+ */
+BatchResult versioned_variables_assign_text(VersionedVariables* versions, CalcEngine* engine, const char* input);
+
+/**
+ * @brief Tokenizes, parses and evaluates one expression against a snapshot
+ * @param engine Reader's engine (a clone, not shared with other threads)
+ * @param snapshot Variables to read; only looked up, never modified
+ * @param unknown Reader-private table that receives names the snapshot lacks (they read as 0)
+ * @param input Expression (assignments are rejected: they go through a writer)
+ * @return Value and status of the evaluation
+ * @note Resets the engine's arena; the expression cache is not used.
+ */
+BatchResult variable_snapshot_evaluate(CalcEngine* engine, const VariableSnapshot* snapshot,
+                                       hashmapconst_t* unknown, const char* input);
+
+/**
+ * @brief Pins the current version, evaluates one expression against it and unpins
+ * @param versions Environment to read
+ * @param reader The calling thread's reader index
+ * @param engine The calling thread's engine
+ * @param input Expression to evaluate
+ * @return Value and status of the evaluation
+ */
+BatchResult versioned_variables_evaluate(VersionedVariables* versions, int reader, CalcEngine* engine, const char* input);
+
+/**
+ * @brief Prints the current version, versions published and snapshots awaiting reclamation
+ * @param out Stream to write to
+ * @param versions Environment to describe
+ */
+void versioned_variables_print(FILE* out, VersionedVariables* versions);
+
+/**
+ * @brief Frees every snapshot; no reader may hold a pin
+ * @param versions Environment to destroy (may be NULL)
+ */
+void versioned_variables_destroy(VersionedVariables* versions);
+
+#endif /* VERSIONED_VARIABLES_H */
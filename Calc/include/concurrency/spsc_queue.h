@@ -0,0 +1,88 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/**
+ * @brief Bounded lock-free queue of pointers between one producer and one consumer thread
+ *
+ * head and tail are free-running counters on separate cache lines; each side
+ * keeps a cached copy of the other's counter and only reloads it when the
+ * queue looks full (producer) or empty (consumer). The blocking calls spin
+ * briefly and then yield, so a full queue holds the producer back.
+ *
+ * The counters below the indices are written by one side only and are meant
+ * to be read once both threads are done with the queue.
+ */
+typedef struct SpscQueue {
+    void** slots;
+    size_t mask;                    // capacity - 1 (capacity is a power of two)
+
+    // Producer side
+    _Alignas(64) atomic_size_t head;  // Next slot to fill
+    size_t cached_tail;
+    size_t pushes;
+    size_t occupancy_sum;           // Items ahead of each push, summed
+    size_t full_waits;              // Pushes that found the queue full
+
+    // Consumer side
+    _Alignas(64) atomic_size_t tail;  // Next slot to drain
+    size_t cached_head;
+    size_t empty_waits;             // Pops that found the queue empty
+} SpscQueue;
+
+/**
+ * @brief Allocates the slots of a queue
+ * @param queue Queue to initialize
+ * @param capacity Minimum number of items; rounded up to a power of two
+ * @return 0 on success, -1 on allocation failure
+ */
+int spsc_queue_init(SpscQueue* queue, size_t capacity);
+
+/**
+ * @brief Number of items the queue holds when full
+ */
+size_t spsc_queue_capacity(const SpscQueue* queue);
+
+/**
+ * @brief Appends an item unless the queue is full (producer only)
+ * @return true if the item was queued
+ */
+bool spsc_queue_try_push(SpscQueue* queue, void* item);
+
+/**
+ * @brief Appends an item, waiting for the consumer while the queue is full (producer only)
+ */
+void spsc_queue_push(SpscQueue* queue, void* item);
+
+/**
+ * @brief Removes the oldest item unless the queue is empty (consumer only)
+ * @param item Receives the item
+ * @return true if an item was removed
+ */
+bool spsc_queue_try_pop(SpscQueue* queue, void** item);
+
+/**
+ * @brief Removes the oldest item, waiting for the producer while the queue is empty (consumer only)
+ */
+void* spsc_queue_pop(SpscQueue* queue);
+
+/**
+ * @brief Mean number of items already queued when an item was pushed
+ */
+double spsc_queue_mean_occupancy(const SpscQueue* queue);
+
+/**
+ * @brief Clears the wait and occupancy counters (with neither side running)
+ */
+void spsc_queue_reset_stats(SpscQueue* queue);
+
+/**
+ * @brief Frees the slots of a queue
+ * @param queue Queue to destroy (may be NULL)
+ */
+void spsc_queue_destroy(SpscQueue* queue);
+
+#endif /* SPSC_QUEUE_H */
@@ -0,0 +1,52 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <stddef.h>
+
+/**
+ * @brief Task callback invoked once per index of a parallel run
+ * @param context Caller data passed to ws_pool_run
+ * @param index Task index in [0, task_count)
+ * @param worker Index of the worker thread running the task, in [0, ws_pool_size)
+ */
+typedef void (*ws_task_fn)(void* context, size_t index, size_t worker);
+
+/**
+ * @brief Fixed set of worker threads, each owning a Chase-Lev deque of task chunks
+ *
+ * Chunks are dealt round-robin to the workers' deques; a worker pops from the
+ * bottom of its own deque and, once it runs dry, steals from the top of the
+ * others until every chunk is done.
+ */
+typedef struct WorkStealingPool WorkStealingPool;
+
+/**
+ * @brief Starts a pool
+ * @param threads Number of worker threads, or 0 for one per online CPU
+ * @return The pool or NULL on failure
+ */
+WorkStealingPool* ws_pool_create(size_t threads);
+
+/**
+ * @brief Number of worker threads in the pool
+ */
+size_t ws_pool_size(const WorkStealingPool* pool);
+
+/**
+ * @brief Runs fn for every index in [0, task_count) and waits for completion
+ * @param pool Pool to run on
+ * @param fn Task callback
+ * @param context Caller data handed to every callback
+ * @param task_count Number of task indices
+ * @param grain Indices per chunk (the unit of stealing); 0 picks a default
+ * @return 0 on success, -1 on failure
+ */
+int ws_pool_run(WorkStealingPool* pool, ws_task_fn fn, void* context, size_t task_count, size_t grain);
+
+/**
+ * @brief Stops the workers and frees the pool
+ * @param pool Pool to destroy (may be NULL)
+ */
+void ws_pool_destroy(WorkStealingPool* pool);
+
+#endif /* WORK_STEALING_POOL_H */
@@ -0,0 +1,87 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// Structure for a pluggable heap allocator used by the whole library
+typedef struct {
+    void* (*malloc_fn)(size_t size, void* context);               ///< Allocates size bytes
+    void* (*realloc_fn)(void* ptr, size_t size, void* context);   ///< Resizes ptr (NULL ptr allocates)
+    void  (*free_fn)(void* ptr, void* context);                   ///< Frees ptr (never called with NULL)
+    void* context;                                                ///< Passed to every hook
+} calc_allocator_t;
+
+/**
+ * @brief Routes every library allocation through a custom allocator.
+ *
+ * The allocator is process-wide. Memory is always freed by the allocator
+ * that is installed at the time, so install it before creating any engine,
+ * hash container or compiled expression, unless the new allocator can free
+ * blocks from the old one (the counting allocator in alloc_stats.h can,
+ * since it forwards to the C library).
+ *
+ * @param allocator The hooks to use, or NULL to restore malloc/realloc/free.
+ */
+void calc_set_allocator(const calc_allocator_t* allocator);
+
+/**
+ * @brief Returns the allocator currently installed.
+ *
+ * @return The hooks in use (the C library's when none was installed).
+ */
+const calc_allocator_t* calc_get_allocator(void);
+
+/**
+ * @brief Tells whether the C library's malloc/realloc/free are installed.
+ *
+ * @return true when no custom allocator is installed.
+ */
+bool calc_allocator_is_default(void);
+
+/**
+ * @brief Allocates memory through the installed allocator.
+ *
+ * @param size Number of bytes.
+ *
+ * @return The memory, or NULL on failure.
+ */
+void* calc_malloc(size_t size);
+
+/**
+ * @brief Allocates zeroed memory through the installed allocator.
+ *
+ * @param count Number of elements.
+ * @param size Size of each element.
+ *
+ * @return The memory, or NULL on failure or overflow.
+ */
+void* calc_calloc(size_t count, size_t size);
+
+/**
+ * @brief Resizes memory obtained from the installed allocator.
+ *
+ * @param ptr Memory to resize, or NULL to allocate.
+ * @param size New size in bytes.
+ *
+ * @return The resized memory, or NULL on failure (ptr is then unchanged).
+ */
+void* calc_realloc(void* ptr, size_t size);
+
+/**
+ * @brief Frees memory obtained from the installed allocator.
+ *
+ * @param ptr Memory to free (may be NULL).
+ */
+void calc_free(void* ptr);
+
+/**
+ * @brief Duplicates a string through the installed allocator.
+ *
+ * @param value The string to copy.
+ *
+ * @return The copy, or NULL on failure.
+ */
+char* calc_strdup(const char* value);
+
+#endif /* ALLOCATOR_H */
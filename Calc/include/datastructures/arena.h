@@ -0,0 +1,74 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Size of the first block; later blocks double until a request fits
+#define ARENA_INITIAL_BLOCK_SIZE 4096
+
+// Structure for one contiguous block of arena memory
+typedef struct arena_block {
+    struct arena_block* next;  ///< Next block in the chain
+    size_t capacity;           ///< Usable bytes in data
+    size_t used;               ///< Bytes handed out since the last reset
+    _Alignas(max_align_t) unsigned char data[]; ///< Memory handed out by arena_alloc
+} arena_block_t;
+
+// Structure for the bump arena
+typedef struct {
+    arena_block_t* head;       ///< First block
+    arena_block_t* current;    ///< Block allocations are currently served from
+    size_t block_allocations;  ///< Blocks obtained from malloc over the arena's lifetime
+} arena_t;
+
+/**
+ * @brief Creates an empty arena.
+ *
+ * No memory is reserved until the first allocation.
+ *
+ * @return A pointer to the new arena, or NULL if allocation fails.
+ */
+arena_t* arena_create(void);
+
+/**
+ * @brief Allocates memory from the arena.
+ *
+ * The memory is aligned for any type and stays valid until the next
+ * arena_reset() or arena_destroy(); it is never freed individually.
+ *
+ * @param arena The arena to allocate from.
+ * @param size Number of bytes.
+ *
+ * @return A pointer to the memory, or NULL if a new block could not be allocated.
+ */
+void* arena_alloc(arena_t* arena, size_t size);
+
+/**
+ * @brief Allocates zeroed memory from the arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param count Number of elements.
+ * @param size Size of each element.
+ *
+ * @return A pointer to the zeroed memory, or NULL on failure or overflow.
+ */
+void* arena_calloc(arena_t* arena, size_t count, size_t size);
+
+/**
+ * @brief Releases every allocation at once.
+ *
+ * Blocks are kept and reused, so an arena that has seen its largest
+ * workload serves later ones without touching the heap.
+ *
+ * @param arena The arena to reset.
+ */
+void arena_reset(arena_t* arena);
+
+/**
+ * @brief Frees the arena and all of its blocks.
+ *
+ * @param arena The arena to destroy (may be NULL).
+ */
+void arena_destroy(arena_t* arena);
+
+#endif // ARENA_H
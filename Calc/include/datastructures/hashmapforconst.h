@@ -9,27 +9,39 @@
 // Structure for hash map entries
 typedef struct hashmapconst_entry {
     char* name;
-    double input_value;
+    unsigned int slot;                 // Index of the value in the map's values array, fixed for the entry's lifetime
     struct hashmapconst_entry* next;
 } hashmapconst_entry_t;
 
-// Structure for the hash map
+// Structure for the hash map. Names are interned: each gets the next slot, and
+// values[slot] holds its value, so code that resolved a name once reads the
+// value with a single indexed load
 typedef struct {
     hashmapconst_entry_t** table;
     size_t size;
     size_t capacity;
+    double* values;                    // Dense values indexed by slot; moves when it grows
+    hashmapconst_entry_t** slots;      // Entry owning each slot (NULL once removed)
+    size_t slot_count;                 // Slots handed out so far
+    size_t slot_capacity;              // Entries allocated in values and slots
 } hashmapconst_t;
 
 // Function declarations
 unsigned int hashmapconst_hash(const char* value);
 hashmapconst_t* hashmapconst_create(void);
 void hashmapconst_destroy(hashmapconst_t* map);
-int hashmapconst_add(hashmapconst_t* map, const char* value, const float input_value);
+int hashmapconst_add(hashmapconst_t* map, const char* value, const double input_value);
 void hashmapconst_remove(hashmapconst_t* map, const char* value);
 int hashmapconst_contains(hashmapconst_t* map, const char* value);
 void hashmapconst_resize(hashmapconst_t* map);
-float hashmapconst_get_value(hashmapconst_t* map, const char* key);
+double hashmapconst_get_value(hashmapconst_t* map, const char* key);
 hashmapconst_entry_t* hashmapconst_get_entry(hashmapconst_t* map, const char* key) ;
-int hashmapconst_update(hashmapconst_t* map, const char* value, const float input_value);
+// Looks up key[0..length) folded to lowercase, without copying it (stored names are lowercase)
+hashmapconst_entry_t* hashmapconst_get_entry_lowercase(hashmapconst_t* map, const char* key, size_t length);
+// Returns the entry for name, adding it with input_value if it is new
+hashmapconst_entry_t* hashmapconst_intern(hashmapconst_t* map, const char* name, const double input_value);
+// Copies the names, slots and values, so slot indices resolved against map stay valid in the copy
+hashmapconst_t* hashmapconst_clone(const hashmapconst_t* map);
+int hashmapconst_update(hashmapconst_t* map, const char* value, const double input_value);
 
 #endif // HASHMAPFORCONST_H
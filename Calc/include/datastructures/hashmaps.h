@@ -108,5 +108,4 @@ int hashmap_contains_key(hashmap_t* hashmap, const char* key);
  */
 void hashmap_resize(hashmap_t* hashmap);
 
-int hashmap_get(hashmap_t* map, const char* key);
 #endif // HASHMAP_H
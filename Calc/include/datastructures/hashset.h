@@ -9,7 +9,7 @@
 // Structure for each entry in the hash set (bucket entry)
 typedef struct hashset_entry {
     char* value;                ///< The value stored in the set
-    int input_spaces;         ///< The input how much input does a function take
+    int input_spaces;         ///< Integer payload (the FunctionId in the function registry)
     struct hashset_entry* next; ///< Pointer to the next entry (for collision handling)
 } hashset_entry_t;
 
@@ -94,5 +94,20 @@ int hashset_contains(hashset_t* set, const char* value);
 void hashset_resize(hashset_t* set);
 int hashset_get_value(hashset_t* set, const char* key);
 hashset_entry_t* hashset_get_entry(hashset_t* set, const char* key) ;
+
+/**
+ * @brief Looks up a key that is not NUL-terminated, ignoring its case.
+ *
+ * Stored values are expected to be lowercase; key is folded to lowercase
+ * while it is hashed and compared, so callers can look up a slice of a
+ * larger string without copying it.
+ *
+ * @param set The hash set to search.
+ * @param key First character of the key.
+ * @param length Number of characters in the key.
+ *
+ * @return The matching entry, or NULL if there is none.
+ */
+hashset_entry_t* hashset_get_entry_lowercase(hashset_t* set, const char* key, size_t length);
 #endif 
 // HASHSET_H
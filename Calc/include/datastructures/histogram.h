@@ -0,0 +1,72 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Values below this are counted exactly; above it each power of two is split
+// into HISTOGRAM_SUB_BUCKETS buckets, bounding the relative error to ~3%
+#define HISTOGRAM_EXACT_LIMIT 64
+#define HISTOGRAM_SUB_BUCKETS 32
+// Largest tracked magnitude (2^48 ns is about three days); larger values saturate
+#define HISTOGRAM_MAX_MAGNITUDE 48
+#define HISTOGRAM_BUCKETS (HISTOGRAM_EXACT_LIMIT + (HISTOGRAM_MAX_MAGNITUDE - 6) * HISTOGRAM_SUB_BUCKETS)
+
+// Structure for a log-linear (HDR-style) histogram of non-negative integer values
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS]; ///< Values recorded per bucket
+    uint64_t total;                     ///< Values recorded overall
+    uint64_t min;                       ///< Smallest value recorded (exact)
+    uint64_t max;                       ///< Largest value recorded (exact)
+    double sum;                         ///< Sum of all values, for the mean
+} histogram_t;
+
+/**
+ * @brief Empties a histogram.
+ *
+ * @param histogram The histogram to clear.
+ */
+void histogram_reset(histogram_t* histogram);
+
+/**
+ * @brief Records one value.
+ *
+ * Constant time: the bucket index is computed from the position of the
+ * value's highest set bit, so recording never searches or allocates.
+ *
+ * @param histogram The histogram to record into.
+ * @param value The value (e.g. a latency in nanoseconds).
+ */
+void histogram_record(histogram_t* histogram, uint64_t value);
+
+/**
+ * @brief Adds every value recorded in one histogram to another.
+ *
+ * @param histogram The histogram receiving the values.
+ * @param other The histogram to add (unchanged).
+ */
+void histogram_merge(histogram_t* histogram, const histogram_t* other);
+
+/**
+ * @brief Returns the value at a percentile.
+ *
+ * The result is the highest value equivalent to the bucket holding the
+ * percentile, clamped to the exact maximum, so it never understates.
+ *
+ * @param histogram The histogram to query.
+ * @param percentile Percentile between 0 and 100 (e.g. 99.9).
+ *
+ * @return The value, or 0 if the histogram is empty.
+ */
+uint64_t histogram_percentile(const histogram_t* histogram, double percentile);
+
+/**
+ * @brief Returns the mean of the recorded values.
+ *
+ * @param histogram The histogram to query.
+ *
+ * @return The mean, or 0 if the histogram is empty.
+ */
+double histogram_mean(const histogram_t* histogram);
+
+#endif /* HISTOGRAM_H */
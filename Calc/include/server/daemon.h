@@ -0,0 +1,110 @@
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "computation/engine.h"
+
+/*
+ * Wire protocol. Every message in either direction is a frame: a 4-byte
+ * big-endian payload length followed by the payload.
+ *
+ *   request payload:  the expression text (no terminator)
+ *   response payload: one CalcDaemonStatus byte, then text -- the value as
+ *                     "%.17g" for CALC_DAEMON_OK, a short message otherwise
+ *
+ * A client may send any number of requests without waiting (pipelining);
+ * responses come back on the same connection in request order.
+ */
+#define CALC_DAEMON_HEADER_BYTES 4
+// Longest request payload accepted; a larger frame is answered with
+// CALC_DAEMON_TOO_LARGE and the connection is closed
+#define CALC_DAEMON_MAX_REQUEST (64 * 1024)
+
+/**
+ * @brief Status byte at the start of every response payload
+ */
+typedef enum {
+    CALC_DAEMON_OK,          // Payload text is the value
+    CALC_DAEMON_EVAL_ERROR,  // The expression did not tokenize, parse or evaluate
+    CALC_DAEMON_TOO_LARGE    // Request exceeded CALC_DAEMON_MAX_REQUEST; the connection closes
+} CalcDaemonStatus;
+
+/**
+ * @brief Server answering calculator requests on a Unix domain socket
+ *
+ * One thread runs an epoll loop that accepts connections and does all socket
+ * reads and writes; a fixed pool of workers evaluates. Each connection is a
+ * session of its own: a clone of the daemon's engine that shares its function
+ * registry and starts from its variables, so assignments made by one client
+ * are not seen by others. A connection is handed to at most one worker at a
+ * time, which evaluates every complete request it has buffered, so responses
+ * stay in order while different connections run in parallel.
+ */
+typedef struct CalcDaemon CalcDaemon;
+
+/**
+ * @brief Counters of a daemon (read them once calc_daemon_run() has returned)
+ */
+typedef struct {
+    size_t connections;       // Connections accepted
+    size_t peak_connections;  // Most connections open at once
+    size_t requests;          // Requests answered
+    size_t failed;            // Requests answered with an error status
+} CalcDaemonStats;
+
+/**
+ * @brief Binds and listens on a Unix domain socket and starts the workers
+ * @param engine Session every connection is cloned from; must outlive the daemon.
+ *        Its result sink is not used: daemon results are not logged
+ * @param path Socket path; an existing socket file there is replaced
+ * @param workers Worker threads, or 0 for one per online CPU
+ * @return The daemon, or NULL if the socket cannot be bound or the workers started
+ */
+CalcDaemon* calc_daemon_create(CalcEngine* engine, const char* path, size_t workers);
+
+/**
+ * @brief Number of worker threads of a daemon
+ */
+size_t calc_daemon_workers(const CalcDaemon* daemon);
+
+/**
+ * @brief Serves clients until calc_daemon_stop() is called
+ * @param daemon Daemon to run
+ * @return 0 after a stop request, -1 if the event loop failed
+ */
+int calc_daemon_run(CalcDaemon* daemon);
+
+/**
+ * @brief Asks a running daemon to return from calc_daemon_run()
+ * @param daemon Daemon to stop
+ * @note Async-signal-safe and callable from any thread. Requests not yet
+ *       answered when the loop notices are dropped with their connections.
+ */
+void calc_daemon_stop(CalcDaemon* daemon);
+
+/**
+ * @brief Copies a daemon's counters
+ * @param daemon Daemon to read
+ * @param stats Receives the counters
+ */
+void calc_daemon_get_stats(const CalcDaemon* daemon, CalcDaemonStats* stats);
+
+/**
+ * @brief Prints connections, requests and errors served
+ * @param out Stream to write to
+ * @param daemon Daemon to describe
+ */
+void calc_daemon_print(FILE* out, const CalcDaemon* daemon);
+
+/**
+ * @brief Stops the workers, closes every connection and removes the socket file
+ * @param daemon Daemon to destroy (may be NULL)
+ *
+ * The connections' stage statistics and cache counters have already been
+ * merged into the daemon's engine as each connection closed.
+ */
+void calc_daemon_destroy(CalcDaemon* daemon);
+
+#endif /* DAEMON_H */
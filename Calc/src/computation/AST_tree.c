@@ -6,10 +6,13 @@
 #include "../../include/computation/AST_tree.h"
 #include "../../include/computation/precidence.h"
 #include "../../include/datastructures/hashset.h"
+#include "../../include/computation/engine.h"
+#include "../../include/datastructures/allocator.h"
+#include "../../include/computation/alloc_stats.h"
 
 #pragma GCC diagnostic ignored "-Wunused-function"
 
-ASTResult ast_create_node(Token* token) {
+ASTResult ast_create_node(arena_t* arena, Token* token) {
     ASTResult result = {NULL, AST_OK, NULL};
     
     if (!token) {
@@ -18,7 +21,7 @@ ASTResult ast_create_node(Token* token) {
         return result;
     }
 
-    ASTNode* node = (ASTNode*)calloc(1, sizeof(ASTNode));
+    ASTNode* node = (ASTNode*)arena_alloc(arena, sizeof(ASTNode));
     if (!node) {
         result.error = AST_MEMORY_ERROR;
         result.error_msg = "Memory allocation failed";
@@ -34,20 +37,20 @@ ASTResult ast_create_node(Token* token) {
     return result;
 }
 
-ASTStack* ast_create_stack(size_t initial_capacity) {
-    ASTStack* stack = (ASTStack*)malloc(sizeof(ASTStack));
+ASTStack* ast_create_stack(arena_t* arena, size_t initial_capacity) {
+    ASTStack* stack = (ASTStack*)arena_alloc(arena, sizeof(ASTStack));
     if (!stack) {
         return NULL;
     }
     
-    stack->nodes = (ASTNode**)malloc(initial_capacity * sizeof(ASTNode*));
+    stack->nodes = (ASTNode**)arena_alloc(arena, initial_capacity * sizeof(ASTNode*));
     if (!stack->nodes) {
-        free(stack);
         return NULL;
     }
     
     stack->capacity = initial_capacity;
     stack->size = 0;
+    stack->arena = arena;
     return stack;
 }
 
@@ -57,11 +60,12 @@ ASTError ast_push(ASTStack* stack, ASTNode* node) {
     }
     
     if (stack->size >= stack->capacity) {
-        size_t new_capacity = stack->capacity * 2;
-        ASTNode** new_nodes = (ASTNode**)realloc(stack->nodes, new_capacity * sizeof(ASTNode*));
+        size_t new_capacity = stack->capacity ? stack->capacity * 2 : 1;
+        ASTNode** new_nodes = (ASTNode**)arena_alloc(stack->arena, new_capacity * sizeof(ASTNode*));
         if (!new_nodes) {
             return AST_MEMORY_ERROR;
         }
+        memcpy(new_nodes, stack->nodes, stack->size * sizeof(ASTNode*));
         stack->nodes = new_nodes;
         stack->capacity = new_capacity;
     }
@@ -133,10 +137,10 @@ void print_token_just_val(ASTNode* node) {
             fprintf(stderr, "%c ", node->token->data.operator_value); 
             break;
         case TOKEN_FUNCTION: 
-            fprintf(stderr, "%s ", node->token->data.function_name->value); 
+            fprintf(stderr, "%s ", node->token->data.function->name); 
             break;
         case TOKEN_VARIABLE: 
-            fprintf(stderr, "%s(%f) ", node->token->data.var_name->name,hashmapconst_get_value(VARIABLES,node->token->data.var_name->name)); 
+            fprintf(stderr, "%s ", node->token->data.var_name->name); 
             break;
         case TOKEN_PARENTHESIS:
         case TOKEN_EQUALITY:
@@ -170,7 +174,7 @@ void print_tree_recursive(ASTNode* node, int level, char* prefix, bool is_last)
     }
 
     size_t new_prefix_len = strlen(prefix) + 5;
-    char* new_prefix = malloc(new_prefix_len);
+    char* new_prefix = calc_malloc(new_prefix_len);
     if (!new_prefix) {
         fprintf(stderr, "Memory allocation failed in print_tree_recursive\n");
         return;
@@ -188,7 +192,7 @@ void print_tree_recursive(ASTNode* node, int level, char* prefix, bool is_last)
         print_tree_recursive(node->right, level + 1, new_prefix, true);
     }
 
-    free(new_prefix);
+    calc_free(new_prefix);
 }
 
 void print_tree(ParseResult* result) {
@@ -199,16 +203,15 @@ void print_tree(ParseResult* result) {
     print_tree_recursive(result->root, 0, "", true);
 }
 
-ParseResult* parse_expression(const TokenizerResult* tokens) {
-    HashMap* precedence_map = innit_precidence(NULL);
-    if (!precedence_map) {
-        ParseResult* result = malloc(sizeof(ParseResult));
-        result->error = AST_MEMORY_ERROR;
-        result->error_msg = "Failed to create precedence map";
-        return result;
+static ParseResult* build_ast(const CalcEngine* engine, const TokenizerResult* tokens) {
+    if (!engine) {
+        return NULL;
+    }
+
+    ParseResult* result = (ParseResult*)arena_alloc(engine->arena, sizeof(ParseResult));
+    if (!result) {
+        return NULL;
     }
-    
-    ParseResult* result = malloc(sizeof(ParseResult));
     result->root = NULL;
     result->error = AST_OK;
     result->error_msg = NULL;
@@ -217,25 +220,22 @@ ParseResult* parse_expression(const TokenizerResult* tokens) {
     if (!tokens || tokens->token_count == 0) {
         result->error = AST_NULL_INPUT;
         result->error_msg = "No tokens to parse";
-        free_hashmap(precedence_map);
         return result;
     }
 
-    ASTStack* stack = ast_create_stack(tokens->token_count);
+    ASTStack* stack = ast_create_stack(engine->arena, tokens->token_count);
     if (!stack) {
         result->error = AST_MEMORY_ERROR;
         result->error_msg = "Failed to create stack";
-        free_hashmap(precedence_map);
         return result;
     }
     
     size_t token_idx = 0;
     while(token_idx < tokens->token_count) {
-        ASTResult node_result = ast_create_node(&tokens->tokens[token_idx]);
+        ASTResult node_result = ast_create_node(engine->arena, &tokens->tokens[token_idx]);
         if (node_result.error != AST_OK) {
             result->error = node_result.error;
             result->error_msg = node_result.error_msg;
-            free_hashmap(precedence_map);
             return result;
         }
         
@@ -247,15 +247,12 @@ ParseResult* parse_expression(const TokenizerResult* tokens) {
             if(stack->size < 2) {
                 result->error = AST_SYNTAX_ERROR;
                 result->error_msg = "Invalid syntax";
-                free_hashmap(precedence_map);
                 return result;
             }
             
-            Operator* current_op = precidence_hashmap_get(precedence_map, (char[]){peek_result.node->token->data.operator_value, '\0'});
-            if (!current_op) {
+            if (!operator_info(peek_result.node->token->data.operator_value)->is_operator) {
                 result->error = AST_SYNTAX_ERROR;
                 result->error_msg = "Unknown operator";
-                free_hashmap(precedence_map);
                 return result;
             }
             
@@ -270,7 +267,6 @@ ParseResult* parse_expression(const TokenizerResult* tokens) {
             if(stack->size < 1) {
                 result->error = AST_SYNTAX_ERROR;
                 result->error_msg = "Invalid syntax";
-                free_hashmap(precedence_map);
                 return result;
             }
             
@@ -283,14 +279,12 @@ ParseResult* parse_expression(const TokenizerResult* tokens) {
             if(stack->size < 1) {
                 result->error = AST_SYNTAX_ERROR;
                 result->error_msg = "Invalid syntax";
-                free_hashmap(precedence_map);
                 return result;
             }
-            int child_count = hashset_get_value(SUPPORTED_FUNCTIONS, peek_result.node->token->data.function_name->value);
+            int child_count = peek_result.node->token->data.function->arity;
             if(child_count == 0) {
                 result->error = AST_SYNTAX_ERROR;
                 result->error_msg = "Invalid syntax";
-                free_hashmap(precedence_map);
                 return result;
             }
             if(child_count == 1) {
@@ -313,7 +307,6 @@ ParseResult* parse_expression(const TokenizerResult* tokens) {
             if(stack->size < 2) {
                 result->error = AST_SYNTAX_ERROR;
                 result->error_msg = "Invalid syntax";
-                free_hashmap(precedence_map);
                 return result;
             }
             ASTNode* op = ast_pop(stack);
@@ -328,7 +321,6 @@ ParseResult* parse_expression(const TokenizerResult* tokens) {
             if(stack->size < 2) {
                 result->error = AST_SYNTAX_ERROR;
                 result->error_msg = "Invalid syntax";
-                free_hashmap(precedence_map);
                 return result;
             }
             ASTNode* op = ast_pop(stack);
@@ -341,67 +333,34 @@ ParseResult* parse_expression(const TokenizerResult* tokens) {
     }
     
     result->root = ast_pop(stack);
-    ast_free_stack(stack);
-    free_hashmap(precedence_map);
     return result;
 }
 
-static void ast_free_token(Token* token) {
-    if (!token) return;
-    
-    if (token->type == TOKEN_FUNCTION && token->data.function_name) {
-        free(token->data.function_name);
-        token->data.function_name = NULL;
-    }
-    else if (token->type == TOKEN_VARIABLE && token->data.var_name->name) {
-        free(token->data.var_name);
-        token->data.var_name = NULL;
-    }
+size_t ast_count_nodes(const ASTNode* node) {
+    if (!node) return 0;
+    return 1 + ast_count_nodes(node->left) + ast_count_nodes(node->right) + ast_count_nodes(node->child);
 }
 
-void ast_free_node(ASTNode** node_ptr) {
-    if (!node_ptr || !*node_ptr) return;
-    
-    if ((*node_ptr)->left) ast_free_node(&(*node_ptr)->left);
-    if ((*node_ptr)->right) ast_free_node(&(*node_ptr)->right);
-    if ((*node_ptr)->child) ast_free_node(&(*node_ptr)->child);
-    
-    free(*node_ptr);
-    *node_ptr = NULL;
-}
+static ASTNode* copy_node(const ASTNode* node, ASTNode* nodes, Token* tokens, size_t* used) {
+    if (!node) return NULL;
 
-void cleanup_ast(ParseResult* result) {
-    if (!result) return;
-    
-    if (result->root) {
-        ast_free_node(&result->root);
-        result->root = NULL;
-    }
-    
-    result->error = AST_OK;
-    result->error_msg = NULL;
-    result->tokens_processed = 0;
-    
-    free(result);
+    size_t index = (*used)++;
+    tokens[index] = *node->token;
+    nodes[index].token = &tokens[index];
+    nodes[index].left = copy_node(node->left, nodes, tokens, used);
+    nodes[index].right = copy_node(node->right, nodes, tokens, used);
+    nodes[index].child = copy_node(node->child, nodes, tokens, used);
+    return &nodes[index];
 }
 
-void ast_free_stack(ASTStack* stack) {
-    if (!stack) {
-        return;
-    }
-
-    if (stack->nodes) {
-        for (size_t i = 0; i < stack->size; i++) {
-            if (stack->nodes[i]) {
-                ast_free_node(&stack->nodes[i]);
-                stack->nodes[i] = NULL;
-            }
-        }
-        free(stack->nodes);
-        stack->nodes = NULL;
-    }
+ASTNode* ast_copy_tree(const ASTNode* node, ASTNode* nodes, Token* tokens) {
+    size_t used = 0;
+    return copy_node(node, nodes, tokens, &used);
+}
 
-    stack->size = 0;
-    stack->capacity = 0;
-    free(stack);
+ParseResult* parse_expression(const CalcEngine* engine, const TokenizerResult* tokens) {
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_PARSE);
+    ParseResult* result = build_ast(engine, tokens);
+    alloc_stats_leave_stage(previous_stage);
+    return result;
 }
@@ -0,0 +1,146 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <malloc.h>
+#include "../../include/computation/alloc_stats.h"
+#include "../../include/datastructures/allocator.h"
+
+#define ALLOC_STAGE_SLOTS (CALC_STAGE_COUNT + 1)
+
+typedef struct {
+    atomic_size_t allocations;
+    atomic_size_t frees;
+    atomic_size_t bytes;
+    atomic_size_t peak_live_bytes;
+} AtomicCounters;
+
+static AtomicCounters stage_counters[ALLOC_STAGE_SLOTS];
+// Signed: blocks allocated before alloc_stats_enable() may be freed while counting
+static atomic_llong live_bytes;
+static atomic_size_t peak_live_bytes;
+static atomic_size_t unexpected;
+static atomic_bool forbidden;
+
+static calc_allocator_t previous_allocator;
+static bool enabled;
+
+_Thread_local int alloc_stats_stage = ALLOC_STAGE_OTHER;
+
+static const char* STAGE_NAMES[ALLOC_STAGE_SLOTS] = {
+    "tokenize", "shunt_yard", "parse", "optimize", "evaluate", "other"
+};
+
+static void update_peak(atomic_size_t* peak, size_t value) {
+    size_t seen = atomic_load_explicit(peak, memory_order_relaxed);
+    while (value > seen && !atomic_compare_exchange_weak_explicit(peak, &seen, value,
+                                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+static void record_allocation(size_t requested, size_t usable, size_t released) {
+    AtomicCounters* counters = &stage_counters[alloc_stats_stage];
+    atomic_fetch_add_explicit(&counters->allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->bytes, requested, memory_order_relaxed);
+
+    long long delta = (long long)usable - (long long)released;
+    long long live = atomic_fetch_add_explicit(&live_bytes, delta, memory_order_relaxed) + delta;
+    if (live > 0) {
+        update_peak(&peak_live_bytes, (size_t)live);
+        update_peak(&counters->peak_live_bytes, (size_t)live);
+    }
+
+    if (atomic_load_explicit(&forbidden, memory_order_relaxed) &&
+        atomic_fetch_add_explicit(&unexpected, 1, memory_order_relaxed) == 0) {
+        fprintf(stderr, "Unexpected allocation of %zu bytes in stage %s\n", requested, STAGE_NAMES[alloc_stats_stage]);
+    }
+}
+
+static size_t current_live_bytes(void) {
+    long long live = atomic_load(&live_bytes);
+    return live > 0 ? (size_t)live : 0;
+}
+
+// The hooks forward to the allocator they replaced, which alloc_stats_enable() only accepts
+// when it is the C library's, so malloc_usable_size() applies to every block
+static void* counting_malloc(size_t size, void* context) {
+    (void)context;
+    void* ptr = previous_allocator.malloc_fn(size, previous_allocator.context);
+    if (ptr) record_allocation(size, malloc_usable_size(ptr), 0);
+    return ptr;
+}
+
+static void* counting_realloc(void* ptr, size_t size, void* context) {
+    (void)context;
+    size_t released = ptr ? malloc_usable_size(ptr) : 0;
+    void* grown = previous_allocator.realloc_fn(ptr, size, previous_allocator.context);
+    if (grown) record_allocation(size, malloc_usable_size(grown), released);
+    return grown;
+}
+
+static void counting_free(void* ptr, void* context) {
+    (void)context;
+    atomic_fetch_add_explicit(&stage_counters[alloc_stats_stage].frees, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&live_bytes, (long long)malloc_usable_size(ptr), memory_order_relaxed);
+    previous_allocator.free_fn(ptr, previous_allocator.context);
+}
+
+static const calc_allocator_t COUNTING_ALLOCATOR = { counting_malloc, counting_realloc, counting_free, NULL };
+
+int alloc_stats_enable(void) {
+    if (enabled) return 0;
+    if (!calc_allocator_is_default()) return -1;
+    previous_allocator = *calc_get_allocator();
+    calc_set_allocator(&COUNTING_ALLOCATOR);
+    enabled = true;
+    return 0;
+}
+
+void alloc_stats_disable(void) {
+    if (!enabled) return;
+    calc_set_allocator(&previous_allocator);
+    enabled = false;
+}
+
+void alloc_stats_reset(void) {
+    for (int i = 0; i < ALLOC_STAGE_SLOTS; i++) {
+        atomic_store(&stage_counters[i].allocations, 0);
+        atomic_store(&stage_counters[i].frees, 0);
+        atomic_store(&stage_counters[i].bytes, 0);
+        atomic_store(&stage_counters[i].peak_live_bytes, 0);
+    }
+    atomic_store(&peak_live_bytes, current_live_bytes());
+    atomic_store(&unexpected, 0);
+}
+
+void alloc_stats_forbid(bool forbid) {
+    atomic_store(&forbidden, forbid);
+}
+
+void alloc_stats_report(AllocReport* report) {
+    if (!report) return;
+
+    for (int i = 0; i < ALLOC_STAGE_SLOTS; i++) {
+        report->stages[i].allocations = atomic_load(&stage_counters[i].allocations);
+        report->stages[i].frees = atomic_load(&stage_counters[i].frees);
+        report->stages[i].bytes = atomic_load(&stage_counters[i].bytes);
+        report->stages[i].peak_live_bytes = atomic_load(&stage_counters[i].peak_live_bytes);
+    }
+    report->live_bytes = current_live_bytes();
+    report->peak_live_bytes = atomic_load(&peak_live_bytes);
+    report->unexpected = atomic_load(&unexpected);
+}
+
+void alloc_stats_print(FILE* out) {
+    AllocReport report;
+    alloc_stats_report(&report);
+
+    fprintf(out, "%-12s %12s %12s %14s %16s\n", "stage", "allocations", "frees", "bytes", "peak live bytes");
+    for (int i = 0; i < ALLOC_STAGE_SLOTS; i++) {
+        const AllocCounters* counters = &report.stages[i];
+        fprintf(out, "%-12s %12zu %12zu %14zu %16zu\n", STAGE_NAMES[i],
+                counters->allocations, counters->frees, counters->bytes, counters->peak_live_bytes);
+    }
+    fprintf(out, "Live bytes: %zu, peak: %zu\n", report.live_bytes, report.peak_live_bytes);
+    if (report.unexpected > 0) {
+        fprintf(out, "Unexpected allocations: %zu\n", report.unexpected);
+    }
+}
@@ -0,0 +1,189 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/computation/batch.h"
+#include "../../include/computation/shunt_yard_algo.h"
+#include "../../include/computation/AST_tree.h"
+#include "../../include/computation/optimizer.h"
+#include "../../include/computation/alloc_stats.h"
+#include "../../include/computation/expression_cache.h"
+#include "../../include/datastructures/allocator.h"
+
+typedef struct {
+    BatchEvaluator* evaluator;
+    char* const* lines;
+    BatchResult* results;
+} BatchJob;
+
+bool is_malformed_assignment(const char* input, const TokenizerResult* tokens) {
+    if (strchr(input, '=') == NULL) {
+        return false;
+    }
+    return tokens->token_count < 2 ||
+           tokens->tokens[0].type != TOKEN_VARIABLE ||
+           tokens->tokens[1].type != TOKEN_EQUALITY;
+}
+
+static ParseResult* parse_text(CalcEngine* engine, const char* input) {
+    // Repeated formulas come straight from the engine's expression cache
+    ParseResult* cached = expression_cache_parse(engine, input);
+    if (cached) return cached;
+
+    STAGE_TIMER_START(timer);
+    TokenizerResult tokens = tokenizeQuery(engine, input);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_TOKENIZE, timer);
+    if (tokens.error != TOKEN_SUCCESS || tokens.token_count == 0 || is_malformed_assignment(input, &tokens)) {
+        return NULL;
+    }
+
+    TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_SHUNT_YARD, timer);
+    if (!postfix) {
+        return NULL;
+    }
+
+    ParseResult* ast = parse_expression(engine, postfix);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_PARSE, timer);
+    optimize_parse_result(engine, ast);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_OPTIMIZE, timer);
+    return ast;
+}
+
+BatchResult evaluate_expression_text(CalcEngine* engine, const char* input) {
+    BatchResult result = {0, COMPUTATION_OK};
+
+    calc_engine_reset(engine);
+    ParseResult* ast = parse_text(engine, input);
+
+    STAGE_TIMER_START(timer);
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_EVALUATE);
+    if (!ast || ast->error != AST_OK || !ast->root) {
+        result.error = COMPUTATION_INVALID_OPERATION;
+    } else if (ast->root->token->type == TOKEN_EQUALITY) {
+        result.error = compute_assignment(engine, ast->root, &result.value);
+    } else {
+        result.value = evaluate_ast(ast->root, engine->variables->values, &result.error);
+    }
+    alloc_stats_leave_stage(previous_stage);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_EVALUATE, timer);
+
+    return result;
+}
+
+BatchEvaluator* batch_evaluator_create(CalcEngine* engine, size_t threads) {
+    if (!engine) return NULL;
+
+    BatchEvaluator* evaluator = (BatchEvaluator*)calc_calloc(1, sizeof(BatchEvaluator));
+    if (!evaluator) return NULL;
+
+    evaluator->engine = engine;
+
+    evaluator->pool = ws_pool_create(threads);
+    if (!evaluator->pool) {
+        calc_free(evaluator);
+        return NULL;
+    }
+
+    size_t workers = ws_pool_size(evaluator->pool);
+    evaluator->workers = (CalcEngine**)calc_calloc(workers, sizeof(CalcEngine*));
+    evaluator->worker_versions = (unsigned long*)calc_calloc(workers, sizeof(unsigned long));
+    evaluator->worker_slots = (size_t*)calc_calloc(workers, sizeof(size_t));
+    if (!evaluator->workers || !evaluator->worker_versions || !evaluator->worker_slots) {
+        batch_evaluator_destroy(evaluator);
+        return NULL;
+    }
+    for (size_t i = 0; i < workers; i++) {
+        evaluator->workers[i] = calc_engine_clone(engine);
+        if (!evaluator->workers[i]) {
+            batch_evaluator_destroy(evaluator);
+            return NULL;
+        }
+        evaluator->worker_slots[i] = evaluator->workers[i]->variables->slot_count;
+    }
+    evaluator->variables_version = 1;
+
+    return evaluator;
+}
+
+static int refresh_worker_variables(BatchEvaluator* evaluator) {
+    size_t workers = ws_pool_size(evaluator->pool);
+
+    for (size_t i = 0; i < workers; i++) {
+        if (evaluator->worker_versions[i] == evaluator->variables_version) {
+            continue;
+        }
+        if (calc_engine_copy_variables(evaluator->workers[i], evaluator->engine) != 0) return -1;
+        evaluator->worker_versions[i] = evaluator->variables_version;
+        evaluator->worker_slots[i] = evaluator->workers[i]->variables->slot_count;
+    }
+    return 0;
+}
+
+// Registers the names workers first saw as unknown in the caller's engine, as
+// evaluating the segment serially would have; a later "VAR = ..." then finds
+// VAR already defined, exactly as in a serial run
+static int adopt_worker_names(BatchEvaluator* evaluator) {
+    size_t workers = ws_pool_size(evaluator->pool);
+
+    for (size_t i = 0; i < workers; i++) {
+        const hashmapconst_t* names = evaluator->workers[i]->variables;
+        for (size_t slot = evaluator->worker_slots[i]; slot < names->slot_count; slot++) {
+            const hashmapconst_entry_t* entry = names->slots[slot];
+            if (entry && !hashmapconst_intern(evaluator->engine->variables, entry->name, names->values[slot])) {
+                return -1;
+            }
+        }
+        evaluator->worker_slots[i] = names->slot_count;
+    }
+    return 0;
+}
+
+static void evaluate_line_task(void* context, size_t index, size_t worker) {
+    BatchJob* job = (BatchJob*)context;
+    job->results[index] = evaluate_expression_text(job->evaluator->workers[worker], job->lines[index]);
+}
+
+static int run_segment(BatchEvaluator* evaluator, char* const* lines, size_t count, BatchResult* results) {
+    if (count == 0) return 0;
+    if (refresh_worker_variables(evaluator) != 0) return -1;
+
+    BatchJob job = {evaluator, lines, results};
+    if (ws_pool_run(evaluator->pool, evaluate_line_task, &job, count, 0) != 0) return -1;
+    return adopt_worker_names(evaluator);
+}
+
+int batch_evaluate(BatchEvaluator* evaluator, char* const* lines, size_t count, BatchResult* results) {
+    if (!evaluator || (!lines && count > 0) || (!results && count > 0)) return -1;
+
+    size_t segment_start = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (strchr(lines[i], '=') == NULL) {
+            continue;
+        }
+        if (run_segment(evaluator, lines + segment_start, i - segment_start, results + segment_start) != 0) {
+            return -1;
+        }
+        results[i] = evaluate_expression_text(evaluator->engine, lines[i]);
+        evaluator->variables_version++;
+        segment_start = i + 1;
+    }
+
+    return run_segment(evaluator, lines + segment_start, count - segment_start, results + segment_start);
+}
+
+void batch_evaluator_destroy(BatchEvaluator* evaluator) {
+    if (!evaluator) return;
+
+    size_t workers = ws_pool_size(evaluator->pool);
+    ws_pool_destroy(evaluator->pool);
+    for (size_t i = 0; evaluator->workers && i < workers; i++) {
+        if (evaluator->workers[i]) {
+            stage_stats_merge(evaluator->engine->stage_stats, evaluator->workers[i]->stage_stats);
+            expression_cache_merge_counters(evaluator->engine->expression_cache, evaluator->workers[i]->expression_cache);
+        }
+        calc_engine_destroy(evaluator->workers[i]);
+    }
+    calc_free(evaluator->workers);
+    calc_free(evaluator->worker_versions);
+    calc_free(evaluator->worker_slots);
+    calc_free(evaluator);
+}
@@ -0,0 +1,301 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../../include/computation/bytecode.h"
+#include "../../include/computation/tokenizer.h"
+#include "../../include/datastructures/allocator.h"
+
+#define BYTECODE_INITIAL_CAPACITY 16
+#define DEGREES_TO_RADIANS (3.14159265358979323846 / 180.0)
+
+static const char* OPCODE_NAMES[OP_COUNT] = {
+    "const", "load", "add", "sub", "mul", "div", "pow", "neg",
+    "sin", "cos", "tan", "log", "sqrt", "exp", "abs", "log10", "log2", "logbase"
+};
+
+// Register already holding a node's value, so nodes shared in a DAG are emitted once
+typedef struct {
+    const ASTNode* node;
+    long reg;
+} RegisterMemo;
+
+typedef struct {
+    BytecodeProgram* program;
+    hashmapconst_entry_t* const* variables;
+    size_t variable_count;
+    BytecodeError error;
+    RegisterMemo* memo;             // Open-addressed by node address, NULL if unavailable
+    size_t memo_mask;               // Memo capacity - 1 (capacity is a power of two)
+} BytecodeCompiler;
+
+static size_t memo_slot(const BytecodeCompiler* compiler, const ASTNode* node) {
+    uintptr_t key = (uintptr_t)node;
+    return (size_t)((key >> 4) * 0x9e3779b97f4a7c15ULL) & compiler->memo_mask;
+}
+
+static long memo_find(const BytecodeCompiler* compiler, const ASTNode* node) {
+    if (!compiler->memo) return -1;
+
+    for (size_t i = memo_slot(compiler, node); compiler->memo[i].node; i = (i + 1) & compiler->memo_mask) {
+        if (compiler->memo[i].node == node) {
+            return compiler->memo[i].reg;
+        }
+    }
+    return -1;
+}
+
+static void memo_store(BytecodeCompiler* compiler, const ASTNode* node, long reg) {
+    if (!compiler->memo || reg < 0) return;
+
+    size_t i = memo_slot(compiler, node);
+    while (compiler->memo[i].node) i = (i + 1) & compiler->memo_mask;
+    compiler->memo[i].node = node;
+    compiler->memo[i].reg = reg;
+}
+
+// Nodes of the tree a DAG stands for (shared nodes counted per use): an upper bound on distinct nodes
+static size_t count_uses(const ASTNode* node) {
+    if (!node) return 0;
+    return 1 + count_uses(node->left) + count_uses(node->right) + count_uses(node->child);
+}
+
+static long emit(BytecodeCompiler* compiler, Instruction instruction) {
+    BytecodeProgram* program = compiler->program;
+
+    if (program->length >= program->capacity) {
+        size_t new_capacity = program->capacity * 2;
+        Instruction* new_code = (Instruction*)calc_realloc(program->code, new_capacity * sizeof(Instruction));
+        if (!new_code) {
+            compiler->error = BYTECODE_MEMORY_ERROR;
+            return -1;
+        }
+        program->code = new_code;
+        program->capacity = new_capacity;
+    }
+
+    program->code[program->length] = instruction;
+    return (long)program->length++;
+}
+
+static long emit_operation(BytecodeCompiler* compiler, OpCode op, long a, long b) {
+    if (a < 0 || b < 0) return -1;
+
+    Instruction instruction = {0};
+    instruction.op = op;
+    instruction.arg.operands.a = (uint32_t)a;
+    instruction.arg.operands.b = (uint32_t)b;
+    return emit(compiler, instruction);
+}
+
+static long compile_failed(BytecodeCompiler* compiler, BytecodeError error) {
+    if (compiler->error == BYTECODE_OK) {
+        compiler->error = error;
+    }
+    return -1;
+}
+
+// Opcode for each FunctionId
+static const OpCode FUNCTION_OPCODES[FUNC_COUNT] = {
+    [FUNC_SIN] = OP_SIN,
+    [FUNC_COS] = OP_COS,
+    [FUNC_TAN] = OP_TAN,
+    [FUNC_LOG] = OP_LOG,
+    [FUNC_SQRT] = OP_SQRT,
+    [FUNC_EXP] = OP_EXP,
+    [FUNC_ABS] = OP_ABS,
+    [FUNC_LOG10] = OP_LOG10,
+    [FUNC_LOG2] = OP_LOG2,
+    [FUNC_LOGE] = OP_LOG,
+    [FUNC_LOGBASE] = OP_LOGBASE,
+};
+
+static long compile_uncached(BytecodeCompiler* compiler, const ASTNode* node);
+
+static long compile_node(BytecodeCompiler* compiler, const ASTNode* node) {
+    if (!node || !node->token) {
+        return compile_failed(compiler, BYTECODE_INVALID_NODE);
+    }
+
+    long reg = memo_find(compiler, node);
+    if (reg >= 0) return reg;
+
+    reg = compile_uncached(compiler, node);
+    memo_store(compiler, node, reg);
+    return reg;
+}
+
+static long compile_uncached(BytecodeCompiler* compiler, const ASTNode* node) {
+
+    const Token* token = node->token;
+    Instruction instruction = {0};
+
+    switch (token->type) {
+        case TOKEN_NUMBER:
+            instruction.op = OP_CONST;
+            instruction.arg.value = token->data.num_value;
+            return emit(compiler, instruction);
+
+        case TOKEN_VARIABLE:
+            for (size_t i = 0; i < compiler->variable_count; i++) {
+                if (compiler->variables[i] == token->data.var_name) {
+                    instruction.op = OP_LOAD_VAR;
+                    instruction.arg.operands.a = (uint32_t)i;
+                    return emit(compiler, instruction);
+                }
+            }
+            return compile_failed(compiler, BYTECODE_UNKNOWN_VARIABLE);
+
+        case TOKEN_OPERATOR: {
+            long left = compile_node(compiler, node->left);
+            long right = compile_node(compiler, node->right);
+            switch (token->data.operator_value) {
+                case '+': return emit_operation(compiler, OP_ADD, left, right);
+                case '-': return emit_operation(compiler, OP_SUB, left, right);
+                case '*': return emit_operation(compiler, OP_MUL, left, right);
+                case '/': return emit_operation(compiler, OP_DIV, left, right);
+                case '^': return emit_operation(compiler, OP_POW, left, right);
+                default:  return compile_failed(compiler, BYTECODE_INVALID_NODE);
+            }
+        }
+
+        case TOKEN_UNARY: {
+            long operand = compile_node(compiler, node->child);
+            if (token->data.unary_operator == TOKEN_UNARY_POSITIVE) {
+                return operand;
+            }
+            return emit_operation(compiler, OP_NEG, operand, 0);
+        }
+
+        case TOKEN_FUNCTION: {
+            if (!token->data.function || token->data.function->id >= FUNC_COUNT) {
+                return compile_failed(compiler, BYTECODE_UNKNOWN_FUNCTION);
+            }
+            OpCode op = FUNCTION_OPCODES[token->data.function->id];
+            if (op == OP_LOGBASE) {
+                long base = compile_node(compiler, node->left);
+                long value = compile_node(compiler, node->right);
+                return emit_operation(compiler, op, base, value);
+            }
+            return emit_operation(compiler, op, compile_node(compiler, node->child), 0);
+        }
+
+        default:
+            return compile_failed(compiler, BYTECODE_INVALID_NODE);
+    }
+}
+
+BytecodeProgram* bytecode_compile(const ASTNode* root, hashmapconst_entry_t* const* variables, size_t variable_count, BytecodeError* error) {
+    if (!root) {
+        if (error) *error = BYTECODE_NULL_INPUT;
+        return NULL;
+    }
+
+    BytecodeProgram* program = (BytecodeProgram*)calc_calloc(1, sizeof(BytecodeProgram));
+    if (!program) {
+        if (error) *error = BYTECODE_MEMORY_ERROR;
+        return NULL;
+    }
+
+    program->capacity = BYTECODE_INITIAL_CAPACITY;
+    program->code = (Instruction*)calc_malloc(program->capacity * sizeof(Instruction));
+    if (!program->code) {
+        bytecode_free(program);
+        if (error) *error = BYTECODE_MEMORY_ERROR;
+        return NULL;
+    }
+
+    // Without the memo a DAG is still compiled correctly, just as the tree it stands for
+    size_t memo_capacity = 16;
+    size_t uses = count_uses(root);
+    while (memo_capacity < uses * 2) memo_capacity *= 2;
+
+    BytecodeCompiler compiler = {program, variables, variable_count, BYTECODE_OK, NULL, memo_capacity - 1};
+    compiler.memo = (RegisterMemo*)calc_calloc(memo_capacity, sizeof(RegisterMemo));
+    compile_node(&compiler, root);
+    calc_free(compiler.memo);
+
+    if (compiler.error == BYTECODE_OK) {
+        program->registers = (double*)calc_malloc(program->length * sizeof(double));
+        if (!program->registers) {
+            compiler.error = BYTECODE_MEMORY_ERROR;
+        }
+    }
+
+    if (compiler.error != BYTECODE_OK) {
+        bytecode_free(program);
+        if (error) *error = compiler.error;
+        return NULL;
+    }
+
+    if (error) *error = BYTECODE_OK;
+    return program;
+}
+
+double bytecode_run(const BytecodeProgram* program, const double* variables, double* r) {
+    const Instruction* code = program->code;
+    size_t length = program->length;
+
+    for (size_t i = 0; i < length; i++) {
+        const Instruction* in = &code[i];
+        uint32_t a = in->arg.operands.a;
+        uint32_t b = in->arg.operands.b;
+
+        switch ((OpCode)in->op) {
+            case OP_CONST:    r[i] = in->arg.value; break;
+            case OP_LOAD_VAR: r[i] = variables[a]; break;
+            case OP_ADD:      r[i] = r[a] + r[b]; break;
+            case OP_SUB:      r[i] = r[a] - r[b]; break;
+            case OP_MUL:      r[i] = r[a] * r[b]; break;
+            case OP_DIV:      r[i] = r[a] / r[b]; break;
+            case OP_POW:      r[i] = pow(r[a], r[b]); break;
+            case OP_NEG:      r[i] = -r[a]; break;
+            case OP_SIN:      r[i] = sin(r[a] * DEGREES_TO_RADIANS); break;
+            case OP_COS:      r[i] = cos(r[a]); break;
+            case OP_TAN:      r[i] = tan(r[a]); break;
+            case OP_LOG:      r[i] = log(r[a]); break;
+            case OP_SQRT:     r[i] = sqrt(r[a]); break;
+            case OP_EXP:      r[i] = exp(r[a]); break;
+            case OP_ABS:      r[i] = fabs(r[a]); break;
+            case OP_LOG10:    r[i] = log10(r[a]); break;
+            case OP_LOG2:     r[i] = log2(r[a]); break;
+            case OP_LOGBASE:  r[i] = log(r[b]) / log(r[a]); break;
+            default:          r[i] = NAN; break;
+        }
+    }
+
+    return length > 0 ? r[length - 1] : NAN;
+}
+
+double bytecode_evaluate(BytecodeProgram* program, const double* variables) {
+    if (!program) return NAN;
+    return bytecode_run(program, variables, program->registers);
+}
+
+void bytecode_print(const BytecodeProgram* program) {
+    if (!program) return;
+
+    for (size_t i = 0; i < program->length; i++) {
+        const Instruction* in = &program->code[i];
+        const char* name = in->op < OP_COUNT ? OPCODE_NAMES[in->op] : "?";
+
+        if (in->op == OP_CONST) {
+            fprintf(stderr, "r%-4zu = %-8s %g\n", i, name, in->arg.value);
+        } else if (in->op == OP_LOAD_VAR) {
+            fprintf(stderr, "r%-4zu = %-8s var[%u]\n", i, name, in->arg.operands.a);
+        } else if (in->op == OP_ADD || in->op == OP_SUB || in->op == OP_MUL || in->op == OP_DIV ||
+                   in->op == OP_POW || in->op == OP_LOGBASE) {
+            fprintf(stderr, "r%-4zu = %-8s r%u, r%u\n", i, name, in->arg.operands.a, in->arg.operands.b);
+        } else {
+            fprintf(stderr, "r%-4zu = %-8s r%u\n", i, name, in->arg.operands.a);
+        }
+    }
+}
+
+void bytecode_free(BytecodeProgram* program) {
+    if (!program) return;
+
+    calc_free(program->code);
+    calc_free(program->registers);
+    calc_free(program);
+}
@@ -0,0 +1,251 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "../../include/computation/bytecode.h"
+#include "../../include/datastructures/allocator.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTECODE_HAVE_X86 1
+#endif
+
+#define DEGREES_TO_RADIANS (3.14159265358979323846 / 180.0)
+
+typedef void (*BinaryKernel)(const double* a, const double* b, double* out, size_t n);
+typedef void (*UnaryKernel)(const double* a, double* out, size_t n);
+
+typedef struct {
+    BinaryKernel add;
+    BinaryKernel sub;
+    BinaryKernel mul;
+    BinaryKernel div;
+    UnaryKernel neg;
+    UnaryKernel abs;
+    UnaryKernel sqrt;
+    const char* name;
+} ColumnKernels;
+
+#define DEFINE_SCALAR_BINARY(NAME, EXPR)                                              \
+    static void NAME##_scalar(const double* a, const double* b, double* out, size_t n) { \
+        for (size_t i = 0; i < n; i++) out[i] = (EXPR);                               \
+    }
+
+#define DEFINE_SCALAR_UNARY(NAME, EXPR)                                  \
+    static void NAME##_scalar(const double* a, double* out, size_t n) {   \
+        for (size_t i = 0; i < n; i++) out[i] = (EXPR);                  \
+    }
+
+DEFINE_SCALAR_BINARY(add, a[i] + b[i])
+DEFINE_SCALAR_BINARY(sub, a[i] - b[i])
+DEFINE_SCALAR_BINARY(mul, a[i] * b[i])
+DEFINE_SCALAR_BINARY(div, a[i] / b[i])
+DEFINE_SCALAR_UNARY(neg, -a[i])
+DEFINE_SCALAR_UNARY(abs, fabs(a[i]))
+DEFINE_SCALAR_UNARY(sqrt, sqrt(a[i]))
+
+#ifdef BYTECODE_HAVE_X86
+#define DEFINE_SSE2_BINARY(NAME, INTRINSIC)                                               \
+    static void NAME##_sse2(const double* a, const double* b, double* out, size_t n) {   \
+        size_t i = 0;                                                                    \
+        for (; i + 2 <= n; i += 2) {                                                     \
+            _mm_storeu_pd(out + i, INTRINSIC(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i))); \
+        }                                                                                \
+        NAME##_scalar(a + i, b + i, out + i, n - i);                                     \
+    }
+
+#define DEFINE_AVX2_BINARY(NAME, INTRINSIC)                                                     \
+    __attribute__((target("avx2")))                                                            \
+    static void NAME##_avx2(const double* a, const double* b, double* out, size_t n) {         \
+        size_t i = 0;                                                                          \
+        for (; i + 4 <= n; i += 4) {                                                           \
+            _mm256_storeu_pd(out + i, INTRINSIC(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))); \
+        }                                                                                      \
+        NAME##_scalar(a + i, b + i, out + i, n - i);                                           \
+    }
+
+DEFINE_SSE2_BINARY(add, _mm_add_pd)
+DEFINE_SSE2_BINARY(sub, _mm_sub_pd)
+DEFINE_SSE2_BINARY(mul, _mm_mul_pd)
+DEFINE_SSE2_BINARY(div, _mm_div_pd)
+DEFINE_AVX2_BINARY(add, _mm256_add_pd)
+DEFINE_AVX2_BINARY(sub, _mm256_sub_pd)
+DEFINE_AVX2_BINARY(mul, _mm256_mul_pd)
+DEFINE_AVX2_BINARY(div, _mm256_div_pd)
+
+static void neg_sse2(const double* a, double* out, size_t n) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_xor_pd(_mm_loadu_pd(a + i), sign));
+    neg_scalar(a + i, out + i, n - i);
+}
+
+static void abs_sse2(const double* a, double* out, size_t n) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_andnot_pd(sign, _mm_loadu_pd(a + i)));
+    abs_scalar(a + i, out + i, n - i);
+}
+
+static void sqrt_sse2(const double* a, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(a + i)));
+    sqrt_scalar(a + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void neg_avx2(const double* a, double* out, size_t n) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), sign));
+    neg_scalar(a + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void abs_avx2(const double* a, double* out, size_t n) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_andnot_pd(sign, _mm256_loadu_pd(a + i)));
+    abs_scalar(a + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void sqrt_avx2(const double* a, double* out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(a + i)));
+    sqrt_scalar(a + i, out + i, n - i);
+}
+#endif
+
+static const ColumnKernels SCALAR_KERNELS = {
+    add_scalar, sub_scalar, mul_scalar, div_scalar, neg_scalar, abs_scalar, sqrt_scalar, "scalar"
+};
+
+#ifdef BYTECODE_HAVE_X86
+static const ColumnKernels SSE2_KERNELS = {
+    add_sse2, sub_sse2, mul_sse2, div_sse2, neg_sse2, abs_sse2, sqrt_sse2, "sse2"
+};
+
+static const ColumnKernels AVX2_KERNELS = {
+    add_avx2, sub_avx2, mul_avx2, div_avx2, neg_avx2, abs_avx2, sqrt_avx2, "avx2"
+};
+#endif
+
+static const ColumnKernels* active_kernels = &SCALAR_KERNELS;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void detect_kernels(void) {
+#ifdef BYTECODE_HAVE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        active_kernels = &AVX2_KERNELS;
+    } else if (__builtin_cpu_supports("sse2")) {
+        active_kernels = &SSE2_KERNELS;
+    }
+#endif
+}
+
+// Column evaluation can start on several threads at once; pthread_once makes
+// the first caller's detection visible to all of them
+static const ColumnKernels* select_kernels(void) {
+    pthread_once(&kernels_once, detect_kernels);
+    return active_kernels;
+}
+
+const char* bytecode_column_isa(void) {
+    return select_kernels()->name;
+}
+
+static void apply_unary_libm(OpCode op, const double* a, double* out, size_t n) {
+    switch (op) {
+        case OP_SIN:   for (size_t i = 0; i < n; i++) out[i] = sin(a[i] * DEGREES_TO_RADIANS); break;
+        case OP_COS:   for (size_t i = 0; i < n; i++) out[i] = cos(a[i]); break;
+        case OP_TAN:   for (size_t i = 0; i < n; i++) out[i] = tan(a[i]); break;
+        case OP_LOG:   for (size_t i = 0; i < n; i++) out[i] = log(a[i]); break;
+        case OP_EXP:   for (size_t i = 0; i < n; i++) out[i] = exp(a[i]); break;
+        case OP_LOG10: for (size_t i = 0; i < n; i++) out[i] = log10(a[i]); break;
+        case OP_LOG2:  for (size_t i = 0; i < n; i++) out[i] = log2(a[i]); break;
+        default:       for (size_t i = 0; i < n; i++) out[i] = NAN; break;
+    }
+}
+
+static bool is_constant(const BytecodeProgram* program, uint32_t reg, double value) {
+    const Instruction* in = &program->code[reg];
+    return in->op == OP_CONST && in->arg.value == value;
+}
+
+int bytecode_run_columns(const BytecodeProgram* program, const double* const* columns, size_t rows, double* out) {
+    if (!program || !out || program->length == 0) return -1;
+    if (rows == 0) return 0;
+
+    const ColumnKernels* k = select_kernels();
+    size_t length = program->length;
+    size_t last = length - 1;
+
+    // reg[i] points at the current block of register i: constants at a block
+    // filled once, variables straight into their column, everything else at scratch
+    const double** reg = (const double**)calc_malloc(length * sizeof(double*));
+    double* scratch = (double*)calc_malloc(length * BYTECODE_COLUMN_BLOCK * sizeof(double));
+    if (!reg || !scratch) {
+        calc_free(reg);
+        calc_free(scratch);
+        return -1;
+    }
+
+    for (size_t i = 0; i < length; i++) {
+        if (program->code[i].op == OP_CONST) {
+            double* block = scratch + i * BYTECODE_COLUMN_BLOCK;
+            for (size_t j = 0; j < BYTECODE_COLUMN_BLOCK; j++) block[j] = program->code[i].arg.value;
+            reg[i] = block;
+        }
+    }
+
+    for (size_t offset = 0; offset < rows; offset += BYTECODE_COLUMN_BLOCK) {
+        size_t n = rows - offset < BYTECODE_COLUMN_BLOCK ? rows - offset : BYTECODE_COLUMN_BLOCK;
+
+        for (size_t i = 0; i < length; i++) {
+            const Instruction* in = &program->code[i];
+            uint32_t a = in->arg.operands.a;
+            uint32_t b = in->arg.operands.b;
+            double* dst = (i == last) ? out + offset : scratch + i * BYTECODE_COLUMN_BLOCK;
+
+            switch ((OpCode)in->op) {
+                case OP_CONST:
+                    continue;
+                case OP_LOAD_VAR:
+                    reg[i] = columns[a] + offset;
+                    continue;
+                case OP_ADD: k->add(reg[a], reg[b], dst, n); break;
+                case OP_SUB: k->sub(reg[a], reg[b], dst, n); break;
+                case OP_MUL: k->mul(reg[a], reg[b], dst, n); break;
+                case OP_DIV: k->div(reg[a], reg[b], dst, n); break;
+                case OP_NEG: k->neg(reg[a], dst, n); break;
+                case OP_ABS: k->abs(reg[a], dst, n); break;
+                case OP_SQRT: k->sqrt(reg[a], dst, n); break;
+                case OP_POW:
+                    if (is_constant(program, b, 2.0)) {
+                        k->mul(reg[a], reg[a], dst, n);
+                    } else {
+                        for (size_t j = 0; j < n; j++) dst[j] = pow(reg[a][j], reg[b][j]);
+                    }
+                    break;
+                case OP_LOGBASE:
+                    for (size_t j = 0; j < n; j++) dst[j] = log(reg[b][j]) / log(reg[a][j]);
+                    break;
+                default:
+                    apply_unary_libm((OpCode)in->op, reg[a], dst, n);
+                    break;
+            }
+            reg[i] = dst;
+        }
+
+        const Instruction* tail = &program->code[last];
+        if (tail->op == OP_CONST || tail->op == OP_LOAD_VAR) {
+            memcpy(out + offset, reg[last], n * sizeof(double));
+        }
+    }
+
+    calc_free(reg);
+    calc_free(scratch);
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "../../include/computation/compiled_expression.h"
+#include "../../include/computation/shunt_yard_algo.h"
+#include "../../include/computation/AST_tree.h"
+#include "../../include/computation/computation.h"
+#include "../../include/computation/optimizer.h"
+#include "../../include/datastructures/allocator.h"
+
+static CompiledExpression* compile_failed(CompiledExpression* expr, CompileError status, CompileError* error) {
+    if (error) *error = status;
+    compiled_expression_free(expr);
+    return NULL;
+}
+
+static bool has_variable_slot(const CompiledExpression* expr, const hashmapconst_entry_t* entry) {
+    for (size_t i = 0; i < expr->variable_count; i++) {
+        if (expr->variables[i] == entry) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs the stages with the handle's arena in place of the engine's, so the
+// tree outlives later resets of the engine
+static CompiledExpression* compile_into(CalcEngine* engine, CompiledExpression* expr, const char* input,
+                                        const char* const* var_names, size_t var_count, CompileError* error) {
+    for (size_t i = 0; i < var_count; i++) {
+        char* lowered = calc_strdup(var_names[i]);
+        if (!lowered) {
+            return compile_failed(expr, COMPILE_MEMORY_ERROR, error);
+        }
+        to_lowercase(lowered, strlen(lowered));
+        // A repeated name would take one slot but two positions, shifting every later variable
+        bool duplicate = hashmapconst_contains(expr->symbols, lowered);
+        if (!duplicate) {
+            hashmapconst_add(expr->symbols, lowered, 0.0);
+        }
+        calc_free(lowered);
+        if (duplicate) {
+            return compile_failed(expr, COMPILE_DUPLICATE_VARIABLE, error);
+        }
+    }
+
+    TokenizerResult tokens = tokenizeQuerySymbols(engine, input, expr->symbols);
+    if (tokens.error != TOKEN_SUCCESS) {
+        return compile_failed(expr, COMPILE_TOKENIZER_ERROR, error);
+    }
+
+    for (size_t i = 0; i < tokens.token_count; i++) {
+        if (tokens.tokens[i].type == TOKEN_EQUALITY) {
+            return compile_failed(expr, COMPILE_ASSIGNMENT, error);
+        }
+    }
+
+    expr->postfix = shunt_yard_algo(engine, &tokens);
+    if (!expr->postfix || expr->postfix->error != TOKEN_SUCCESS) {
+        return compile_failed(expr, COMPILE_SYNTAX_ERROR, error);
+    }
+
+    expr->ast = parse_expression(engine, expr->postfix);
+    if (!expr->ast || expr->ast->error != AST_OK || !expr->ast->root) {
+        return compile_failed(expr, COMPILE_SYNTAX_ERROR, error);
+    }
+    optimize_parse_result(engine, expr->ast);
+    expr->ast->root = share_common_subexpressions(engine->arena, expr->ast->root, &expr->merged_nodes);
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_TRACE)) {
+        fprintf(stderr, "Merged %zu common subexpression nodes\n", expr->merged_nodes);
+    }
+
+    expr->variables = (hashmapconst_entry_t**)calc_malloc(sizeof(hashmapconst_entry_t*) * (var_count + expr->postfix->token_count + 1));
+    if (!expr->variables) {
+        return compile_failed(expr, COMPILE_MEMORY_ERROR, error);
+    }
+
+    for (size_t i = 0; i < var_count; i++) {
+        int index = compiled_expression_variable_index(expr, var_names[i]);
+        hashmapconst_entry_t* entry = NULL;
+        if (index < 0) {
+            char* lowered = calc_strdup(var_names[i]);
+            if (!lowered) {
+                return compile_failed(expr, COMPILE_MEMORY_ERROR, error);
+            }
+            to_lowercase(lowered, strlen(lowered));
+            entry = hashmapconst_get_entry(expr->symbols, lowered);
+            calc_free(lowered);
+        }
+        if (entry) {
+            expr->variables[expr->variable_count++] = entry;
+        }
+    }
+
+    for (size_t i = 0; i < expr->postfix->token_count; i++) {
+        const Token* token = &expr->postfix->tokens[i];
+        if (token->type == TOKEN_VARIABLE && !has_variable_slot(expr, token->data.var_name)) {
+            expr->variables[expr->variable_count++] = token->data.var_name;
+        }
+    }
+
+    expr->values = (double*)calc_calloc(expr->variable_count + 1, sizeof(double));
+    if (!expr->values) {
+        return compile_failed(expr, COMPILE_MEMORY_ERROR, error);
+    }
+
+    BytecodeError bytecode_error;
+    expr->program = bytecode_compile(expr->ast->root, expr->variables, expr->variable_count, &bytecode_error);
+    if (!expr->program) {
+        return compile_failed(expr, bytecode_error == BYTECODE_MEMORY_ERROR ? COMPILE_MEMORY_ERROR : COMPILE_SYNTAX_ERROR, error);
+    }
+
+    if (error) *error = COMPILE_OK;
+    return expr;
+}
+
+CompiledExpression* compile_expression(CalcEngine* engine, const char* input, const char* const* var_names, size_t var_count, CompileError* error) {
+    if (!engine || !input || strlen(input) == 0) {
+        return compile_failed(NULL, COMPILE_NULL_INPUT, error);
+    }
+
+    CompiledExpression* expr = (CompiledExpression*)calc_calloc(1, sizeof(CompiledExpression));
+    if (!expr) {
+        return compile_failed(NULL, COMPILE_MEMORY_ERROR, error);
+    }
+
+    expr->symbols = hashmapconst_create();
+    expr->arena = arena_create();
+    if (!expr->symbols || !expr->arena) {
+        return compile_failed(expr, COMPILE_MEMORY_ERROR, error);
+    }
+
+    arena_t* session_arena = engine->arena;
+    engine->arena = expr->arena;
+    CompiledExpression* compiled = compile_into(engine, expr, input, var_names, var_count, error);
+    engine->arena = session_arena;
+    return compiled;
+}
+
+int compiled_expression_variable_index(const CompiledExpression* expr, const char* name) {
+    if (!expr || !name) return -1;
+
+    for (size_t i = 0; i < expr->variable_count; i++) {
+        if (strcasecmp(expr->variables[i]->name, name) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+void compiled_expression_set_variable(CompiledExpression* expr, size_t index, double value) {
+    if (!expr || index >= expr->variable_count) return;
+    expr->values[index] = value;
+    expr->symbols->values[expr->variables[index]->slot] = value;
+}
+
+JitFunction compiled_expression_enable_jit(CompiledExpression* expr) {
+    if (!expr || !expr->program) return NULL;
+
+    if (!expr->jit) {
+        expr->jit = jit_compile(expr->program);
+    }
+    return expr->jit ? expr->jit->function : NULL;
+}
+
+ComputationResult compiled_expression_evaluate(CompiledExpression* expr) {
+    ComputationResult result = {0};
+
+    if (!expr || !expr->program) {
+        result.error = COMPUTATION_NULL_INPUT;
+        result.error_msg = "No compiled expression provided";
+        return result;
+    }
+
+    result.root = expr->ast->root;
+    result.value = expr->jit ? expr->jit->function(expr->values)
+                             : bytecode_evaluate(expr->program, expr->values);
+    return result;
+}
+
+int compiled_expression_evaluate_columns(const CompiledExpression* expr, const double* const* columns, size_t rows, double* out) {
+    if (!expr || !expr->program || (expr->variable_count > 0 && !columns)) return -1;
+    return bytecode_run_columns(expr->program, columns, rows, out);
+}
+
+void compiled_expression_free(CompiledExpression* expr) {
+    if (!expr) return;
+
+    arena_destroy(expr->arena);
+    bytecode_free(expr->program);
+    jit_free(expr->jit);
+    calc_free(expr->values);
+    calc_free(expr->variables);
+    hashmapconst_destroy(expr->symbols);
+    calc_free(expr);
+}
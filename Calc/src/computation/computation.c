@@ -7,6 +7,11 @@
 #include "../../include/computation/tokenizer.h"
 #define M_PI 3.14159265358979323846
 #include "../../include/datastructures/hashmapforconst.h"
+#include "../../include/computation/engine.h"
+#include "../../include/datastructures/allocator.h"
+#include "../../include/computation/alloc_stats.h"
+#include "../../include/computation/reactive.h"
+#include "../../include/computation/result_sink.h"
 
 void print_token_just_val_test(ASTNode* node) {
     switch (node->token->type) {
@@ -17,10 +22,10 @@ void print_token_just_val_test(ASTNode* node) {
             fprintf(stderr, "%c ", node->token->data.operator_value); 
             break;
         case TOKEN_FUNCTION: 
-            fprintf(stderr, "%s ", node->token->data.function_name->value); 
+            fprintf(stderr, "%s ", node->token->data.function->name); 
             break;
         case TOKEN_VARIABLE: 
-            fprintf(stderr, "%s(%f) ", node->token->data.var_name->name,node->token->data.var_name->input_value); 
+            fprintf(stderr, "%s ", node->token->data.var_name->name); 
             break;
         case TOKEN_PARENTHESIS:
         case TOKEN_EQUALITY:
@@ -53,7 +58,7 @@ void print_tree_recursive_test(ASTNode* node, int level, char* prefix, bool is_l
         fprintf(stderr, "\n");
     }
 
-    char* new_prefix = malloc(strlen(prefix) + 5);
+    char* new_prefix = calc_malloc(strlen(prefix) + 5);
     strncpy(new_prefix, prefix, strlen(prefix) + 1);
     strncat(new_prefix, is_last ? "    " : "│   ", 4);
 
@@ -64,22 +69,24 @@ void print_tree_recursive_test(ASTNode* node, int level, char* prefix, bool is_l
         print_tree_recursive(node->right, level + 1, new_prefix, true);
     }
 
-    free(new_prefix);
+    calc_free(new_prefix);
 }
 
 void print_tree_test(ASTNode* root) {
     print_tree_recursive_test(root, 0, "", true);
 }
 
-void traversal(ASTNode* node) {
+void traversal(ASTNode* node, const double* variables) {
     if(node == NULL) {
         return;
     }
 
-    traversal(node->left);
+    traversal(node->left, variables);
     if(node->right!=NULL) {
-        traversal(node->right);
+        traversal(node->right, variables);
     }
+    // Function arguments and unary operands hang off child
+    traversal(node->child, variables);
     
     if(node->token->type == TOKEN_OPERATOR) 
     {
@@ -122,145 +129,31 @@ void traversal(ASTNode* node) {
         return;
     }
     else if(node->token->type == TOKEN_VARIABLE) {
+        double data_computed = variables[node->token->slot];
+        node->token->type=TOKEN_NUMBER;
+        node->token->data.num_value=data_computed;
         return;
     }
     else if(node->token->type == TOKEN_FUNCTION) {  
-        if (strcmp(node->token->data.function_name->value, "logbase") == 0)
+        const FunctionInfo* function = node->token->data.function;
+        double data_computed = 0;
+        if (function->arity == 2)
         {
             if (!node->left || !node->right || !node->left->token || !node->right->token) {
                 return;
             }
-            
-            double data_computed = 0;
-            data_computed = log(node->right->token->data.num_value)/log(node->left->token->data.num_value);
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-        }
-        else if(strcmp(node->token->data.function_name->value, "sin") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            double radians = (node->child->token->data.num_value * M_PI) / 180.0;
-            data_computed = sin(radians);
-            
-            node->token->type = TOKEN_NUMBER;
-            node->token->data.num_value = data_computed;
-            print_tree_test(node);
-        }
-        else if(strcmp(node->token->data.function_name->value, "cos") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = cos((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-        }
-        else if(strcmp(node->token->data.function_name->value, "tan") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = tan((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-        }
-        else if(strcmp(node->token->data.function_name->value, "log") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = log((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-        }
-        else if(strcmp(node->token->data.function_name->value, "sqrt") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = sqrt((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-        }
-        else if(strcmp(node->token->data.function_name->value, "exp") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = exp((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-        }
-        else if(strcmp(node->token->data.function_name->value, "abs") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = fabs((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-    }
-        else if(strcmp(node->token->data.function_name->value, "log10") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = log10((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
-        }
-        else if(strcmp(node->token->data.function_name->value, "log2") == 0) 
-        {
-            if (!node->child || !node->child->token) {
-                return;
-            }
-            
-            double data_computed = 0;
-            data_computed = log2((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
+            data_computed = function->binary(node->left->token->data.num_value, node->right->token->data.num_value);
         }
-        else if(strcmp(node->token->data.function_name->value, "loge") == 0) 
+        else
         {
             if (!node->child || !node->child->token) {
                 return;
             }
-            
-            double data_computed = 0;
-            data_computed = log((node->child->token->data.num_value));
-            
-            node->token->type=TOKEN_NUMBER;
-            node->token->data.num_value=data_computed;
+            data_computed = function->unary(node->child->token->data.num_value);
         }
+
+        node->token->type = TOKEN_NUMBER;
+        node->token->data.num_value = data_computed;
         return;
     }
     else if(node->token->type == TOKEN_UNARY) {
@@ -282,18 +175,92 @@ void traversal(ASTNode* node) {
     }
 }
 
-ComputationResult compute_ast(ParseResult* result) {
+static double evaluate_failed(ComputationError* error, ComputationError reason) {
+    if (error && *error == COMPUTATION_OK) {
+        *error = reason;
+    }
+    return NAN;
+}
+
+static double evaluate_function(const ASTNode* node, const double* variables, ComputationError* error) {
+    const FunctionInfo* function = node->token->data.function;
+    if (!function) {
+        return evaluate_failed(error, COMPUTATION_UNDEFINED_FUNCTION);
+    }
+
+    if (function->arity == 2) {
+        if (!node->left || !node->right) {
+            return evaluate_failed(error, COMPUTATION_INVALID_OPERATION);
+        }
+        double base = evaluate_ast(node->left, variables, error);
+        double value = evaluate_ast(node->right, variables, error);
+        return function->binary(base, value);
+    }
+
+    if (!node->child) {
+        return evaluate_failed(error, COMPUTATION_INVALID_OPERATION);
+    }
+    return function->unary(evaluate_ast(node->child, variables, error));
+}
+
+double evaluate_ast(const ASTNode* node, const double* variables, ComputationError* error) {
+    if (!node || !node->token) {
+        return evaluate_failed(error, COMPUTATION_NULL_INPUT);
+    }
+
+    const Token* token = node->token;
+    switch (token->type) {
+        case TOKEN_NUMBER:
+            return token->data.num_value;
+
+        case TOKEN_VARIABLE:
+            return variables[token->slot];
+
+        case TOKEN_OPERATOR: {
+            if (!node->left || !node->right) {
+                return evaluate_failed(error, COMPUTATION_INVALID_OPERATION);
+            }
+            double left = evaluate_ast(node->left, variables, error);
+            double right = evaluate_ast(node->right, variables, error);
+            switch (token->data.operator_value) {
+                case '+': return left + right;
+                case '-': return left - right;
+                case '*': return left * right;
+                case '/': return left / right;
+                case '^': return pow(left, right);
+                default:  return evaluate_failed(error, COMPUTATION_INVALID_OPERATION);
+            }
+        }
+
+        case TOKEN_UNARY: {
+            if (!node->child) {
+                return evaluate_failed(error, COMPUTATION_INVALID_OPERATION);
+            }
+            double operand = evaluate_ast(node->child, variables, error);
+            return token->data.unary_operator == TOKEN_UNARY_NEGATIVE ? -operand : operand;
+        }
+
+        case TOKEN_FUNCTION:
+            return evaluate_function(node, variables, error);
+
+        default:
+            return evaluate_failed(error, COMPUTATION_INVALID_OPERATION);
+    }
+}
+
+static ComputationResult compute(CalcEngine* engine, ParseResult* result) {
     ComputationResult ans;
     ans.error = COMPUTATION_OK;
     ans.error_msg = NULL;
     ans.value = 0;
-    ans.root = result->root;
+    ans.root = NULL;
 
-    if(result == NULL) {
+    if(engine == NULL || result == NULL || result->root == NULL) {
         ans.error = COMPUTATION_NULL_INPUT;
         ans.error_msg = "No root node provided";
         return ans;
     }
+    ans.root = result->root;
 
     if(result->error != AST_OK) {  
         ans.error = COMPUTATION_INVALID_OPERATION;
@@ -303,20 +270,42 @@ ComputationResult compute_ast(ParseResult* result) {
 
     if(result->root->token->type == TOKEN_EQUALITY)
     {
-      traversal(result->root->right);
-      ans.value = result->root->right->token->data.num_value;
-      hashmapconst_update(VARIABLES, result->root->left->token->data.var_name->name,ans.value);
-      ans.value = result->root->right->token->data.num_value;
-      result->root->token->type=TOKEN_NUMBER;
-      result->root->token->data.num_value=ans.value;
+      ans.error = compute_assignment(engine, result->root, &ans.value);
     }
     else{
-    traversal(result->root);
-    print_tree(result);
-    ans.value = result->root->token->data.num_value;
+    ans.value = evaluate_ast(result->root, engine->variables->values, &ans.error);
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_TREE)) {
+        print_tree(result);
+    }
   }
-    FILE * file = fopen("computation.txt", "w");
-    fprintf(file, "%f\n", ans.value);
-    fclose(file);
+    // Only results that evaluated are logged, as in the threaded and pipelined batch modes
+    if (ans.error == COMPUTATION_OK) {
+        result_sink_write(engine->result_sink, ans.value);
+    }
+    return ans;
+}
+
+ComputationError compute_assignment(CalcEngine* engine, const ASTNode* assignment, double* value) {
+    const ASTNode* target = assignment ? assignment->left : NULL;
+    if (!engine || !target || !assignment->right || target->token->type != TOKEN_VARIABLE) {
+        return COMPUTATION_INVALID_OPERATION;
+    }
+
+    if (engine->reactive) {
+        return reactive_assign(engine, target->token->data.var_name, assignment->right, value);
+    }
+
+    ComputationError error = COMPUTATION_OK;
+    *value = evaluate_ast(assignment->right, engine->variables->values, &error);
+    if (error == COMPUTATION_OK) {
+        engine->variables->values[target->token->slot] = *value;
+    }
+    return error;
+}
+
+ComputationResult compute_ast(CalcEngine* engine, ParseResult* result) {
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_EVALUATE);
+    ComputationResult ans = compute(engine, result);
+    alloc_stats_leave_stage(previous_stage);
     return ans;
 }
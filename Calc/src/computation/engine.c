@@ -0,0 +1,109 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../../include/computation/engine.h"
+#include "../../include/computation/expression_cache.h"
+#include "../../include/computation/reactive.h"
+#include "../../include/datastructures/allocator.h"
+
+CalcEngine* calc_engine_create(void) {
+    CalcEngine* engine = (CalcEngine*)calc_calloc(1, sizeof(CalcEngine));
+    if (!engine) return NULL;
+
+    engine->owns_functions = true;
+    engine->verbosity = CALC_VERBOSITY_RESULT;
+    engine->functions = init_SUPPORTED_FUNCTIONS_();
+    engine->variables = init_VARIABLES_();
+    engine->arena = arena_create();
+    engine->stage_stats = STAGE_STATS_ENABLED ? stage_stats_create() : NULL;
+    engine->expression_cache = expression_cache_create(EXPRESSION_CACHE_DEFAULT_BYTES);
+    if (!engine->functions || !engine->variables || !engine->arena || !engine->expression_cache ||
+        (STAGE_STATS_ENABLED && !engine->stage_stats)) {
+        calc_engine_destroy(engine);
+        return NULL;
+    }
+
+    return engine;
+}
+
+static const char* VERBOSITY_NAMES[] = { "quiet", "result", "tokens", "tree", "trace" };
+
+int calc_verbosity_parse(const char* name, CalcVerbosity* verbosity) {
+    for (size_t i = 0; i < sizeof(VERBOSITY_NAMES) / sizeof(VERBOSITY_NAMES[0]); i++) {
+        if (strcmp(name, VERBOSITY_NAMES[i]) == 0) {
+            *verbosity = (CalcVerbosity)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+CalcEngine* calc_engine_clone(const CalcEngine* engine) {
+    if (!engine) return NULL;
+
+    CalcEngine* clone = (CalcEngine*)calc_calloc(1, sizeof(CalcEngine));
+    if (!clone) return NULL;
+
+    clone->functions = engine->functions;
+    clone->owns_functions = false;
+    clone->verbosity = engine->verbosity;
+    clone->unknown_variables = engine->unknown_variables;
+    clone->variables = hashmapconst_clone(engine->variables);
+    clone->arena = arena_create();
+    clone->stage_stats = STAGE_STATS_ENABLED ? stage_stats_create() : NULL;
+    clone->expression_cache = expression_cache_create(engine->expression_cache ? engine->expression_cache->max_bytes : 0);
+    if (!clone->variables || !clone->arena || !clone->expression_cache || (STAGE_STATS_ENABLED && !clone->stage_stats)) {
+        calc_engine_destroy(clone);
+        return NULL;
+    }
+
+    return clone;
+}
+
+int calc_engine_copy_variables(CalcEngine* engine, const CalcEngine* source) {
+    if (!engine || !source) return -1;
+
+    hashmapconst_t* copy = hashmapconst_clone(source->variables);
+    if (!copy) return -1;
+
+    hashmapconst_destroy(engine->variables);
+    engine->variables = copy;
+    expression_cache_clear(engine->expression_cache);
+    reactive_graph_clear(engine->reactive);
+    return 0;
+}
+
+Token* calc_engine_token_scratch(CalcEngine* engine, size_t count) {
+    if (!engine) return NULL;
+
+    if (count > engine->token_scratch_capacity) {
+        size_t capacity = engine->token_scratch_capacity ? engine->token_scratch_capacity : 64;
+        while (capacity < count) capacity *= 2;
+
+        Token* grown = (Token*)calc_realloc(engine->token_scratch, capacity * sizeof(Token));
+        if (!grown) return NULL;
+        engine->token_scratch = grown;
+        engine->token_scratch_capacity = capacity;
+    }
+
+    return engine->token_scratch;
+}
+
+void calc_engine_reset(CalcEngine* engine) {
+    if (!engine) return;
+    arena_reset(engine->arena);
+}
+
+void calc_engine_destroy(CalcEngine* engine) {
+    if (!engine) return;
+
+    if (engine->owns_functions) {
+        hashset_destroy(engine->functions);
+    }
+    hashmapconst_destroy(engine->variables);
+    calc_free(engine->token_scratch);
+    arena_destroy(engine->arena);
+    stage_stats_destroy(engine->stage_stats);
+    expression_cache_destroy(engine->expression_cache);
+    reactive_graph_destroy(engine->reactive);
+    calc_free(engine);
+}
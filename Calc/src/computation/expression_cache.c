@@ -0,0 +1,258 @@
+#include <string.h>
+#include <ctype.h>
+#include "../../include/computation/expression_cache.h"
+#include "../../include/computation/shunt_yard_algo.h"
+#include "../../include/computation/optimizer.h"
+#include "../../include/datastructures/allocator.h"
+
+#define INITIAL_BUCKETS 64
+
+// Characters the tokenizer splits words on; whitespace next to them carries no meaning
+static const char SEPARATORS[] = "()+-*/=^!<>{}[]&|,%";
+
+static bool is_word_char(unsigned char c) {
+    return c != '\0' && !isspace(c) && !strchr(SEPARATORS, c);
+}
+
+// Writes the cache key for input into key (which holds strlen(input) + 1 bytes)
+static size_t normalize(const char* input, char* key) {
+    size_t length = 0;
+    bool pending_space = false;
+
+    for (const unsigned char* p = (const unsigned char*)input; *p; p++) {
+        if (isspace(*p)) {
+            pending_space = length > 0;
+            continue;
+        }
+        if (pending_space && is_word_char(*p) && is_word_char((unsigned char)key[length - 1])) {
+            key[length++] = ' ';
+        }
+        pending_space = false;
+        key[length++] = (char)tolower(*p);
+    }
+    key[length] = '\0';
+    return length;
+}
+
+static uint64_t hash_key(const char* key, size_t length) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)key[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static void unlink_lru(ExpressionCache* cache, CachedExpression* entry) {
+    if (entry->newer) entry->newer->older = entry->older; else cache->newest = entry->older;
+    if (entry->older) entry->older->newer = entry->newer; else cache->oldest = entry->newer;
+    entry->newer = entry->older = NULL;
+}
+
+static void push_newest(ExpressionCache* cache, CachedExpression* entry) {
+    entry->older = cache->newest;
+    entry->newer = NULL;
+    if (cache->newest) cache->newest->newer = entry; else cache->oldest = entry;
+    cache->newest = entry;
+}
+
+static void remove_entry(ExpressionCache* cache, CachedExpression* entry) {
+    CachedExpression** link = &cache->buckets[entry->hash & (cache->bucket_count - 1)];
+    while (*link != entry) link = &(*link)->hash_next;
+    *link = entry->hash_next;
+
+    unlink_lru(cache, entry);
+    cache->entries--;
+    cache->bytes -= entry->bytes;
+    calc_free(entry);
+}
+
+static void evict_until(ExpressionCache* cache, size_t max_bytes) {
+    while (cache->oldest && cache->bytes > max_bytes) {
+        remove_entry(cache, cache->oldest);
+        cache->evictions++;
+    }
+}
+
+static void grow_buckets(ExpressionCache* cache) {
+    size_t count = cache->bucket_count * 2;
+    CachedExpression** buckets = (CachedExpression**)calc_calloc(count, sizeof(CachedExpression*));
+    if (!buckets) return;
+
+    for (size_t i = 0; i < cache->bucket_count; i++) {
+        CachedExpression* entry = cache->buckets[i];
+        while (entry) {
+            CachedExpression* next = entry->hash_next;
+            entry->hash_next = buckets[entry->hash & (count - 1)];
+            buckets[entry->hash & (count - 1)] = entry;
+            entry = next;
+        }
+    }
+
+    calc_free(cache->buckets);
+    cache->bytes += (count - cache->bucket_count) * sizeof(CachedExpression*);
+    cache->buckets = buckets;
+    cache->bucket_count = count;
+}
+
+ExpressionCache* expression_cache_create(size_t max_bytes) {
+    ExpressionCache* cache = (ExpressionCache*)calc_calloc(1, sizeof(ExpressionCache));
+    if (!cache) return NULL;
+
+    cache->buckets = (CachedExpression**)calc_calloc(INITIAL_BUCKETS, sizeof(CachedExpression*));
+    if (!cache->buckets) {
+        calc_free(cache);
+        return NULL;
+    }
+    cache->bucket_count = INITIAL_BUCKETS;
+    cache->bytes = INITIAL_BUCKETS * sizeof(CachedExpression*);
+    cache->max_bytes = max_bytes;
+    return cache;
+}
+
+void expression_cache_clear(ExpressionCache* cache) {
+    if (!cache) return;
+    while (cache->oldest) {
+        remove_entry(cache, cache->oldest);
+    }
+}
+
+void expression_cache_set_limit(ExpressionCache* cache, size_t max_bytes) {
+    if (!cache) return;
+    cache->max_bytes = max_bytes;
+    if (max_bytes == 0) {
+        expression_cache_clear(cache);
+    } else {
+        evict_until(cache, max_bytes);
+    }
+}
+
+static CachedExpression* find_entry(ExpressionCache* cache, const char* key, size_t length, uint64_t hash) {
+    for (CachedExpression* entry = cache->buckets[hash & (cache->bucket_count - 1)]; entry; entry = entry->hash_next) {
+        if (entry->hash == hash && entry->key_length == length && memcmp(entry->key, key, length) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+// Copies a successfully parsed tree into one allocation and makes it the newest entry
+static CachedExpression* insert_entry(ExpressionCache* cache, const char* key, size_t length, uint64_t hash,
+                                      const ParseResult* result) {
+    size_t node_count = ast_count_nodes(result->root);
+    size_t bytes = sizeof(CachedExpression) + node_count * (sizeof(ASTNode) + sizeof(Token)) + length + 1;
+    if (bytes > cache->max_bytes) return NULL;
+
+    evict_until(cache, cache->max_bytes - bytes);
+    if (cache->bytes + bytes > cache->max_bytes) return NULL;
+
+    CachedExpression* entry = (CachedExpression*)calc_malloc(bytes);
+    if (!entry) return NULL;
+
+    // Layout: entry, nodes, tokens, key (ASTNode and Token are pointer aligned)
+    ASTNode* nodes = (ASTNode*)(entry + 1);
+    Token* tokens = (Token*)(nodes + node_count);
+    char* stored_key = (char*)(tokens + node_count);
+    memcpy(stored_key, key, length + 1);
+
+    entry->result = *result;
+    entry->result.root = ast_copy_tree(result->root, nodes, tokens);
+    entry->hash = hash;
+    entry->bytes = bytes;
+    entry->key = stored_key;
+    entry->key_length = length;
+
+    CachedExpression** bucket = &cache->buckets[hash & (cache->bucket_count - 1)];
+    entry->hash_next = *bucket;
+    *bucket = entry;
+    push_newest(cache, entry);
+    cache->entries++;
+    cache->bytes += bytes;
+
+    if (cache->entries > cache->bucket_count) {
+        grow_buckets(cache);
+    }
+    return entry;
+}
+
+// Runs the pipeline in the engine's arena, keeping engine variables as references
+static ParseResult* compile_uncached(CalcEngine* engine, const char* input) {
+    STAGE_TIMER_START(timer);
+    TokenizerResult tokens = tokenizeQuerySymbols(engine, input, engine->variables);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_TOKENIZE, timer);
+    if (tokens.error != TOKEN_SUCCESS) {
+        ParseResult* failed = (ParseResult*)arena_calloc(engine->arena, 1, sizeof(ParseResult));
+        if (failed) {
+            failed->error = AST_INVALID_TOKEN;
+            failed->error_msg = "Invalid input";
+        }
+        return failed;
+    }
+
+    TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_SHUNT_YARD, timer);
+    if (postfix && postfix->error != TOKEN_SUCCESS) {
+        postfix = NULL;
+    }
+
+    ParseResult* result = parse_expression(engine, postfix);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_PARSE, timer);
+    optimize_parse_result(engine, result);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_OPTIMIZE, timer);
+    return result;
+}
+
+ParseResult* expression_cache_parse(CalcEngine* engine, const char* input) {
+    if (!engine || !input) return NULL;
+
+    ExpressionCache* cache = engine->expression_cache;
+    if (!cache || cache->max_bytes == 0 || strchr(input, '=')) return NULL;
+
+    char* key = (char*)arena_alloc(engine->arena, strlen(input) + 1);
+    if (!key) return NULL;
+    size_t length = normalize(input, key);
+    uint64_t hash = hash_key(key, length);
+
+    CachedExpression* entry = find_entry(cache, key, length, hash);
+    if (entry) {
+        cache->hits++;
+        unlink_lru(cache, entry);
+        push_newest(cache, entry);
+        return &entry->result;
+    }
+
+    cache->misses++;
+    ParseResult* result = compile_uncached(engine, input);
+    if (!result || result->error != AST_OK || !result->root) {
+        return result;
+    }
+
+    entry = insert_entry(cache, key, length, hash, result);
+    return entry ? &entry->result : result;
+}
+
+void expression_cache_merge_counters(ExpressionCache* cache, const ExpressionCache* other) {
+    if (!cache || !other) return;
+    cache->hits += other->hits;
+    cache->misses += other->misses;
+    cache->evictions += other->evictions;
+}
+
+void expression_cache_print(FILE* out, const ExpressionCache* cache) {
+    if (!cache || cache->max_bytes == 0) {
+        fprintf(out, "Expression cache disabled\n");
+        return;
+    }
+
+    size_t lookups = cache->hits + cache->misses;
+    fprintf(out, "Expression cache: %zu hits, %zu misses (%.1f%% hit rate), %zu evictions, "
+                 "%zu entries, %zu of %zu bytes\n",
+            cache->hits, cache->misses, lookups ? 100.0 * (double)cache->hits / (double)lookups : 0.0,
+            cache->evictions, cache->entries, cache->bytes, cache->max_bytes);
+}
+
+void expression_cache_destroy(ExpressionCache* cache) {
+    if (!cache) return;
+    expression_cache_clear(cache);
+    calc_free(cache->buckets);
+    calc_free(cache);
+}
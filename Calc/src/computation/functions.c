@@ -0,0 +1,29 @@
+#include <math.h>
+#include "../../include/computation/functions.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// sin() takes its argument in degrees
+static double sin_degrees(double x) {
+    return sin((x * M_PI) / 180.0);
+}
+
+static double logbase(double base, double x) {
+    return log(x) / log(base);
+}
+
+const FunctionInfo FUNCTION_TABLE[FUNC_COUNT] = {
+    [FUNC_SIN]     = { "sin",     FUNC_SIN,     1, sin_degrees, NULL },
+    [FUNC_COS]     = { "cos",     FUNC_COS,     1, cos,         NULL },
+    [FUNC_TAN]     = { "tan",     FUNC_TAN,     1, tan,         NULL },
+    [FUNC_LOG]     = { "log",     FUNC_LOG,     1, log,         NULL },
+    [FUNC_SQRT]    = { "sqrt",    FUNC_SQRT,    1, sqrt,        NULL },
+    [FUNC_EXP]     = { "exp",     FUNC_EXP,     1, exp,         NULL },
+    [FUNC_ABS]     = { "abs",     FUNC_ABS,     1, fabs,        NULL },
+    [FUNC_LOG10]   = { "log10",   FUNC_LOG10,   1, log10,       NULL },
+    [FUNC_LOG2]    = { "log2",    FUNC_LOG2,    1, log2,        NULL },
+    [FUNC_LOGE]    = { "loge",    FUNC_LOGE,    1, log,         NULL },
+    [FUNC_LOGBASE] = { "logbase", FUNC_LOGBASE, 2, NULL,        logbase },
+};
@@ -0,0 +1,305 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "../../include/computation/jit.h"
+#include "../../include/datastructures/allocator.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#ifdef JIT_X86_64
+
+// Growable byte buffer the machine code is assembled into before it is mapped
+typedef struct {
+    unsigned char* bytes;
+    size_t length;
+    size_t capacity;
+    bool failed;
+} Emitter;
+
+static void emit_bytes(Emitter* out, const void* bytes, size_t count) {
+    if (out->failed) return;
+
+    if (out->length + count > out->capacity) {
+        size_t capacity = out->capacity ? out->capacity * 2 : 256;
+        while (capacity < out->length + count) capacity *= 2;
+        unsigned char* grown = (unsigned char*)calc_realloc(out->bytes, capacity);
+        if (!grown) {
+            out->failed = true;
+            return;
+        }
+        out->bytes = grown;
+        out->capacity = capacity;
+    }
+    memcpy(out->bytes + out->length, bytes, count);
+    out->length += count;
+}
+
+static void emit_u32(Emitter* out, uint32_t value) {
+    unsigned char bytes[4] = { value & 0xff, (value >> 8) & 0xff, (value >> 16) & 0xff, value >> 24 };
+    emit_bytes(out, bytes, sizeof(bytes));
+}
+
+static void emit_u64(Emitter* out, uint64_t value) {
+    emit_u32(out, (uint32_t)value);
+    emit_u32(out, (uint32_t)(value >> 32));
+}
+
+// SSE2 scalar instruction on xmm{reg} and the stack slot [rsp + disp]:
+// F2 0F <opcode> ModRM(mod=10, reg, rm=100) SIB(rsp) disp32
+static void emit_sse_stack(Emitter* out, unsigned char opcode, int reg, uint32_t disp) {
+    unsigned char bytes[5] = { 0xF2, 0x0F, opcode, (unsigned char)(0x84 | (reg << 3)), 0x24 };
+    emit_bytes(out, bytes, sizeof(bytes));
+    emit_u32(out, disp);
+}
+
+static uint32_t slot(uint32_t reg) {
+    return reg * (uint32_t)sizeof(double);
+}
+
+static void load_slot(Emitter* out, int xmm, uint32_t reg)  { emit_sse_stack(out, 0x10, xmm, slot(reg)); }  // movsd xmm, [rsp+d]
+static void store_slot(Emitter* out, uint32_t reg)          { emit_sse_stack(out, 0x11, 0, slot(reg)); }    // movsd [rsp+d], xmm0
+
+// movsd xmm0, [rbx + disp32]; rbx holds the variables pointer
+static void load_variable(Emitter* out, uint32_t index) {
+    static const unsigned char bytes[] = { 0xF2, 0x0F, 0x10, 0x83 };
+    emit_bytes(out, bytes, sizeof(bytes));
+    emit_u32(out, index * (uint32_t)sizeof(double));
+}
+
+// mov rax, imm64; movq xmm{xmm}, rax
+static void load_bits(Emitter* out, int xmm, uint64_t bits) {
+    static const unsigned char mov_rax[] = { 0x48, 0xB8 };
+    emit_bytes(out, mov_rax, sizeof(mov_rax));
+    emit_u64(out, bits);
+    unsigned char movq[] = { 0x66, 0x48, 0x0F, 0x6E, (unsigned char)(0xC0 | (xmm << 3)) };
+    emit_bytes(out, movq, sizeof(movq));
+}
+
+static void load_constant(Emitter* out, int xmm, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    load_bits(out, xmm, bits);
+}
+
+// <op>pd xmm0, xmm1 (66 0F <opcode> C1), used for the sign-bit masks
+static void emit_packed_xmm1(Emitter* out, unsigned char opcode) {
+    unsigned char bytes[] = { 0x66, 0x0F, opcode, 0xC1 };
+    emit_bytes(out, bytes, sizeof(bytes));
+}
+
+// mov rax, function; call rax (the stack is kept 16-byte aligned)
+static void emit_call(Emitter* out, const void* function) {
+    static const unsigned char mov_rax[] = { 0x48, 0xB8 };
+    static const unsigned char call_rax[] = { 0xFF, 0xD0 };
+    emit_bytes(out, mov_rax, sizeof(mov_rax));
+    emit_u64(out, (uint64_t)(uintptr_t)function);
+    emit_bytes(out, call_rax, sizeof(call_rax));
+}
+
+// Argument conversions shared with traversal() so both give identical results
+static double jit_sin_degrees(double x) {
+    return sin((x * M_PI) / 180.0);
+}
+
+static double jit_logbase(double base, double x) {
+    return log(x) / log(base);
+}
+
+static const void* libm_function(OpCode op) {
+    switch (op) {
+        case OP_POW:     return (const void*)pow;
+        case OP_SIN:     return (const void*)jit_sin_degrees;
+        case OP_COS:     return (const void*)cos;
+        case OP_TAN:     return (const void*)tan;
+        case OP_LOG:     return (const void*)log;
+        case OP_EXP:     return (const void*)exp;
+        case OP_LOG10:   return (const void*)log10;
+        case OP_LOG2:    return (const void*)log2;
+        case OP_LOGBASE: return (const void*)jit_logbase;
+        default:         return NULL;
+    }
+}
+
+static bool is_binary(OpCode op) {
+    return op == OP_ADD || op == OP_SUB || op == OP_MUL || op == OP_DIV || op == OP_POW || op == OP_LOGBASE;
+}
+
+static bool has_operand(OpCode op) {
+    return op != OP_CONST && op != OP_LOAD_VAR;
+}
+
+static bool is_supported(OpCode op) {
+    switch (op) {
+        case OP_CONST: case OP_LOAD_VAR: case OP_ADD: case OP_SUB: case OP_MUL:
+        case OP_DIV: case OP_NEG: case OP_ABS: case OP_SQRT:
+            return true;
+        default:
+            return op < OP_COUNT && libm_function(op) != NULL;
+    }
+}
+
+// Computes register i into xmm0; xmm0 already holds register i-1 when previous_live is set
+static void emit_instruction(Emitter* out, const Instruction* in, uint32_t i, bool previous_live) {
+    OpCode op = (OpCode)in->op;
+    uint32_t a = in->arg.operands.a;
+    uint32_t b = in->arg.operands.b;
+
+    if (op == OP_CONST) {
+        load_constant(out, 0, in->arg.value);
+        return;
+    }
+    if (op == OP_LOAD_VAR) {
+        load_variable(out, a);
+        return;
+    }
+
+    // sqrtsd reads its operand straight from memory
+    if (op == OP_SQRT && !(previous_live && a + 1 == i)) {
+        emit_sse_stack(out, 0x51, 0, slot(a));
+        return;
+    }
+
+    if (!(previous_live && a + 1 == i)) {
+        load_slot(out, 0, a);
+    }
+
+    switch (op) {
+        case OP_ADD: emit_sse_stack(out, 0x58, 0, slot(b)); break;
+        case OP_SUB: emit_sse_stack(out, 0x5C, 0, slot(b)); break;
+        case OP_MUL: emit_sse_stack(out, 0x59, 0, slot(b)); break;
+        case OP_DIV: emit_sse_stack(out, 0x5E, 0, slot(b)); break;
+        case OP_SQRT: {
+            static const unsigned char sqrtsd[] = { 0xF2, 0x0F, 0x51, 0xC0 };  // sqrtsd xmm0, xmm0
+            emit_bytes(out, sqrtsd, sizeof(sqrtsd));
+            break;
+        }
+        case OP_NEG:
+            load_bits(out, 1, 0x8000000000000000ULL);
+            emit_packed_xmm1(out, 0x57);  // xorpd
+            break;
+        case OP_ABS:
+            load_bits(out, 1, 0x7FFFFFFFFFFFFFFFULL);
+            emit_packed_xmm1(out, 0x54);  // andpd
+            break;
+        default:
+            if (is_binary(op)) {
+                load_slot(out, 1, b);
+            }
+            emit_call(out, libm_function(op));
+            break;
+    }
+}
+
+JitProgram* jit_compile(const BytecodeProgram* program) {
+    if (!program || program->length == 0) return NULL;
+
+    size_t length = program->length;
+    for (size_t i = 0; i < length; i++) {
+        if (!is_supported((OpCode)program->code[i].op)) return NULL;
+    }
+
+    // How often each register is read, so values consumed only by the next
+    // instruction stay in xmm0 instead of making a round trip through the stack
+    uint32_t* uses = (uint32_t*)calc_calloc(length, sizeof(uint32_t));
+    if (!uses) return NULL;
+    for (size_t i = 0; i < length; i++) {
+        const Instruction* in = &program->code[i];
+        OpCode op = (OpCode)in->op;
+        if (has_operand(op)) uses[in->arg.operands.a]++;
+        if (is_binary(op)) uses[in->arg.operands.b]++;
+    }
+
+    Emitter out = {0};
+
+    // push rbx; mov rbx, rdi; sub rsp, frame (entry rsp is 8 mod 16, so the frame keeps calls aligned)
+    uint32_t frame = (uint32_t)((length * sizeof(double) + 15) & ~(size_t)15);
+    static const unsigned char prologue[] = { 0x53, 0x48, 0x89, 0xFB, 0x48, 0x81, 0xEC };
+    emit_bytes(&out, prologue, sizeof(prologue));
+    emit_u32(&out, frame);
+
+    bool previous_live = false;
+    for (uint32_t i = 0; i < length; i++) {
+        const Instruction* in = &program->code[i];
+        emit_instruction(&out, in, i, previous_live);
+
+        const Instruction* next = i + 1 < length ? &program->code[i + 1] : NULL;
+        bool consumed_next = next && uses[i] == 1 && has_operand((OpCode)next->op) && next->arg.operands.a == i &&
+                             !(is_binary((OpCode)next->op) && next->arg.operands.b == i);
+        if (!consumed_next && i + 1 < length) {
+            store_slot(&out, i);
+        }
+        previous_live = true;  // xmm0 now holds register i
+    }
+    calc_free(uses);
+
+    // The result of the last instruction is already in xmm0
+    static const unsigned char epilogue[] = { 0x48, 0x81, 0xC4 };
+    static const unsigned char tail[] = { 0x5B, 0xC3 };  // pop rbx; ret
+    emit_bytes(&out, epilogue, sizeof(epilogue));
+    emit_u32(&out, frame);
+    emit_bytes(&out, tail, sizeof(tail));
+
+    if (out.failed) {
+        calc_free(out.bytes);
+        return NULL;
+    }
+
+    JitProgram* jit = (JitProgram*)calc_malloc(sizeof(JitProgram));
+    long page = sysconf(_SC_PAGESIZE);
+    size_t size = page > 0 ? (out.length + (size_t)page - 1) / (size_t)page * (size_t)page : out.length;
+    void* code = jit ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : MAP_FAILED;
+    if (code == MAP_FAILED) {
+        calc_free(out.bytes);
+        calc_free(jit);
+        return NULL;
+    }
+
+    memcpy(code, out.bytes, out.length);
+    calc_free(out.bytes);
+    if (mprotect(code, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(code, size);
+        calc_free(jit);
+        return NULL;
+    }
+
+    jit->code = code;
+    jit->size = size;
+    jit->function = (JitFunction)code;
+    return jit;
+}
+
+void jit_free(JitProgram* jit) {
+    if (!jit) return;
+    munmap(jit->code, jit->size);
+    calc_free(jit);
+}
+
+bool jit_supported(void) {
+    return true;
+}
+
+#else
+
+JitProgram* jit_compile(const BytecodeProgram* program) {
+    (void)program;
+    return NULL;
+}
+
+void jit_free(JitProgram* jit) {
+    (void)jit;
+}
+
+bool jit_supported(void) {
+    return false;
+}
+
+#endif
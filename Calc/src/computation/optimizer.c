@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "../../include/computation/optimizer.h"
+#include "../../include/computation/computation.h"
+#include "../../include/computation/engine.h"
+#include "../../include/computation/alloc_stats.h"
+
+static size_t count_nodes(const ASTNode* node) {
+    if (!node) return 0;
+    return 1 + count_nodes(node->left) + count_nodes(node->right) + count_nodes(node->child);
+}
+
+static bool is_number(const ASTNode* node, double value) {
+    return node && node->token && node->token->type == TOKEN_NUMBER && node->token->data.num_value == value;
+}
+
+static bool is_constant(const ASTNode* node) {
+    return node && node->token && node->token->type == TOKEN_NUMBER;
+}
+
+// Evaluates a subtree whose operands are all numbers and turns node into that number
+static ASTNode* fold(arena_t* arena, ASTNode* node, OptimizeStats* stats) {
+    ComputationError error = COMPUTATION_OK;
+    double value = evaluate_ast(node, NULL, &error);
+    if (error != COMPUTATION_OK) {
+        // Leave malformed subtrees for evaluation to report
+        return node;
+    }
+
+    Token* token = (Token*)arena_alloc(arena, sizeof(Token));
+    if (!token) return node;
+    token->type = TOKEN_NUMBER;
+    token->data.num_value = value;
+
+    node->token = token;
+    node->left = NULL;
+    node->right = NULL;
+    node->child = NULL;
+    stats->folded++;
+    return node;
+}
+
+static ASTNode* simplified(ASTNode* replacement, OptimizeStats* stats) {
+    stats->simplified++;
+    return replacement;
+}
+
+static ASTNode* optimize_node(arena_t* arena, ASTNode* node, OptimizeStats* stats) {
+    if (!node || !node->token) return node;
+
+    node->left = optimize_node(arena, node->left, stats);
+    node->right = optimize_node(arena, node->right, stats);
+    node->child = optimize_node(arena, node->child, stats);
+
+    const Token* token = node->token;
+    switch (token->type) {
+        case TOKEN_OPERATOR: {
+            if (!node->left || !node->right) return node;
+            if (is_constant(node->left) && is_constant(node->right)) {
+                return fold(arena, node, stats);
+            }
+
+            switch (token->data.operator_value) {
+                case '*':
+                    if (is_number(node->right, 1.0)) return simplified(node->left, stats);
+                    if (is_number(node->left, 1.0)) return simplified(node->right, stats);
+                    break;
+                case '/':
+                    if (is_number(node->right, 1.0)) return simplified(node->left, stats);
+                    break;
+                case '+':
+                    if (is_number(node->right, 0.0)) return simplified(node->left, stats);
+                    if (is_number(node->left, 0.0)) return simplified(node->right, stats);
+                    break;
+                case '-':
+                    if (is_number(node->right, 0.0)) return simplified(node->left, stats);
+                    break;
+                case '^':
+                    if (is_number(node->right, 1.0)) return simplified(node->left, stats);
+                    break;
+                default:
+                    break;
+            }
+            return node;
+        }
+
+        case TOKEN_UNARY: {
+            if (!node->child) return node;
+            if (is_constant(node->child)) {
+                return fold(arena, node, stats);
+            }
+            if (token->data.unary_operator == TOKEN_UNARY_POSITIVE) {
+                return simplified(node->child, stats);
+            }
+
+            // --x: two negations cancel
+            const ASTNode* inner = node->child;
+            if (inner->token->type == TOKEN_UNARY && inner->token->data.unary_operator == TOKEN_UNARY_NEGATIVE && inner->child) {
+                return simplified(inner->child, stats);
+            }
+            return node;
+        }
+
+        case TOKEN_FUNCTION: {
+            const FunctionInfo* function = token->data.function;
+            bool constant = function && function->arity == 2
+                ? is_constant(node->left) && is_constant(node->right)
+                : is_constant(node->child);
+            return constant ? fold(arena, node, stats) : node;
+        }
+
+        case TOKEN_EQUALITY:
+            // The target stays a variable; only the value was optimized above
+            return node;
+
+        default:
+            return node;
+    }
+}
+
+ASTNode* optimize_ast(arena_t* arena, ASTNode* root, OptimizeStats* stats) {
+    OptimizeStats local = {0};
+    if (!stats) stats = &local;
+    *stats = (OptimizeStats){0};
+
+    stats->nodes_before = count_nodes(root);
+    if (root && root->token && root->token->type == TOKEN_EQUALITY) {
+        root->right = optimize_node(arena, root->right, stats);
+    } else {
+        root = optimize_node(arena, root, stats);
+    }
+    stats->nodes_after = count_nodes(root);
+    return root;
+}
+
+void optimize_parse_result(CalcEngine* engine, ParseResult* result) {
+    if (!engine || !result || result->error != AST_OK || !result->root) return;
+
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_TRACE)) {
+        fprintf(stderr, "Before optimization:\n");
+        print_tree(result);
+    }
+
+    OptimizeStats stats;
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_OPTIMIZE);
+    result->root = optimize_ast(engine->arena, result->root, &stats);
+    alloc_stats_leave_stage(previous_stage);
+
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_TRACE)) {
+        fprintf(stderr, "After optimization (%zu -> %zu nodes, %zu folded, %zu simplified):\n",
+                stats.nodes_before, stats.nodes_after, stats.folded, stats.simplified);
+        print_tree(result);
+    }
+}
+
+typedef struct {
+    ASTNode** slots;        // Open-addressed canonical nodes, NULL when empty
+    size_t mask;            // Capacity - 1 (capacity is a power of two)
+    size_t merged;          // Nodes replaced by an existing canonical node
+} ConsTable;
+
+static uint64_t mix(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+// Payload that identifies a node's token, independent of where the token lives
+static uint64_t token_key(const Token* token) {
+    uint64_t bits = 0;
+    switch (token->type) {
+        case TOKEN_NUMBER:
+            memcpy(&bits, &token->data.num_value, sizeof(bits));
+            return bits;
+        case TOKEN_VARIABLE:
+            return (uint64_t)(uintptr_t)token->data.var_name;
+        case TOKEN_FUNCTION:
+            return (uint64_t)(uintptr_t)token->data.function;
+        case TOKEN_OPERATOR:
+            return (uint64_t)(unsigned char)token->data.operator_value;
+        case TOKEN_UNARY:
+            return (uint64_t)token->data.unary_operator;
+        default:
+            return 0;
+    }
+}
+
+static uint64_t node_hash(const ASTNode* node) {
+    uint64_t hash = mix(0, (uint64_t)node->token->type);
+    hash = mix(hash, token_key(node->token));
+    hash = mix(hash, (uint64_t)(uintptr_t)node->left);
+    hash = mix(hash, (uint64_t)(uintptr_t)node->right);
+    return mix(hash, (uint64_t)(uintptr_t)node->child);
+}
+
+static bool same_node(const ASTNode* a, const ASTNode* b) {
+    return a->token->type == b->token->type && token_key(a->token) == token_key(b->token) &&
+           a->left == b->left && a->right == b->right && a->child == b->child;
+}
+
+static bool is_shareable(const ASTNode* node) {
+    switch (node->token->type) {
+        case TOKEN_NUMBER:
+        case TOKEN_VARIABLE:
+        case TOKEN_FUNCTION:
+        case TOKEN_OPERATOR:
+        case TOKEN_UNARY:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static ASTNode* cons_node(ConsTable* table, ASTNode* node) {
+    if (!node || !node->token) return node;
+
+    node->left = cons_node(table, node->left);
+    node->right = cons_node(table, node->right);
+    node->child = cons_node(table, node->child);
+    if (!table->slots || !is_shareable(node)) return node;
+
+    size_t index = (size_t)node_hash(node) & table->mask;
+    while (table->slots[index]) {
+        if (same_node(table->slots[index], node)) {
+            table->merged++;
+            return table->slots[index];
+        }
+        index = (index + 1) & table->mask;
+    }
+    table->slots[index] = node;
+    return node;
+}
+
+ASTNode* share_common_subexpressions(arena_t* arena, ASTNode* root, size_t* merged) {
+    // At least twice as many slots as nodes keeps probe sequences short
+    size_t capacity = 16;
+    size_t nodes = count_nodes(root);
+    while (capacity < nodes * 2) capacity *= 2;
+
+    ConsTable table = { (ASTNode**)arena_calloc(arena, capacity, sizeof(ASTNode*)), capacity - 1, 0 };
+    root = cons_node(&table, root);
+
+    if (merged) *merged = table.merged;
+    return root;
+}
@@ -0,0 +1,305 @@
+#include <string.h>
+#include "../../include/computation/pipeline.h"
+#include "../../include/computation/shunt_yard_algo.h"
+#include "../../include/computation/AST_tree.h"
+#include "../../include/computation/optimizer.h"
+#include "../../include/computation/alloc_stats.h"
+#include "../../include/computation/expression_cache.h"
+#include "../../include/computation/stage_stats.h"
+#include "../../include/datastructures/allocator.h"
+
+static const char* STAGE_NAMES[PIPELINE_STAGE_COUNT] = { "tokenize", "parse", "evaluate" };
+
+// Blocking pop that charges the time spent waiting to the stage
+static PipelineSlot* take_slot(SpscQueue* queue, PipelineStageTimes* times) {
+    void* slot;
+    if (spsc_queue_try_pop(queue, &slot)) return (PipelineSlot*)slot;
+
+    uint64_t start = stage_clock_ns();
+    slot = spsc_queue_pop(queue);
+    times->input_wait_ns += stage_clock_ns() - start;
+    return (PipelineSlot*)slot;
+}
+
+static void pass_slot(SpscQueue* queue, PipelineSlot* slot, PipelineStageTimes* times) {
+    if (spsc_queue_try_push(queue, slot)) return;
+
+    uint64_t start = stage_clock_ns();
+    spsc_queue_push(queue, slot);
+    times->output_wait_ns += stage_clock_ns() - start;
+}
+
+static void tokenize_slot(CalcEngine* engine, PipelineSlot* slot) {
+    STAGE_TIMER_START(timer);
+    slot->tokens = tokenizeQuery(engine, slot->line);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_TOKENIZE, timer);
+    slot->rejected = slot->tokens.error != TOKEN_SUCCESS || slot->tokens.token_count == 0;
+}
+
+static void parse_slot(CalcEngine* engine, PipelineSlot* slot) {
+    STAGE_TIMER_START(timer);
+    TokenizerResult* postfix = shunt_yard_algo(engine, &slot->tokens);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_SHUNT_YARD, timer);
+    if (!postfix) {
+        slot->rejected = true;
+        return;
+    }
+
+    slot->ast = parse_expression(engine, postfix);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_PARSE, timer);
+    optimize_parse_result(engine, slot->ast);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_OPTIMIZE, timer);
+}
+
+// Registers the names the tokenizer's clone met as unknown in the session, in
+// the order the clone registered them. The two tables start equal at every
+// barrier, so the names get the same slots the line's tokens refer to
+static bool adopt_line_names(CalcEngine* engine, const PipelineSlot* slot) {
+    for (size_t i = 0; slot->tokens.tokens && i < slot->tokens.token_count; i++) {
+        const Token* token = &slot->tokens.tokens[i];
+        if (token->type != TOKEN_VARIABLE) continue;
+
+        const hashmapconst_entry_t* entry = hashmapconst_intern(engine->variables, token->data.var_name->name, 0.0);
+        if (!entry || entry->slot != token->slot) return false;
+    }
+    return true;
+}
+
+static BatchResult evaluate_slot(CalcEngine* engine, const PipelineSlot* slot) {
+    BatchResult result = {0, COMPUTATION_OK};
+    if (slot->assignment) {
+        return evaluate_expression_text(engine, slot->line);
+    }
+
+    STAGE_TIMER_START(timer);
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_EVALUATE);
+    bool aligned = adopt_line_names(engine, slot);
+    if (!aligned || slot->rejected || !slot->ast || slot->ast->error != AST_OK || !slot->ast->root) {
+        result.error = COMPUTATION_INVALID_OPERATION;
+    } else {
+        result.value = evaluate_ast(slot->ast->root, engine->variables->values, &result.error);
+    }
+    alloc_stats_leave_stage(previous_stage);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_EVALUATE, timer);
+    return result;
+}
+
+static void* parse_main(void* arg) {
+    PipelineEvaluator* evaluator = (PipelineEvaluator*)arg;
+    CalcEngine* engine = evaluator->stage_engines[PIPELINE_PARSE];
+    PipelineStageTimes* times = &evaluator->times[PIPELINE_PARSE];
+    arena_t* own_arena = engine->arena;
+
+    for (size_t i = 0; i < evaluator->count; i++) {
+        PipelineSlot* slot = take_slot(&evaluator->tokenized, times);
+        if (!slot) break; // The run was abandoned before it started
+        if (!slot->assignment && !slot->rejected) {
+            uint64_t start = stage_clock_ns();
+            engine->arena = slot->arena;
+            parse_slot(engine, slot);
+            times->busy_ns += stage_clock_ns() - start;
+        }
+        pass_slot(&evaluator->parsed, slot, times);
+    }
+
+    engine->arena = own_arena;
+    return NULL;
+}
+
+static void* evaluate_main(void* arg) {
+    PipelineEvaluator* evaluator = (PipelineEvaluator*)arg;
+    PipelineStageTimes* times = &evaluator->times[PIPELINE_EVALUATE];
+
+    for (size_t i = 0; i < evaluator->count; i++) {
+        PipelineSlot* slot = take_slot(&evaluator->parsed, times);
+        uint64_t start = stage_clock_ns();
+        evaluator->results[slot->index] = evaluate_slot(evaluator->engine, slot);
+        times->busy_ns += stage_clock_ns() - start;
+
+        // Only assignments are waited for; the slot can be reused once it is pushed back
+        bool assignment = slot->assignment;
+        size_t index = slot->index;
+        // free_slots holds every slot, so this never waits
+        spsc_queue_push(&evaluator->free_slots, slot);
+        if (assignment) {
+            pthread_mutex_lock(&evaluator->applied_lock);
+            evaluator->applied = index + 1;
+            pthread_cond_signal(&evaluator->applied_changed);
+            pthread_mutex_unlock(&evaluator->applied_lock);
+        }
+    }
+    return NULL;
+}
+
+PipelineEvaluator* pipeline_evaluator_create(CalcEngine* engine, size_t depth) {
+    if (!engine) return NULL;
+    if (depth == 0) depth = PIPELINE_DEFAULT_DEPTH;
+
+    PipelineEvaluator* evaluator = (PipelineEvaluator*)calc_calloc(1, sizeof(PipelineEvaluator));
+    if (!evaluator) return NULL;
+    if (pthread_mutex_init(&evaluator->applied_lock, NULL) != 0) {
+        calc_free(evaluator);
+        return NULL;
+    }
+    if (pthread_cond_init(&evaluator->applied_changed, NULL) != 0) {
+        pthread_mutex_destroy(&evaluator->applied_lock);
+        calc_free(evaluator);
+        return NULL;
+    }
+    evaluator->engine = engine;
+
+    for (int stage = PIPELINE_TOKENIZE; stage < PIPELINE_EVALUATE; stage++) {
+        evaluator->stage_engines[stage] = calc_engine_clone(engine);
+        if (!evaluator->stage_engines[stage]) {
+            pipeline_evaluator_destroy(evaluator);
+            return NULL;
+        }
+    }
+
+    // Both queues full plus one expression held by each stage
+    evaluator->slot_count = 2 * depth + PIPELINE_STAGE_COUNT;
+    evaluator->slots = (PipelineSlot*)calc_calloc(evaluator->slot_count, sizeof(PipelineSlot));
+    if (!evaluator->slots ||
+        spsc_queue_init(&evaluator->tokenized, depth) != 0 ||
+        spsc_queue_init(&evaluator->parsed, depth) != 0 ||
+        spsc_queue_init(&evaluator->free_slots, evaluator->slot_count) != 0) {
+        pipeline_evaluator_destroy(evaluator);
+        return NULL;
+    }
+    for (size_t i = 0; i < evaluator->slot_count; i++) {
+        evaluator->slots[i].arena = arena_create();
+        if (!evaluator->slots[i].arena) {
+            pipeline_evaluator_destroy(evaluator);
+            return NULL;
+        }
+        spsc_queue_push(&evaluator->free_slots, &evaluator->slots[i]);
+    }
+    // The initial fill is not traffic
+    spsc_queue_reset_stats(&evaluator->free_slots);
+
+    return evaluator;
+}
+
+int pipeline_evaluate(PipelineEvaluator* evaluator, char* const* lines, size_t count, BatchResult* results) {
+    if (!evaluator || (!lines && count > 0) || (!results && count > 0)) return -1;
+    if (count == 0) return 0;
+
+    CalcEngine* engine = evaluator->stage_engines[PIPELINE_TOKENIZE];
+    // The session may have changed since the last run; slots must start out equal
+    if (calc_engine_copy_variables(engine, evaluator->engine) != 0) return -1;
+
+    evaluator->count = count;
+    evaluator->results = results;
+    evaluator->applied = 0;
+
+    pthread_t parser, evaluate;
+    if (pthread_create(&parser, NULL, parse_main, evaluator) != 0) return -1;
+    if (pthread_create(&evaluate, NULL, evaluate_main, evaluator) != 0) {
+        spsc_queue_push(&evaluator->tokenized, NULL);
+        pthread_join(parser, NULL);
+        return -1;
+    }
+
+    PipelineStageTimes* times = &evaluator->times[PIPELINE_TOKENIZE];
+    arena_t* own_arena = engine->arena;
+    bool stale = false;
+
+    for (size_t i = 0; i < count; i++) {
+        PipelineSlot* slot = take_slot(&evaluator->free_slots, times);
+        arena_reset(slot->arena);
+        slot->line = lines[i];
+        slot->index = i;
+        slot->ast = NULL;
+        slot->tokens = (TokenizerResult){0};
+        slot->assignment = !stale && strchr(lines[i], '=') != NULL;
+        // Without the session's current variables the remaining lines cannot be tokenized correctly
+        slot->rejected = stale;
+
+        if (slot->assignment) {
+            pass_slot(&evaluator->tokenized, slot, times);
+
+            // Later lines are tokenized with the assigned value substituted
+            uint64_t start = stage_clock_ns();
+            pthread_mutex_lock(&evaluator->applied_lock);
+            while (evaluator->applied <= i) {
+                pthread_cond_wait(&evaluator->applied_changed, &evaluator->applied_lock);
+            }
+            pthread_mutex_unlock(&evaluator->applied_lock);
+            times->output_wait_ns += stage_clock_ns() - start;
+            stale = calc_engine_copy_variables(engine, evaluator->engine) != 0;
+            continue;
+        }
+        if (stale) {
+            pass_slot(&evaluator->tokenized, slot, times);
+            continue;
+        }
+
+        uint64_t start = stage_clock_ns();
+        engine->arena = slot->arena;
+        tokenize_slot(engine, slot);
+        times->busy_ns += stage_clock_ns() - start;
+        pass_slot(&evaluator->tokenized, slot, times);
+    }
+    engine->arena = own_arena;
+
+    pthread_join(parser, NULL);
+    pthread_join(evaluate, NULL);
+    evaluator->expressions += count;
+    return stale ? -1 : 0;
+}
+
+static const SpscQueue* queue_after(const PipelineEvaluator* evaluator, int stage) {
+    return stage == PIPELINE_TOKENIZE ? &evaluator->tokenized : &evaluator->parsed;
+}
+
+void pipeline_evaluator_print(FILE* out, const PipelineEvaluator* evaluator) {
+    if (!evaluator) return;
+
+    uint64_t busiest = 0;
+    int bottleneck = PIPELINE_TOKENIZE;
+    fprintf(out, "Pipeline: %zu expressions, %zu slots\n", evaluator->expressions, evaluator->slot_count);
+    fprintf(out, "%-10s %12s %14s %15s\n", "stage", "busy ms", "input wait ms", "output wait ms");
+    for (int stage = 0; stage < PIPELINE_STAGE_COUNT; stage++) {
+        const PipelineStageTimes* times = &evaluator->times[stage];
+        fprintf(out, "%-10s %12.1f %14.1f %15.1f\n", STAGE_NAMES[stage], times->busy_ns / 1e6,
+                times->input_wait_ns / 1e6, times->output_wait_ns / 1e6);
+        if (times->busy_ns > busiest) {
+            busiest = times->busy_ns;
+            bottleneck = stage;
+        }
+    }
+
+    fprintf(out, "%-20s %9s %11s %11s %12s\n", "queue", "capacity", "mean depth", "full waits", "empty waits");
+    for (int stage = PIPELINE_TOKENIZE; stage < PIPELINE_EVALUATE; stage++) {
+        const SpscQueue* queue = queue_after(evaluator, stage);
+        char name[32];
+        snprintf(name, sizeof(name), "%s -> %s", STAGE_NAMES[stage], STAGE_NAMES[stage + 1]);
+        fprintf(out, "%-20s %9zu %11.1f %11zu %12zu\n", name, spsc_queue_capacity(queue),
+                spsc_queue_mean_occupancy(queue), queue->full_waits, queue->empty_waits);
+    }
+    // A full queue in front of a stage and empty queues behind it point at the same stage
+    fprintf(out, "Bottleneck: %s\n", STAGE_NAMES[bottleneck]);
+}
+
+void pipeline_evaluator_destroy(PipelineEvaluator* evaluator) {
+    if (!evaluator) return;
+
+    for (int stage = PIPELINE_TOKENIZE; stage < PIPELINE_EVALUATE; stage++) {
+        CalcEngine* clone = evaluator->stage_engines[stage];
+        if (clone) {
+            stage_stats_merge(evaluator->engine->stage_stats, clone->stage_stats);
+            expression_cache_merge_counters(evaluator->engine->expression_cache, clone->expression_cache);
+        }
+        calc_engine_destroy(clone);
+    }
+    for (size_t i = 0; evaluator->slots && i < evaluator->slot_count; i++) {
+        arena_destroy(evaluator->slots[i].arena);
+    }
+    calc_free(evaluator->slots);
+    spsc_queue_destroy(&evaluator->tokenized);
+    spsc_queue_destroy(&evaluator->parsed);
+    spsc_queue_destroy(&evaluator->free_slots);
+    pthread_cond_destroy(&evaluator->applied_changed);
+    pthread_mutex_destroy(&evaluator->applied_lock);
+    calc_free(evaluator);
+}
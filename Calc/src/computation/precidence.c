@@ -1,30 +1,23 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "../../include/computation/precidence.h"
+#include "../../include/datastructures/allocator.h"
 
-#define HASHMAP_SIZE 17
+const OperatorInfo OPERATOR_TABLE[256] = {
+    ['^'] = {true, 4, RIGHT_TO_LEFT},
+    ['*'] = {true, 2, LEFT_TO_RIGHT},
+    ['/'] = {true, 2, LEFT_TO_RIGHT},
+    ['%'] = {true, 2, LEFT_TO_RIGHT},
+    ['+'] = {true, 1, LEFT_TO_RIGHT},
+    ['-'] = {true, 1, LEFT_TO_RIGHT},
+    ['='] = {true, 0, RIGHT_TO_LEFT},
+};
 
-typedef enum {
-    LEFT_TO_RIGHT,
-    RIGHT_TO_LEFT
-} Associativity;
-
-typedef struct Operator {
-    char *symbol;
-    int precedence;
-    Associativity assoc;
-    struct Operator *next;
-} Operator;
-
-typedef struct {
-    Operator *buckets[HASHMAP_SIZE];
-} HashMap;
-
-HashMap* initialize_hashmap(HashMap *map) {
+void initialize_hashmap(HashMap *map) {
     for (int i = 0; i < HASHMAP_SIZE; i++) {
         map->buckets[i] = NULL;
     }
-    return map;
 }
 
 int hash_function(char *symbol) {
@@ -49,7 +42,7 @@ Operator* precidence_hashmap_get(HashMap *map, char *symbol) {
 
 void free_operator(Operator *op) {
     if (op) {
-        free(op);
+        calc_free(op);
     }
 }
 
@@ -65,7 +58,7 @@ void free_hashmap(HashMap *map) {
         }
         map->buckets[i] = NULL;
     }
-    free(map);
+    calc_free(map);
 }
 
 void print_operator_info(Operator *op) {
@@ -81,7 +74,7 @@ void print_operator_info(Operator *op) {
 void hashmap_insert(HashMap* map, char* symbol, int precedence, Associativity assoc) {
     int index = hash_function(symbol);
     
-    Operator* new_op = (Operator*)malloc(sizeof(Operator));
+    Operator* new_op = (Operator*)calc_malloc(sizeof(Operator));
     new_op->symbol = symbol;
     new_op->precedence = precedence;
     new_op->assoc = assoc;
@@ -91,19 +84,20 @@ void hashmap_insert(HashMap* map, char* symbol, int precedence, Associativity as
 }
 
 HashMap* innit_precidence(HashMap* map) {
-    map = (HashMap*)malloc(sizeof(HashMap));
+    map = (HashMap*)calc_malloc(sizeof(HashMap));
     initialize_hashmap(map);
     
-    hashmap_insert(map, "sin", 5, LEFT_TO_RIGHT);
-    hashmap_insert(map, "cos", 5, LEFT_TO_RIGHT);
-    hashmap_insert(map, "tan", 5, LEFT_TO_RIGHT);
-    hashmap_insert(map, "log", 5, LEFT_TO_RIGHT);
-    hashmap_insert(map, "sqrt", 5, LEFT_TO_RIGHT);
+    hashmap_insert(map, "sin", 6, LEFT_TO_RIGHT);
+    hashmap_insert(map, "cos", 6, LEFT_TO_RIGHT);
+    hashmap_insert(map, "tan", 6, LEFT_TO_RIGHT);
+    hashmap_insert(map, "log", 6, LEFT_TO_RIGHT);
+    hashmap_insert(map, "sqrt", 6, LEFT_TO_RIGHT);
     
-    hashmap_insert(map, "(", 4, LEFT_TO_RIGHT);
-    hashmap_insert(map, ")", 4, LEFT_TO_RIGHT);
+    hashmap_insert(map, "(", 5, LEFT_TO_RIGHT);
+    hashmap_insert(map, ")", 5, LEFT_TO_RIGHT);
     
-    hashmap_insert(map, "^", 3, RIGHT_TO_LEFT);
+    // Same levels as OPERATOR_TABLE; a unary sign (UNARY_PRECEDENCE) sits between "^" and "*"
+    hashmap_insert(map, "^", 4, RIGHT_TO_LEFT);
     
     hashmap_insert(map, "*", 2, LEFT_TO_RIGHT);
     hashmap_insert(map, "/", 2, LEFT_TO_RIGHT);
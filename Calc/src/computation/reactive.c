@@ -0,0 +1,318 @@
+#include <string.h>
+#include "../../include/computation/reactive.h"
+#include "../../include/datastructures/allocator.h"
+
+#define INITIAL_NODES 64
+#define INITIAL_INDEX 128
+
+static uint64_t hash_pointer(const void* pointer) {
+    uint64_t value = (uint64_t)(uintptr_t)pointer;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    return value;
+}
+
+static ReactiveGraph* reactive_graph_create(void) {
+    ReactiveGraph* graph = (ReactiveGraph*)calc_calloc(1, sizeof(ReactiveGraph));
+    if (!graph) return NULL;
+
+    graph->nodes = (ReactiveNode*)calc_malloc(INITIAL_NODES * sizeof(ReactiveNode));
+    graph->index_keys = (hashmapconst_entry_t**)calc_calloc(INITIAL_INDEX, sizeof(hashmapconst_entry_t*));
+    graph->index_values = (uint32_t*)calc_malloc(INITIAL_INDEX * sizeof(uint32_t));
+    if (!graph->nodes || !graph->index_keys || !graph->index_values) {
+        reactive_graph_destroy(graph);
+        return NULL;
+    }
+    graph->node_capacity = INITIAL_NODES;
+    graph->index_capacity = INITIAL_INDEX;
+    return graph;
+}
+
+static void free_node(ReactiveNode* node) {
+    calc_free(node->formula);
+    calc_free(node->dependencies);
+    calc_free(node->dependents);
+}
+
+void reactive_graph_clear(ReactiveGraph* graph) {
+    if (!graph) return;
+
+    for (size_t i = 0; i < graph->node_count; i++) {
+        free_node(&graph->nodes[i]);
+    }
+    graph->node_count = 0;
+    graph->edges = 0;
+    memset(graph->index_keys, 0, graph->index_capacity * sizeof(hashmapconst_entry_t*));
+}
+
+void reactive_graph_destroy(ReactiveGraph* graph) {
+    if (!graph) return;
+
+    for (size_t i = 0; i < graph->node_count; i++) {
+        free_node(&graph->nodes[i]);
+    }
+    calc_free(graph->nodes);
+    calc_free(graph->index_keys);
+    calc_free(graph->index_values);
+    calc_free(graph->order);
+    calc_free(graph->stack_nodes);
+    calc_free(graph->stack_next);
+    calc_free(graph->scratch_dependencies);
+    calc_free(graph);
+}
+
+int reactive_enable(CalcEngine* engine) {
+    if (!engine) return -1;
+    if (engine->reactive) return 0;
+
+    engine->reactive = reactive_graph_create();
+    return engine->reactive ? 0 : -1;
+}
+
+void reactive_disable(CalcEngine* engine) {
+    if (!engine) return;
+    reactive_graph_destroy(engine->reactive);
+    engine->reactive = NULL;
+}
+
+static int grow_index(ReactiveGraph* graph) {
+    size_t capacity = graph->index_capacity * 2;
+    hashmapconst_entry_t** keys = (hashmapconst_entry_t**)calc_calloc(capacity, sizeof(hashmapconst_entry_t*));
+    uint32_t* values = (uint32_t*)calc_malloc(capacity * sizeof(uint32_t));
+    if (!keys || !values) {
+        calc_free(keys);
+        calc_free(values);
+        return -1;
+    }
+
+    for (size_t i = 0; i < graph->index_capacity; i++) {
+        if (!graph->index_keys[i]) continue;
+        size_t slot = hash_pointer(graph->index_keys[i]) & (capacity - 1);
+        while (keys[slot]) slot = (slot + 1) & (capacity - 1);
+        keys[slot] = graph->index_keys[i];
+        values[slot] = graph->index_values[i];
+    }
+
+    calc_free(graph->index_keys);
+    calc_free(graph->index_values);
+    graph->index_keys = keys;
+    graph->index_values = values;
+    graph->index_capacity = capacity;
+    return 0;
+}
+
+// Scratch arrays hold one entry per node, so every traversal fits
+static int reserve_scratch(ReactiveGraph* graph) {
+    if (graph->scratch_capacity >= graph->node_count) return 0;
+
+    size_t capacity = graph->scratch_capacity ? graph->scratch_capacity : INITIAL_NODES;
+    while (capacity < graph->node_count) capacity *= 2;
+
+    uint32_t* order = (uint32_t*)calc_realloc(graph->order, capacity * sizeof(uint32_t));
+    if (!order) return -1;
+    graph->order = order;
+    uint32_t* stack_nodes = (uint32_t*)calc_realloc(graph->stack_nodes, capacity * sizeof(uint32_t));
+    if (!stack_nodes) return -1;
+    graph->stack_nodes = stack_nodes;
+    size_t* stack_next = (size_t*)calc_realloc(graph->stack_next, capacity * sizeof(size_t));
+    if (!stack_next) return -1;
+    graph->stack_next = stack_next;
+    uint32_t* dependencies = (uint32_t*)calc_realloc(graph->scratch_dependencies, capacity * sizeof(uint32_t));
+    if (!dependencies) return -1;
+    graph->scratch_dependencies = dependencies;
+
+    graph->scratch_capacity = capacity;
+    return 0;
+}
+
+// Returns the node id of a variable, adding it as a plain input if it is new
+static int64_t node_for(ReactiveGraph* graph, hashmapconst_entry_t* variable) {
+    size_t slot = hash_pointer(variable) & (graph->index_capacity - 1);
+    while (graph->index_keys[slot]) {
+        if (graph->index_keys[slot] == variable) return graph->index_values[slot];
+        slot = (slot + 1) & (graph->index_capacity - 1);
+    }
+
+    if (graph->node_count == graph->node_capacity) {
+        ReactiveNode* nodes = (ReactiveNode*)calc_realloc(graph->nodes, graph->node_capacity * 2 * sizeof(ReactiveNode));
+        if (!nodes) return -1;
+        graph->nodes = nodes;
+        graph->node_capacity *= 2;
+    }
+
+    uint32_t id = (uint32_t)graph->node_count++;
+    memset(&graph->nodes[id], 0, sizeof(ReactiveNode));
+    graph->nodes[id].variable = variable;
+    graph->index_keys[slot] = variable;
+    graph->index_values[slot] = id;
+
+    // Keep the index at most half full
+    if (graph->node_count * 2 > graph->index_capacity && grow_index(graph) != 0) return -1;
+    return id;
+}
+
+// Collects the distinct variables an expression reads into scratch_dependencies
+static int collect_dependencies(ReactiveGraph* graph, const ASTNode* node, size_t* count) {
+    if (!node) return 0;
+
+    if (node->token->type == TOKEN_VARIABLE) {
+        int64_t id = node_for(graph, node->token->data.var_name);
+        if (id < 0 || reserve_scratch(graph) != 0) return -1;
+        if (graph->nodes[id].mark != graph->epoch) {
+            graph->nodes[id].mark = graph->epoch;
+            graph->scratch_dependencies[(*count)++] = (uint32_t)id;
+        }
+    }
+
+    if (collect_dependencies(graph, node->left, count) != 0) return -1;
+    if (collect_dependencies(graph, node->right, count) != 0) return -1;
+    return collect_dependencies(graph, node->child, count);
+}
+
+// Depth-first search along dependents from start; writes the reached nodes
+// to order in post-order, so reading it backwards is a topological order
+static size_t collect_affected(ReactiveGraph* graph, uint32_t start) {
+    size_t order_count = 0;
+    size_t depth = 0;
+
+    graph->epoch++;
+    graph->nodes[start].mark = graph->epoch;
+    graph->stack_nodes[depth] = start;
+    graph->stack_next[depth++] = 0;
+
+    while (depth > 0) {
+        ReactiveNode* node = &graph->nodes[graph->stack_nodes[depth - 1]];
+        size_t* next = &graph->stack_next[depth - 1];
+        if (*next < node->dependent_count) {
+            uint32_t dependent = node->dependents[(*next)++];
+            if (graph->nodes[dependent].mark != graph->epoch) {
+                graph->nodes[dependent].mark = graph->epoch;
+                graph->stack_nodes[depth] = dependent;
+                graph->stack_next[depth++] = 0;
+            }
+        } else {
+            graph->order[order_count++] = graph->stack_nodes[--depth];
+        }
+    }
+    return order_count;
+}
+
+static void remove_dependent(ReactiveNode* node, uint32_t dependent) {
+    for (size_t i = 0; i < node->dependent_count; i++) {
+        if (node->dependents[i] == dependent) {
+            node->dependents[i] = node->dependents[--node->dependent_count];
+            return;
+        }
+    }
+}
+
+static int add_dependent(ReactiveNode* node, uint32_t dependent) {
+    if (node->dependent_count == node->dependent_capacity) {
+        size_t capacity = node->dependent_capacity ? node->dependent_capacity * 2 : 4;
+        uint32_t* grown = (uint32_t*)calc_realloc(node->dependents, capacity * sizeof(uint32_t));
+        if (!grown) return -1;
+        node->dependents = grown;
+        node->dependent_capacity = capacity;
+    }
+    node->dependents[node->dependent_count++] = dependent;
+    return 0;
+}
+
+static ASTNode* copy_formula(const ASTNode* expression) {
+    size_t count = ast_count_nodes(expression);
+    // The root is copied first, so the formula pointer is also the allocation
+    ASTNode* nodes = (ASTNode*)calc_malloc(count * (sizeof(ASTNode) + sizeof(Token)));
+    if (!nodes) return NULL;
+    return ast_copy_tree(expression, nodes, (Token*)(nodes + count));
+}
+
+
+ComputationError reactive_assign(CalcEngine* engine, hashmapconst_entry_t* target, const ASTNode* expression, double* value) {
+    ReactiveGraph* graph = engine ? engine->reactive : NULL;
+    if (!graph || !target || !expression) return COMPUTATION_NULL_INPUT;
+
+    int64_t target_id = node_for(graph, target);
+    if (target_id < 0 || reserve_scratch(graph) != 0) return COMPUTATION_MEMORY_ERROR;
+
+    size_t dependency_count = 0;
+    graph->epoch++;
+    if (collect_dependencies(graph, expression, &dependency_count) != 0) return COMPUTATION_MEMORY_ERROR;
+
+    // Reassigning target never changes what is downstream of it, so the
+    // affected set can be computed before the edges are rewritten; the new
+    // formula closes a cycle exactly when it reads one of those variables
+    size_t affected = collect_affected(graph, (uint32_t)target_id);
+    for (size_t i = 0; i < dependency_count; i++) {
+        if (graph->nodes[graph->scratch_dependencies[i]].mark == graph->epoch) {
+            return COMPUTATION_DEPENDENCY_CYCLE;
+        }
+    }
+
+    // Like a plain assignment, one whose value fails to evaluate changes nothing
+    ComputationError error = COMPUTATION_OK;
+    double* values = engine->variables->values;
+    double assigned = evaluate_ast(expression, values, &error);
+    if (error != COMPUTATION_OK) return error;
+
+    ASTNode* formula = copy_formula(expression);
+    uint32_t* dependencies = dependency_count ? (uint32_t*)calc_malloc(dependency_count * sizeof(uint32_t)) : NULL;
+    if (!formula || (dependency_count && !dependencies)) {
+        calc_free(formula);
+        calc_free(dependencies);
+        return COMPUTATION_MEMORY_ERROR;
+    }
+    memcpy(dependencies, graph->scratch_dependencies, dependency_count * sizeof(uint32_t));
+
+    ReactiveNode* node = &graph->nodes[target_id];
+    for (size_t i = 0; i < node->dependency_count; i++) {
+        remove_dependent(&graph->nodes[node->dependencies[i]], (uint32_t)target_id);
+    }
+    graph->edges -= node->dependency_count;
+    for (size_t i = 0; i < dependency_count; i++) {
+        if (add_dependent(&graph->nodes[dependencies[i]], (uint32_t)target_id) != 0) {
+            // Keep the graph consistent: drop the edges added so far and leave target without a formula
+            for (size_t j = 0; j < i; j++) remove_dependent(&graph->nodes[dependencies[j]], (uint32_t)target_id);
+            calc_free(node->formula);
+            calc_free(node->dependencies);
+            node->formula = NULL;
+            node->dependencies = NULL;
+            node->dependency_count = 0;
+            calc_free(formula);
+            calc_free(dependencies);
+            return COMPUTATION_MEMORY_ERROR;
+        }
+    }
+    graph->edges += dependency_count;
+
+    calc_free(node->formula);
+    calc_free(node->dependencies);
+    node->formula = formula;
+    node->dependencies = dependencies;
+    node->dependency_count = dependency_count;
+
+    // order ends with target; everything before it in reverse is downstream
+    values[target->slot] = assigned;
+    *value = assigned;
+    for (size_t i = affected - 1; i-- > 0;) {
+        ReactiveNode* dependent = &graph->nodes[graph->order[i]];
+        values[dependent->variable->slot] = evaluate_ast(dependent->formula, values, NULL);
+    }
+    graph->last_recomputed = affected;
+    graph->total_recomputed += affected;
+    return COMPUTATION_OK;
+}
+
+void reactive_graph_print(FILE* out, const ReactiveGraph* graph) {
+    if (!graph) {
+        fprintf(out, "Reactive mode is off\n");
+        return;
+    }
+
+    size_t formulas = 0;
+    for (size_t i = 0; i < graph->node_count; i++) {
+        if (graph->nodes[i].formula) formulas++;
+    }
+    fprintf(out, "Reactive graph: %zu variables, %zu formulas, %zu edges; last assignment recomputed %zu, total %zu\n",
+            graph->node_count, formulas, graph->edges, graph->last_recomputed, graph->total_recomputed);
+}
@@ -0,0 +1,171 @@
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include "../../include/computation/result_sink.h"
+#include "../../include/datastructures/allocator.h"
+
+#define RING_MASK (RESULT_SINK_RING_CAPACITY - 1)
+#define FILE_BUFFER_BYTES (64 * 1024)
+// The writer publishes its progress at least this often while draining a long backlog
+#define PUBLISH_EVERY 256
+// Longest the idle writer sleeps before looking at the ring again
+#define MAX_IDLE_SLEEP_NS 1000000L
+
+static const char* MODE_NAMES[] = { "off", "buffered", "async" };
+
+int result_sink_parse_mode(const char* name, ResultSinkMode* mode) {
+    for (size_t i = 0; i < sizeof(MODE_NAMES) / sizeof(MODE_NAMES[0]); i++) {
+        if (strcmp(name, MODE_NAMES[i]) == 0) {
+            *mode = (ResultSinkMode)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void sleep_ns(long ns) {
+    struct timespec pause = { 0, ns };
+    nanosleep(&pause, NULL);
+}
+
+static void write_line(ResultSink* sink, double value) {
+    if (fprintf(sink->file, "%.17g\n", value) < 0) {
+        atomic_store_explicit(&sink->failed, 1, memory_order_relaxed);
+    }
+}
+
+static void* writer_main(void* arg) {
+    ResultSink* sink = (ResultSink*)arg;
+    long idle_sleep = 0;
+
+    for (;;) {
+        size_t tail = atomic_load_explicit(&sink->tail, memory_order_relaxed);
+        size_t head = atomic_load_explicit(&sink->head, memory_order_acquire);
+        if (tail != head) {
+            while (tail != head) {
+                write_line(sink, sink->ring[tail & RING_MASK]);
+                tail++;
+                if ((tail & (PUBLISH_EVERY - 1)) == 0) {
+                    atomic_store_explicit(&sink->tail, tail, memory_order_release);
+                }
+            }
+            atomic_store_explicit(&sink->tail, tail, memory_order_release);
+            idle_sleep = 0;
+            continue;
+        }
+
+        // Caught up: hand what is buffered to the kernel before going idle
+        if (atomic_load_explicit(&sink->flushed, memory_order_relaxed) != tail) {
+            if (fflush(sink->file) != 0) {
+                atomic_store_explicit(&sink->failed, 1, memory_order_relaxed);
+            }
+            atomic_store_explicit(&sink->flushed, tail, memory_order_release);
+        }
+        if (atomic_load_explicit(&sink->stopping, memory_order_acquire) &&
+            atomic_load_explicit(&sink->head, memory_order_acquire) == tail) {
+            return NULL;
+        }
+
+        idle_sleep = idle_sleep ? idle_sleep * 2 : 20000;
+        if (idle_sleep > MAX_IDLE_SLEEP_NS) idle_sleep = MAX_IDLE_SLEEP_NS;
+        sleep_ns(idle_sleep);
+    }
+}
+
+static void free_sink(ResultSink* sink) {
+    if (sink->file) fclose(sink->file);
+    calc_free(sink->buffer);
+    calc_free(sink->ring);
+    calc_free(sink);
+}
+
+ResultSink* result_sink_open(ResultSinkMode mode, const char* path) {
+    ResultSink* sink = (ResultSink*)calc_calloc(1, sizeof(ResultSink));
+    if (!sink) return NULL;
+    sink->mode = mode;
+    if (mode == RESULT_SINK_DISABLED) return sink;
+
+    sink->buffer = (char*)calc_malloc(FILE_BUFFER_BYTES);
+    sink->file = path ? fopen(path, "a") : NULL;
+    if (!sink->buffer || !sink->file) {
+        free_sink(sink);
+        return NULL;
+    }
+    setvbuf(sink->file, sink->buffer, _IOFBF, FILE_BUFFER_BYTES);
+
+    if (mode == RESULT_SINK_ASYNC) {
+        sink->ring = (double*)calc_malloc(RESULT_SINK_RING_CAPACITY * sizeof(double));
+        if (!sink->ring || pthread_create(&sink->writer, NULL, writer_main, sink) != 0) {
+            free_sink(sink);
+            return NULL;
+        }
+    }
+    return sink;
+}
+
+int result_sink_write(ResultSink* sink, double value) {
+    if (!sink) return 0;
+    sink->written++;
+
+    if (sink->mode == RESULT_SINK_ASYNC) {
+        size_t head = atomic_load_explicit(&sink->head, memory_order_relaxed);
+        if (head - atomic_load_explicit(&sink->tail, memory_order_acquire) == RESULT_SINK_RING_CAPACITY) {
+            // Full: wait for the writer rather than drop the result
+            sink->stalls++;
+            do {
+                sched_yield();
+            } while (head - atomic_load_explicit(&sink->tail, memory_order_acquire) == RESULT_SINK_RING_CAPACITY);
+        }
+        sink->ring[head & RING_MASK] = value;
+        atomic_store_explicit(&sink->head, head + 1, memory_order_release);
+    } else if (sink->mode == RESULT_SINK_BUFFERED) {
+        write_line(sink, value);
+    }
+
+    return atomic_load_explicit(&sink->failed, memory_order_relaxed) ? -1 : 0;
+}
+
+int result_sink_flush(ResultSink* sink) {
+    if (!sink) return 0;
+
+    if (sink->mode == RESULT_SINK_ASYNC) {
+        size_t head = atomic_load_explicit(&sink->head, memory_order_relaxed);
+        while (atomic_load_explicit(&sink->flushed, memory_order_acquire) != head) {
+            sleep_ns(20000);
+        }
+    } else if (sink->mode == RESULT_SINK_BUFFERED && fflush(sink->file) != 0) {
+        atomic_store_explicit(&sink->failed, 1, memory_order_relaxed);
+    }
+
+    return atomic_load_explicit(&sink->failed, memory_order_relaxed) ? -1 : 0;
+}
+
+void result_sink_print(FILE* out, const ResultSink* sink) {
+    if (!sink) {
+        fprintf(out, "Results are not logged\n");
+        return;
+    }
+
+    fprintf(out, "Result sink (%s): %zu results", MODE_NAMES[sink->mode], sink->written);
+    if (sink->mode == RESULT_SINK_ASYNC) {
+        fprintf(out, ", %zu pending, %zu stalls on a full ring",
+                sink->written - atomic_load_explicit(&sink->flushed, memory_order_acquire), sink->stalls);
+    }
+    fprintf(out, "%s\n", atomic_load_explicit(&sink->failed, memory_order_relaxed) ? ", WRITE ERRORS" : "");
+}
+
+int result_sink_close(ResultSink* sink) {
+    if (!sink) return 0;
+
+    if (sink->mode == RESULT_SINK_ASYNC) {
+        atomic_store_explicit(&sink->stopping, 1, memory_order_release);
+        pthread_join(sink->writer, NULL);
+    }
+    int status = atomic_load_explicit(&sink->failed, memory_order_relaxed) ? -1 : 0;
+    if (sink->file) {
+        if (fclose(sink->file) != 0) status = -1;
+        sink->file = NULL;
+    }
+    free_sink(sink);
+    return status;
+}
@@ -1,23 +1,19 @@
 #include "../../include/computation/tokenizer.h"
 #include "../../include/computation/precidence.h"
 #include "../../include/computation/shunt_yard_algo.h"
+#include "../../include/computation/engine.h"
+#include "../../include/computation/alloc_stats.h"
 
-TokenizerResult* shunt_yard_algo(TokenizerResult* input_tokens)
+static TokenizerResult* shunt_yard(CalcEngine* engine, TokenizerResult* input_tokens)
 {
     TokenizerResult *result = {0};
-    if (!input_tokens || !input_tokens->tokens) return NULL;
+    if (!engine || !input_tokens || !input_tokens->tokens) return NULL;
 
-    HashMap* precedence_map = innit_precidence(NULL);
-    if (!precedence_map) return NULL;
-
-    Token* operator_stack = (Token*)malloc(sizeof(Token) * input_tokens->token_count);
-    Token* output_queue = (Token*)malloc(sizeof(Token) * input_tokens->token_count);
-    if (!operator_stack || !output_queue) {
-        free(operator_stack);
-        free(output_queue);
-        free_hashmap(precedence_map);
-        return NULL;
-    }
+    // Both stacks live in the engine's scratch buffer, reused across calls
+    Token* scratch = calc_engine_token_scratch(engine, 2 * input_tokens->token_count);
+    if (!scratch) return NULL;
+    Token* operator_stack = scratch;
+    Token* output_queue = scratch + input_tokens->token_count;
 
     int stack_size = 0;
     int queue_size = 0;
@@ -37,7 +33,7 @@ TokenizerResult* shunt_yard_algo(TokenizerResult* input_tokens)
                 break;
                 
             case TOKEN_OPERATOR: {
-                char current_op_str[2] = {current_token.data.operator_value, '\0'};
+                const OperatorInfo* current_op = operator_info(current_token.data.operator_value);
                 
                 while(stack_size > 0) {
                     Token stack_top = operator_stack[stack_size - 1];
@@ -45,17 +41,18 @@ TokenizerResult* shunt_yard_algo(TokenizerResult* input_tokens)
                         break;
                     }
                     
-                    if (stack_top.type != TOKEN_OPERATOR) {
+                    // A pending sign binds tighter than any binary operator but '^'
+                    int stack_precedence;
+                    if (stack_top.type == TOKEN_UNARY) {
+                        stack_precedence = UNARY_PRECEDENCE;
+                    } else if (stack_top.type == TOKEN_OPERATOR) {
+                        stack_precedence = operator_info(stack_top.data.operator_value)->precedence;
+                    } else {
                         break;
                     }
 
-                    char stack_op_str[2] = {stack_top.data.operator_value, '\0'};
-                    int current_precedence = return_precidence(precedence_map, current_op_str);
-                    int stack_precedence = return_precidence(precedence_map, stack_op_str);
-                    
-                    Operator* current_op = precidence_hashmap_get(precedence_map, current_op_str);
-                    if (!current_op || (stack_precedence > current_precedence || 
-                        (current_precedence == stack_precedence && current_op->assoc == LEFT_TO_RIGHT))) {
+                    if (!current_op->is_operator || (stack_precedence > current_op->precedence ||
+                        (current_op->precedence == stack_precedence && current_op->assoc == LEFT_TO_RIGHT))) {
                         output_queue[queue_size++] = operator_stack[--stack_size];
                     } else {
                         break;
@@ -81,9 +78,6 @@ TokenizerResult* shunt_yard_algo(TokenizerResult* input_tokens)
                     }
                     
                     if (!found_left_paren) {
-                        free(operator_stack);
-                        free(output_queue);
-                        free_hashmap(precedence_map);
                         return NULL;
                     }
 
@@ -111,28 +105,29 @@ TokenizerResult* shunt_yard_algo(TokenizerResult* input_tokens)
     while(stack_size > 0) {
         Token stack_top = operator_stack[--stack_size];
         if(stack_top.type == TOKEN_PARENTHESIS) {
-            free(operator_stack);
-            free(output_queue);
-            free_hashmap(precedence_map);
             return NULL;
         }
         output_queue[queue_size++] = stack_top;
     }
 
-    free(operator_stack);
-    free_hashmap(precedence_map);
-
-    Token* final_output = (Token*)malloc(sizeof(Token) * queue_size);
-    if (!final_output) {
-        free(output_queue);
+    Token* final_output = (Token*)arena_alloc(engine->arena, sizeof(Token) * queue_size);
+    result = (TokenizerResult*)arena_alloc(engine->arena, sizeof(TokenizerResult));
+    if (!final_output || !result) {
         return NULL;
     }
     memcpy(final_output, output_queue, sizeof(Token) * queue_size);
-    free(output_queue);
     
-    result = (TokenizerResult*)malloc(sizeof(TokenizerResult)) ;
     result->tokens = final_output;
     result->token_count = queue_size;
     result->error = TOKEN_SUCCESS;
+    result->num_vars = input_tokens->num_vars;
+    return result;
+}
+
+TokenizerResult* shunt_yard_algo(CalcEngine* engine, TokenizerResult* input_tokens)
+{
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_SHUNT_YARD);
+    TokenizerResult* result = shunt_yard(engine, input_tokens);
+    alloc_stats_leave_stage(previous_stage);
     return result;
 }
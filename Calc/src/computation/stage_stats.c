@@ -0,0 +1,49 @@
+#include <stdlib.h>
+#include "../../include/computation/stage_stats.h"
+#include "../../include/datastructures/allocator.h"
+
+static const char* STAGE_NAMES[CALC_STAGE_COUNT] = {
+    "tokenize", "shunt_yard", "parse", "optimize", "evaluate"
+};
+
+StageStats* stage_stats_create(void) {
+    return (StageStats*)calc_calloc(1, sizeof(StageStats));
+}
+
+void stage_stats_reset(StageStats* stats) {
+    if (!stats) return;
+    for (int i = 0; i < CALC_STAGE_COUNT; i++) {
+        histogram_reset(&stats->stages[i]);
+    }
+}
+
+void stage_stats_merge(StageStats* stats, const StageStats* other) {
+    if (!stats || !other) return;
+    for (int i = 0; i < CALC_STAGE_COUNT; i++) {
+        histogram_merge(&stats->stages[i], &other->stages[i]);
+    }
+}
+
+void stage_stats_print(FILE* out, const StageStats* stats) {
+    if (!stats) {
+        fprintf(out, "Stage statistics are not collected (built with STAGE_STATS=0)\n");
+        return;
+    }
+
+    fprintf(out, "%-12s %10s %10s %10s %10s %10s %12s\n",
+            "stage (ns)", "count", "p50", "p99", "p99.9", "max", "mean");
+    for (int i = 0; i < CALC_STAGE_COUNT; i++) {
+        const histogram_t* histogram = &stats->stages[i];
+        fprintf(out, "%-12s %10llu %10llu %10llu %10llu %10llu %12.1f\n", STAGE_NAMES[i],
+                (unsigned long long)histogram->total,
+                (unsigned long long)histogram_percentile(histogram, 50.0),
+                (unsigned long long)histogram_percentile(histogram, 99.0),
+                (unsigned long long)histogram_percentile(histogram, 99.9),
+                (unsigned long long)histogram->max,
+                histogram_mean(histogram));
+    }
+}
+
+void stage_stats_destroy(StageStats* stats) {
+    calc_free(stats);
+}
@@ -12,11 +12,10 @@
 #include "../../include/computation/AST_tree.h"
 #include <stdbool.h>
 #include "../../include/computation/computation.h"
+#include "../../include/computation/engine.h"
+#include "../../include/computation/alloc_stats.h"
 
-#define MAX_INPUT_LENGTH 1024
-#define INITIAL_TOKEN_CAPACITY 16
 #define MAX_TOKEN_LENGTH 100
-#define BUFFER_GROWTH_FACTOR 2
 #define CONFIG_FILE "tokenizer_config.json"
 
 typedef struct {
@@ -44,44 +43,53 @@ static int load_config(void) {
     return 0;
 }
 
-TokenizerError replace_characters(const char *input, char *output, size_t output_size) {
-    if (!input || !output || output_size == 0) {
-        return TOKEN_NULL_INPUT;
-    }
-
-    static const char *special_chars = "()+-*/=^!<>{}[]&|,%";
-    static char lookup[256] = {0};
-    static int initialized = 0;
-
-    if (!initialized) {
-        for (const char *c = special_chars; *c; c++) {
-            lookup[(unsigned char)*c] = 1;
-        }
-        initialized = 1;
-    }
-
-    size_t input_len = strlen(input);
-    size_t j = 0;
-
-    if (input_len * 3 + 1 > output_size) {
-        return TOKEN_INPUT_TOO_LONG;
-    }
-
-    for (size_t i = 0; i < input_len && j < output_size - 1; i++) {
-        unsigned char current = input[i];
-        
-        if (lookup[current]) {
-            if (j + 3 > output_size - 1) return TOKEN_INPUT_TOO_LONG;
-            output[j++] = ' ';
-            output[j++] = current;
-            output[j++] = ' ';
+// Character classes for the single-pass scanner. Separators are "()+-*/=^!<>{}[]&|,%";
+// those without a token of their own are rejected. Every other byte belongs to a
+// number or identifier. A constant table, so concurrent callers share it safely
+enum { CHAR_WORD, CHAR_SPACE, CHAR_SEPARATOR, CHAR_END };
+
+static const unsigned char CHAR_CLASS[256] = {
+    ['\0'] = CHAR_END,
+    [' '] = CHAR_SPACE, ['\t'] = CHAR_SPACE, ['\n'] = CHAR_SPACE, ['\r'] = CHAR_SPACE,
+    ['\v'] = CHAR_SPACE, ['\f'] = CHAR_SPACE,
+    ['('] = CHAR_SEPARATOR, [')'] = CHAR_SEPARATOR, ['+'] = CHAR_SEPARATOR, ['-'] = CHAR_SEPARATOR,
+    ['*'] = CHAR_SEPARATOR, ['/'] = CHAR_SEPARATOR, ['='] = CHAR_SEPARATOR, ['^'] = CHAR_SEPARATOR,
+    ['!'] = CHAR_SEPARATOR, ['<'] = CHAR_SEPARATOR, ['>'] = CHAR_SEPARATOR, ['{'] = CHAR_SEPARATOR,
+    ['}'] = CHAR_SEPARATOR, ['['] = CHAR_SEPARATOR, [']'] = CHAR_SEPARATOR, ['&'] = CHAR_SEPARATOR,
+    ['|'] = CHAR_SEPARATOR, [','] = CHAR_SEPARATOR, ['%'] = CHAR_SEPARATOR
+};
+
+// Powers of ten that are exact in a double
+static const double EXACT_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Parses a plain decimal word ("42", "2.5", ".5") of up to 15 significant digits.
+// Both the digits and the power of ten are exact doubles, so the single division
+// is correctly rounded and matches strtod. Anything else is left to strtod.
+static bool parse_simple_decimal(const char* word, size_t length, double* value) {
+    unsigned long long digits = 0;
+    size_t digit_count = 0;
+    size_t fraction_digits = 0;
+    bool seen_point = false;
+
+    for (size_t i = 0; i < length; i++) {
+        char c = word[i];
+        if (c >= '0' && c <= '9') {
+            if (++digit_count > 15) return false;
+            digits = digits * 10 + (unsigned long long)(c - '0');
+            if (seen_point) fraction_digits++;
+        } else if (c == '.' && !seen_point) {
+            seen_point = true;
         } else {
-            if (j + 1 > output_size - 1) return TOKEN_INPUT_TOO_LONG;
-            output[j++] = current;
+            return false;
         }
     }
-    output[j] = '\0';
-    return TOKEN_SUCCESS;
+    if (digit_count == 0) return false;
+
+    *value = (double)digits / EXACT_POWERS_OF_TEN[fraction_digits];
+    return true;
 }
 
 TokenizerError to_lowercase(char *str, size_t max_len) {
@@ -95,235 +103,222 @@ TokenizerError to_lowercase(char *str, size_t max_len) {
     return (len == max_len && str[len] != '\0') ? TOKEN_INPUT_TOO_LONG : TOKEN_SUCCESS;
 }
 
-void free_token_array(TokenArrChar *token_array) {
-    if (!token_array || !token_array->tokens) {
-        return;
+bool is_valid_function(hashset_t* set, const char *str) {
+    if (!set || !str) return false;
+    return hashset_get_entry_lowercase(set, str, strlen(str)) != NULL;
+}
+
+hashset_t* init_SUPPORTED_FUNCTIONS_() {
+    hashset_t* set = hashset_create();
+    if (!set) {
+        fprintf(stderr, "Failed to create supported functions set\n");
+        return NULL;
     }
-    
-    for (size_t i = 0; i < token_array->size; i++) {
-        free(token_array->tokens[i]);
+    // Each name maps to its FunctionId; arity and implementation live in FUNCTION_TABLE
+    for (int id = 0; id < FUNC_COUNT; id++) {
+        hashset_add(set, FUNCTION_TABLE[id].name, id);
     }
-    
-    free(token_array->tokens);
-    token_array->tokens = NULL;
-    token_array->size = 0;
+    return set;
 }
 
-bool is_valid_function(hashset_t* set, const char *str) {
-    if (!set || !str) return false;
-    
-    char *lower_str = strdup(str);
-    if (!lower_str) return false;
-    
-    to_lowercase(lower_str, strlen(str));
-    bool result = hashset_contains(set, lower_str);
-    free(lower_str);
-    
-    return result;
+hashmapconst_t* init_VARIABLES_() {
+    hashmapconst_t* map = hashmapconst_create();
+    if (!map) {
+        fprintf(stderr, "Failed to create pre-stored variables map\n");
+        return NULL;
+    }
+    hashmapconst_add(map, "e", 2.718281828459045);
+    hashmapconst_add(map, "pi", 3.141592653589793);
+    return map;
 }
 
-int has_var = 0;
-Token* tokenize(const char *str, const char *delim, size_t *token_count, TokenizerError *error) {
-    if (!str ||!delim || !token_count) {
-        if (error) *error = TOKEN_NULL_INPUT;
-        return NULL;
+Token* tokenize(CalcEngine* engine, const char *str, size_t *token_count, TokenizerError *error) {
+    return tokenize_symbols(engine, str, NULL, token_count, error);
+}
+
+// Returns the slot for the next token, doubling the arena-backed array when it is full
+static Token* next_token(CalcEngine* engine, Token** tokens, size_t* capacity, size_t count) {
+    if (count == *capacity) {
+        size_t grown_capacity = *capacity ? *capacity * 2 : 16;
+        Token* grown = arena_alloc(engine->arena, grown_capacity * sizeof(Token));
+        if (!grown) return NULL;
+        if (count) memcpy(grown, *tokens, count * sizeof(Token));
+        *tokens = grown;
+        *capacity = grown_capacity;
     }
+    return &(*tokens)[count];
+}
 
-    *token_count = 0;
+// True when the previous token ends an operand, so a following + or - is binary
+static bool follows_operand(const Token* tokens, size_t count) {
+    if (count == 0) return false;
 
-    TokenArrChar temp_tokens = { NULL, 0 };
-    char *str_copy = strdup(str);
-    if (!str_copy) {
-        if (error) *error = TOKEN_MEMORY_ERROR;
-        return NULL;
+    const Token* previous = &tokens[count - 1];
+    return previous->type == TOKEN_NUMBER || previous->type == TOKEN_VARIABLE ||
+           (previous->type == TOKEN_PARENTHESIS && previous->data.parenthesis == ')');
+}
+
+// Resolves an identifier slice: function, then caller symbol, then engine variable
+// (substituted by value unless the engine is reactive),
+// otherwise registers it as an unknown variable (the only case that copies the name)
+static bool classify_identifier(CalcEngine* engine, hashmapconst_t* symbols, const char* name, size_t length, Token* token) {
+    // The registry is shared between engines, so it is only ever read here
+    hashset_entry_t* func_entry = hashset_get_entry_lowercase(engine->functions, name, length);
+    if (func_entry) {
+        token->type = TOKEN_FUNCTION;
+        token->data.function = function_info((FunctionId)func_entry->input_spaces);
+        return true;
+    }
+
+    hashmapconst_entry_t* var_entry = symbols ? hashmapconst_get_entry_lowercase(symbols, name, length) : NULL;
+    if (var_entry) {
+        token->type = TOKEN_VARIABLE;
+        token->slot = var_entry->slot;
+        token->data.var_name = var_entry;
+        return true;
     }
 
-    temp_tokens.tokens = malloc(INITIAL_TOKEN_CAPACITY * sizeof(char*));
-    if (!temp_tokens.tokens) {
-        free(str_copy);
-        if (error) *error = TOKEN_MEMORY_ERROR;
+    // A tree reads all its variables from one symbol table, so engine variables
+    // are only kept as references when the caller supplied none
+    var_entry = hashmapconst_get_entry_lowercase(engine->variables, name, length);
+    if (var_entry && engine->reactive && !symbols) {
+        // Reactive formulas must see which variables they read
+        token->type = TOKEN_VARIABLE;
+        token->slot = var_entry->slot;
+        token->data.var_name = var_entry;
+        return true;
+    }
+    if (var_entry) {
+        token->type = TOKEN_NUMBER;
+        token->data.num_value = engine->variables->values[var_entry->slot];
+        return true;
+    }
+
+    char* lowered = arena_alloc(engine->arena, length + 1);
+    if (!lowered) return false;
+    for (size_t i = 0; i < length; i++) {
+        lowered[i] = (char)tolower((unsigned char)name[i]);
+    }
+    lowered[length] = '\0';
+
+    engine->unknown_variables += 1;
+    hashmapconst_t* scope = symbols ? symbols : engine->variables;
+    var_entry = hashmapconst_intern(scope, lowered, 0.0);
+    if (!var_entry) return false;
+
+    token->type = TOKEN_VARIABLE;
+    token->slot = var_entry->slot;
+    token->data.var_name = var_entry;
+    return true;
+}
+
+Token* tokenize_symbols(CalcEngine* engine, const char *str, hashmapconst_t* symbols, size_t *token_count, TokenizerError *error) {
+    if (!engine || !str || !token_count) {
+        if (error) *error = TOKEN_NULL_INPUT;
         return NULL;
     }
 
-    size_t capacity = INITIAL_TOKEN_CAPACITY;
-    
-    char *token = strtok(str_copy, delim);
-    while (token) {
-        if (temp_tokens.size >= capacity) {
-            capacity *= BUFFER_GROWTH_FACTOR;
-            char **new_tokens = realloc(temp_tokens.tokens, capacity * sizeof(char*));
-            if (!new_tokens) {
-                free_token_array(&temp_tokens);
-                free(str_copy);
-                if (error) *error = TOKEN_MEMORY_ERROR;
-                return NULL;
-            }
-            temp_tokens.tokens = new_tokens;
+    *token_count = 0;
+    Token* output_array = NULL;
+    size_t capacity = 0;
+    int depth = 0;
+    TokenizerError status = TOKEN_SUCCESS;
+
+    // One pass over the caller's string: every token is classified where it stands
+    const char* p = str;
+    while (*p) {
+        unsigned char c = (unsigned char)*p;
+        if (CHAR_CLASS[c] == CHAR_SPACE) {
+            p++;
+            continue;
         }
 
-        temp_tokens.tokens[temp_tokens.size] = strdup(token);
-        if (!temp_tokens.tokens[temp_tokens.size]) {
-            free_token_array(&temp_tokens);
-            free(str_copy);
+        Token* token = next_token(engine, &output_array, &capacity, *token_count);
+        if (!token) {
             if (error) *error = TOKEN_MEMORY_ERROR;
             return NULL;
         }
 
-        temp_tokens.size++;
-        token = strtok(NULL, delim);
-    }
-
-    Token* output_array = malloc(sizeof(Token) * temp_tokens.size);
-    if (!output_array) {
-        free_token_array(&temp_tokens);
-        free(str_copy);
-        if (error) *error = TOKEN_MEMORY_ERROR;
-        return NULL;
-    }
-    int bracl = 0;
-    int bracr = 0;
-
-    for (size_t i = 0; i < temp_tokens.size; i++) {
-        const char* current = temp_tokens.tokens[i];
-        
-        if (strlen(current) == 1) {
-            char c = current[0];
-            
+        if (CHAR_CLASS[c] == CHAR_SEPARATOR) {
             if (strchr(OPERATORS, c)) {
-                if(((output_array[(*token_count)-1].type ==TOKEN_PARENTHESIS && output_array[(*token_count)-1].data.parenthesis=='(') || (output_array[(*token_count)-1].type !=TOKEN_PARENTHESIS)) && (output_array[(*token_count)-1].type !=TOKEN_NUMBER && output_array[(*token_count)-1].type !=TOKEN_PARENTHESIS) && output_array[(*token_count)-1].type !=TOKEN_VARIABLE)
-                {
-                    if(c=='-')
-                        {
-                            output_array[*token_count].type = TOKEN_UNARY;
-                            output_array[*token_count].data.unary_operator = TOKEN_UNARY_NEGATIVE;
-                        }
-                    else if(c=='+')
-                        {
-                            output_array[*token_count].type = TOKEN_UNARY;
-                            output_array[*token_count].data.unary_operator = TOKEN_UNARY_POSITIVE;
-                        }
-                }
-                else
-                {
-                    output_array[*token_count].type = TOKEN_OPERATOR;
-                    output_array[*token_count].data.operator_value = c;
-                }
-                (*token_count)++;
-                continue;
-            }
-            
-            if (c == '(' || c == ')') {
-                output_array[*token_count].type = TOKEN_PARENTHESIS;
-                output_array[*token_count].data.parenthesis = c;
-                (*token_count)++;
-                if(c == '(')
-                {
-                    bracl++;
-                }
-                else if(c == ')')
-                {
-                    bracr++;
+                if ((c == '-' || c == '+') && !follows_operand(output_array, *token_count)) {
+                    token->type = TOKEN_UNARY;
+                    token->data.unary_operator = c == '-' ? TOKEN_UNARY_NEGATIVE : TOKEN_UNARY_POSITIVE;
+                } else {
+                    token->type = TOKEN_OPERATOR;
+                    token->data.operator_value = (char)c;
                 }
-                continue;
-            }
-            
-            if (c == '=') {
-                output_array[*token_count].type = TOKEN_EQUALITY;
-                output_array[*token_count].data.equality = c;
-                (*token_count)++;
-                continue;
-            }
-            if (c == ',') {
-                output_array[*token_count].type = TOKEN_COMMA;
-                output_array[*token_count].data.comma = c;
-                (*token_count)++;
-                continue;
+            } else if (c == '(' || c == ')') {
+                token->type = TOKEN_PARENTHESIS;
+                token->data.parenthesis = (char)c;
+                depth += c == '(' ? 1 : -1;
+            } else if (c == '=') {
+                token->type = TOKEN_EQUALITY;
+                token->data.equality = (char)c;
+            } else if (c == ',') {
+                token->type = TOKEN_COMMA;
+                token->data.comma = (char)c;
+            } else {
+                // Reserved separator with no meaning yet (e.g. '%', '<', '[')
+                status = TOKEN_INVALID_INPUT;
+                break;
             }
-        }
-
-        char* endptr;
-        double num_val = strtod(current, &endptr);
-        
-        if (*endptr == '\0') {
-            output_array[*token_count].type = TOKEN_NUMBER;
-            output_array[*token_count].data.num_value = num_val;
             (*token_count)++;
+            p++;
             continue;
         }
 
-        if (is_valid_function(SUPPORTED_FUNCTIONS,current)) {
-            output_array[*token_count].type = TOKEN_FUNCTION;
-            struct hashset_entry* func_entry = hashset_get_entry(SUPPORTED_FUNCTIONS, current);
-            if (!func_entry) {
-                hashset_add(SUPPORTED_FUNCTIONS, current, 1);
-                func_entry = hashset_get_entry(SUPPORTED_FUNCTIONS, current);
+        // A word runs to the next space or separator
+        const char* word = p;
+        while (CHAR_CLASS[(unsigned char)*p] == CHAR_WORD) p++;
+        size_t length = (size_t)(p - word);
+
+        // Numbers must span the whole word: "2x" is an identifier, as is "1e" in "1e+5"
+        if ((c >= '0' && c <= '9') || c == '.') {
+            char* endptr = (char*)p;
+            double num_val;
+            if (!parse_simple_decimal(word, length, &num_val)) {
+                num_val = strtod(word, &endptr);
             }
-            output_array[*token_count].data.function_name = func_entry;
-            (*token_count)++;
-            continue;
-        }
-
-        if(hashmapconst_contains(VARIABLES,current))
-        {
-            output_array[*token_count].type = TOKEN_NUMBER;
-            output_array[*token_count].data.num_value = hashmapconst_get_value(VARIABLES,current);
-        }
-        else{
-            has_var += 1;
-            output_array[*token_count].type = TOKEN_VARIABLE;
-            struct hashmapconst_entry* var_entry = hashmapconst_get_entry(VARIABLES, current);
-            if (!var_entry) {
-                hashmapconst_add(VARIABLES, current, 0.0);
-                var_entry = hashmapconst_get_entry(VARIABLES, current);
+            if (endptr == p) {
+                token->type = TOKEN_NUMBER;
+                token->data.num_value = num_val;
+                (*token_count)++;
+                continue;
             }
-            output_array[*token_count].data.var_name = var_entry;
         }
 
+        if (!classify_identifier(engine, symbols, word, length, token)) {
+            if (error) *error = TOKEN_MEMORY_ERROR;
+            return NULL;
+        }
         (*token_count)++;
     }
-    if(bracl != bracr)
-    {
-        free_token_array(&temp_tokens);
-        free(str_copy);
-        if (error) *error = TOKEN_INVALID_INPUT;
-        return output_array;
+
+    if (status == TOKEN_SUCCESS && depth != 0) {
+        status = TOKEN_INVALID_INPUT;
     }
 
-    free_token_array(&temp_tokens);
-    free(str_copy);
-    
-    if (error) *error = TOKEN_SUCCESS;
+    if (error) *error = status;
     return output_array;
 }
 
-TokenizerResult tokenizeQuery(const char *input_string) {
-    TokenizerResult result = {NULL, 0, TOKEN_SUCCESS};
-    
-    if (!input_string) {
-        result.error = TOKEN_NULL_INPUT;
-        return result;
-    }
+TokenizerResult tokenizeQuery(CalcEngine* engine, const char *input_string) {
+    return tokenizeQuerySymbols(engine, input_string, NULL);
+}
 
-    if (strlen(input_string) > MAX_INPUT_LENGTH) {
-        result.error = TOKEN_INPUT_TOO_LONG;
-        return result;
-    }
+TokenizerResult tokenizeQuerySymbols(CalcEngine* engine, const char *input_string, hashmapconst_t* symbols) {
+    TokenizerResult result = {NULL, 0, TOKEN_SUCCESS, 0};
 
-    char processed_string[MAX_INPUT_LENGTH * 3];
-    result.error = replace_characters(input_string, processed_string, sizeof(processed_string));
-    if (result.error != TOKEN_SUCCESS) {
+    if (!engine || !input_string) {
+        result.error = TOKEN_NULL_INPUT;
         return result;
     }
 
-    to_lowercase(processed_string, strlen(processed_string));
-    
-    size_t len = strlen(processed_string);
-    if (len > 0 && processed_string[len - 1] == '\n') {
-        processed_string[len - 1] = '\0';
-    }
-
-    result.tokens = tokenize(processed_string, " ", &result.token_count, &result.error);
-    result.num_vars = has_var;
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_TOKENIZE);
+    result.tokens = tokenize_symbols(engine, input_string, symbols, &result.token_count, &result.error);
+    alloc_stats_leave_stage(previous_stage);
+    result.num_vars = engine->unknown_variables;
     return result;
 }
 
@@ -350,7 +345,7 @@ void print_token(const Token* token) {
             }
             break;
         case TOKEN_FUNCTION:
-            fprintf(stderr, "FUNCTION: %s\n", token->data.function_name->value);
+            fprintf(stderr, "FUNCTION: %s\n", token->data.function->name);
             break;
         case TOKEN_VARIABLE:
             fprintf(stderr, "VARIABLE: %s\n", token->data.var_name->name);
@@ -369,10 +364,3 @@ void print_token(const Token* token) {
     }
 }
 
-void cleanup_tokens(Token* tokens) {
-    if (!tokens) {
-        return;
-    }
-
-    free(tokens);
-}
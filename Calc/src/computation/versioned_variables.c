@@ -0,0 +1,321 @@
+#include <ctype.h>
+#include <string.h>
+#include "../../include/computation/versioned_variables.h"
+#include "../../include/computation/shunt_yard_algo.h"
+#include "../../include/computation/AST_tree.h"
+#include "../../include/computation/optimizer.h"
+#include "../../include/computation/alloc_stats.h"
+#include "../../include/computation/stage_stats.h"
+#include "../../include/datastructures/allocator.h"
+
+// Longest variable name versioned_variables_assign_text() accepts
+#define MAX_NAME_LENGTH 64
+
+static VariableSnapshot* snapshot_create(hashmapconst_t* variables, unsigned long version) {
+    VariableSnapshot* snapshot = (VariableSnapshot*)calc_calloc(1, sizeof(VariableSnapshot));
+    if (!snapshot) return NULL;
+    snapshot->variables = variables;
+    snapshot->version = version;
+    return snapshot;
+}
+
+static void snapshot_destroy(VariableSnapshot* snapshot) {
+    if (!snapshot) return;
+    hashmapconst_destroy(snapshot->variables);
+    calc_free(snapshot);
+}
+
+// Unknown names are only remembered for one evaluation: kept longer, they
+// would shadow a definition published later
+static int clear_unknown(hashmapconst_t** unknown) {
+    if ((*unknown)->size == 0) return 0;
+
+    hashmapconst_t* fresh = hashmapconst_create();
+    if (!fresh) return -1;
+    hashmapconst_destroy(*unknown);
+    *unknown = fresh;
+    return 0;
+}
+
+VersionedVariables* versioned_variables_create(const hashmapconst_t* initial) {
+    VersionedVariables* versions = (VersionedVariables*)calc_calloc(1, sizeof(VersionedVariables));
+    if (!versions) return NULL;
+
+    hashmapconst_t* variables = initial ? hashmapconst_clone(initial) : hashmapconst_create();
+    VariableSnapshot* first = variables ? snapshot_create(variables, 1) : NULL;
+    versions->writer_unknown = hashmapconst_create();
+    if (!first || !versions->writer_unknown || pthread_mutex_init(&versions->writer_lock, NULL) != 0) {
+        if (!first) hashmapconst_destroy(variables);
+        snapshot_destroy(first);
+        hashmapconst_destroy(versions->writer_unknown);
+        calc_free(versions);
+        return NULL;
+    }
+
+    atomic_init(&versions->current, first);
+    // Epoch 0 marks a reader that holds no snapshot, so the global epoch starts above it
+    atomic_init(&versions->epoch, 1);
+    for (int i = 0; i < VERSIONED_VARIABLES_MAX_READERS; i++) {
+        atomic_init(&versions->readers[i].epoch, 0);
+        atomic_init(&versions->readers[i].in_use, 0);
+    }
+    return versions;
+}
+
+int versioned_variables_register_reader(VersionedVariables* versions) {
+    if (!versions) return -1;
+
+    for (int i = 0; i < VERSIONED_VARIABLES_MAX_READERS; i++) {
+        VariableReader* reader = &versions->readers[i];
+        int expected = 0;
+        if (!atomic_compare_exchange_strong(&reader->in_use, &expected, 1)) continue;
+
+        reader->unknown = hashmapconst_create();
+        if (!reader->unknown) {
+            atomic_store(&reader->in_use, 0);
+            return -1;
+        }
+        return i;
+    }
+    return -1;
+}
+
+void versioned_variables_unregister_reader(VersionedVariables* versions, int reader) {
+    if (!versions || reader < 0 || reader >= VERSIONED_VARIABLES_MAX_READERS) return;
+
+    VariableReader* slot = &versions->readers[reader];
+    hashmapconst_destroy(slot->unknown);
+    slot->unknown = NULL;
+    atomic_store(&slot->epoch, 0);
+    atomic_store(&slot->in_use, 0);
+}
+
+const VariableSnapshot* versioned_variables_pin(VersionedVariables* versions, int reader) {
+    // Announcing the epoch before loading current is what keeps the snapshot
+    // alive: both are sequentially consistent, so a writer that retires it
+    // afterwards sees this epoch when it scans the readers
+    atomic_store(&versions->readers[reader].epoch, atomic_load(&versions->epoch));
+    return atomic_load(&versions->current);
+}
+
+void versioned_variables_unpin(VersionedVariables* versions, int reader) {
+    atomic_store_explicit(&versions->readers[reader].epoch, 0, memory_order_release);
+}
+
+// Frees retired snapshots that every pinned reader started after (writer lock held)
+static void reclaim_retired(VersionedVariables* versions) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < VERSIONED_VARIABLES_MAX_READERS; i++) {
+        uint64_t epoch = atomic_load(&versions->readers[i].epoch);
+        if (epoch != 0 && epoch < oldest) oldest = epoch;
+    }
+
+    VariableSnapshot** link = &versions->retired;
+    while (*link) {
+        VariableSnapshot* snapshot = *link;
+        if (snapshot->retired_epoch < oldest) {
+            *link = snapshot->next_retired;
+            snapshot_destroy(snapshot);
+            versions->retired_count--;
+            versions->reclaimed++;
+        } else {
+            link = &snapshot->next_retired;
+        }
+    }
+}
+
+hashmapconst_t* versioned_variables_begin_write(VersionedVariables* versions) {
+    if (!versions) return NULL;
+
+    pthread_mutex_lock(&versions->writer_lock);
+    // Only writers replace current, and they hold the lock, so it cannot be retired under us
+    hashmapconst_t* copy = hashmapconst_clone(atomic_load(&versions->current)->variables);
+    if (!copy) {
+        pthread_mutex_unlock(&versions->writer_lock);
+    }
+    return copy;
+}
+
+unsigned long versioned_variables_commit(VersionedVariables* versions, hashmapconst_t* variables) {
+    VariableSnapshot* previous = atomic_load(&versions->current);
+    VariableSnapshot* next = snapshot_create(variables, previous->version + 1);
+    if (!next) {
+        versioned_variables_abort(versions, variables);
+        return 0;
+    }
+
+    atomic_store(&versions->current, next);
+    // Readers that pin from here on load next; those pinned at or before this epoch may hold previous
+    previous->retired_epoch = atomic_fetch_add(&versions->epoch, 1);
+    previous->next_retired = versions->retired;
+    versions->retired = previous;
+    versions->retired_count++;
+    versions->published++;
+
+    reclaim_retired(versions);
+    pthread_mutex_unlock(&versions->writer_lock);
+    return next->version;
+}
+
+void versioned_variables_abort(VersionedVariables* versions, hashmapconst_t* variables) {
+    hashmapconst_destroy(variables);
+    pthread_mutex_unlock(&versions->writer_lock);
+}
+
+// Sets name in a writer's copy, adding it after the existing slots if new
+static int set_variable(hashmapconst_t* variables, const char* name, double value) {
+    if (hashmapconst_update(variables, name, value)) return 0;
+    return hashmapconst_intern(variables, name, value) ? 0 : -1;
+}
+
+unsigned long versioned_variables_assign(VersionedVariables* versions, const char* name, double value) {
+    if (!versions || !name) return 0;
+
+    hashmapconst_t* copy = versioned_variables_begin_write(versions);
+    if (!copy) return 0;
+    if (set_variable(copy, name, value) != 0) {
+        versioned_variables_abort(versions, copy);
+        return 0;
+    }
+    return versioned_variables_commit(versions, copy);
+}
+
+BatchResult variable_snapshot_evaluate(CalcEngine* engine, const VariableSnapshot* snapshot,
+                                       hashmapconst_t* unknown, const char* input) {
+    BatchResult result = {0, COMPUTATION_OK};
+    if (!engine || !snapshot || !unknown || !input || strchr(input, '=')) {
+        result.error = COMPUTATION_INVALID_OPERATION;
+        return result;
+    }
+
+    calc_engine_reset(engine);
+    // The tokenizer only looks names up in engine->variables and substitutes
+    // their values; anything it has to register goes into unknown
+    hashmapconst_t* own_variables = engine->variables;
+    engine->variables = snapshot->variables;
+
+    STAGE_TIMER_START(timer);
+    TokenizerResult tokens = tokenizeQuerySymbols(engine, input, unknown);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_TOKENIZE, timer);
+    ParseResult* ast = NULL;
+    if (tokens.error == TOKEN_SUCCESS && tokens.token_count > 0) {
+        TokenizerResult* postfix = shunt_yard_algo(engine, &tokens);
+        STAGE_TIMER_LAP(engine, CALC_STAGE_SHUNT_YARD, timer);
+        if (postfix) {
+            ast = parse_expression(engine, postfix);
+            STAGE_TIMER_LAP(engine, CALC_STAGE_PARSE, timer);
+            optimize_parse_result(engine, ast);
+            STAGE_TIMER_LAP(engine, CALC_STAGE_OPTIMIZE, timer);
+        }
+    }
+    engine->variables = own_variables;
+
+    int previous_stage = alloc_stats_enter_stage(CALC_STAGE_EVALUATE);
+    if (!ast || ast->error != AST_OK || !ast->root) {
+        result.error = COMPUTATION_INVALID_OPERATION;
+    } else {
+        result.value = evaluate_ast(ast->root, unknown->values, &result.error);
+    }
+    alloc_stats_leave_stage(previous_stage);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_EVALUATE, timer);
+    return result;
+}
+
+BatchResult versioned_variables_evaluate(VersionedVariables* versions, int reader, CalcEngine* engine, const char* input) {
+    BatchResult result = {0, COMPUTATION_INVALID_OPERATION};
+    if (!versions || reader < 0 || reader >= VERSIONED_VARIABLES_MAX_READERS) return result;
+
+    VariableReader* slot = &versions->readers[reader];
+    const VariableSnapshot* snapshot = versioned_variables_pin(versions, reader);
+    result = variable_snapshot_evaluate(engine, snapshot, slot->unknown, input);
+    versioned_variables_unpin(versions, reader);
+
+    if (clear_unknown(&slot->unknown) != 0) {
+        result.error = COMPUTATION_INVALID_OPERATION;
+    }
+    return result;
+}
+
+// Copies the identifier before '=' into name, lowercased as the tokenizer stores it
+static const char* parse_target(const char* input, char* name) {
+    const char* equals = strchr(input, '=');
+    if (!equals) return NULL;
+
+    const char* start = input;
+    while (isspace((unsigned char)*start)) start++;
+    const char* end = equals;
+    while (end > start && isspace((unsigned char)end[-1])) end--;
+
+    size_t length = (size_t)(end - start);
+    if (length == 0 || length >= MAX_NAME_LENGTH || !isalpha((unsigned char)*start)) return NULL;
+    for (size_t i = 0; i < length; i++) {
+        if (!isalnum((unsigned char)start[i]) && start[i] != '_') return NULL;
+        name[i] = (char)tolower((unsigned char)start[i]);
+    }
+    name[length] = '\0';
+    return equals + 1;
+}
+
+BatchResult versioned_variables_assign_text(VersionedVariables* versions, CalcEngine* engine, const char* input) {
+    BatchResult result = {0, COMPUTATION_INVALID_OPERATION};
+    if (!versions || !engine || !input) return result;
+
+    char name[MAX_NAME_LENGTH];
+    const char* expression = parse_target(input, name);
+    if (!expression || hashset_get_entry_lowercase(engine->functions, name, strlen(name))) {
+        return result;
+    }
+
+    hashmapconst_t* copy = versioned_variables_begin_write(versions);
+    if (!copy) return result;
+
+    // The expression reads the version this write replaces, which the lock keeps current
+    VariableSnapshot base = { copy, 0, 0, NULL };
+    result = variable_snapshot_evaluate(engine, &base, versions->writer_unknown, expression);
+    if (clear_unknown(&versions->writer_unknown) != 0) {
+        result.error = COMPUTATION_INVALID_OPERATION;
+    }
+
+    if (result.error != COMPUTATION_OK || set_variable(copy, name, result.value) != 0) {
+        if (result.error == COMPUTATION_OK) result.error = COMPUTATION_INVALID_OPERATION;
+        versioned_variables_abort(versions, copy);
+        return result;
+    }
+    if (versioned_variables_commit(versions, copy) == 0) {
+        result.error = COMPUTATION_INVALID_OPERATION;
+    }
+    return result;
+}
+
+void versioned_variables_print(FILE* out, VersionedVariables* versions) {
+    if (!versions) return;
+
+    pthread_mutex_lock(&versions->writer_lock);
+    const VariableSnapshot* current = atomic_load(&versions->current);
+    int readers = 0;
+    for (int i = 0; i < VERSIONED_VARIABLES_MAX_READERS; i++) {
+        readers += atomic_load(&versions->readers[i].in_use);
+    }
+    fprintf(out, "Variables: version %lu (%zu names), %d readers registered\n",
+            current->version, current->variables->size, readers);
+    fprintf(out, "Snapshots: %zu published, %zu reclaimed, %zu awaiting readers\n",
+            versions->published, versions->reclaimed, versions->retired_count);
+    pthread_mutex_unlock(&versions->writer_lock);
+}
+
+void versioned_variables_destroy(VersionedVariables* versions) {
+    if (!versions) return;
+
+    while (versions->retired) {
+        VariableSnapshot* snapshot = versions->retired;
+        versions->retired = snapshot->next_retired;
+        snapshot_destroy(snapshot);
+    }
+    snapshot_destroy(atomic_load(&versions->current));
+    for (int i = 0; i < VERSIONED_VARIABLES_MAX_READERS; i++) {
+        hashmapconst_destroy(versions->readers[i].unknown);
+    }
+    hashmapconst_destroy(versions->writer_unknown);
+    pthread_mutex_destroy(&versions->writer_lock);
+    calc_free(versions);
+}
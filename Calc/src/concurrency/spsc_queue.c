@@ -0,0 +1,89 @@
+#include <sched.h>
+#include "../../include/concurrency/spsc_queue.h"
+#include "../../include/datastructures/allocator.h"
+
+// Polls of the other side's counter before a waiting thread yields its CPU
+#define SPIN_LIMIT 64
+
+int spsc_queue_init(SpscQueue* queue, size_t capacity) {
+    size_t rounded = 2;
+    while (rounded < capacity) rounded *= 2;
+
+    queue->slots = (void**)calc_calloc(rounded, sizeof(void*));
+    if (!queue->slots) return -1;
+    queue->mask = rounded - 1;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->cached_tail = 0;
+    queue->cached_head = 0;
+    spsc_queue_reset_stats(queue);
+    return 0;
+}
+
+size_t spsc_queue_capacity(const SpscQueue* queue) {
+    return queue->mask + 1;
+}
+
+bool spsc_queue_try_push(SpscQueue* queue, void* item) {
+    size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    if (head - queue->cached_tail > queue->mask) {
+        queue->cached_tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        if (head - queue->cached_tail > queue->mask) return false;
+    }
+
+    queue->slots[head & queue->mask] = item;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    queue->pushes++;
+    // The cached tail can lag far behind; occupancy wants the consumer's real position
+    queue->occupancy_sum += head - atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    return true;
+}
+
+void spsc_queue_push(SpscQueue* queue, void* item) {
+    if (spsc_queue_try_push(queue, item)) return;
+
+    queue->full_waits++;
+    for (unsigned spins = 0; !spsc_queue_try_push(queue, item); spins++) {
+        if (spins >= SPIN_LIMIT) sched_yield();
+    }
+}
+
+bool spsc_queue_try_pop(SpscQueue* queue, void** item) {
+    size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    if (tail == queue->cached_head) {
+        queue->cached_head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        if (tail == queue->cached_head) return false;
+    }
+
+    *item = queue->slots[tail & queue->mask];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+void* spsc_queue_pop(SpscQueue* queue) {
+    void* item;
+    if (spsc_queue_try_pop(queue, &item)) return item;
+
+    queue->empty_waits++;
+    for (unsigned spins = 0; !spsc_queue_try_pop(queue, &item); spins++) {
+        if (spins >= SPIN_LIMIT) sched_yield();
+    }
+    return item;
+}
+
+double spsc_queue_mean_occupancy(const SpscQueue* queue) {
+    return queue->pushes ? (double)queue->occupancy_sum / (double)queue->pushes : 0.0;
+}
+
+void spsc_queue_reset_stats(SpscQueue* queue) {
+    queue->pushes = 0;
+    queue->occupancy_sum = 0;
+    queue->full_waits = 0;
+    queue->empty_waits = 0;
+}
+
+void spsc_queue_destroy(SpscQueue* queue) {
+    if (!queue) return;
+    calc_free(queue->slots);
+    queue->slots = NULL;
+}
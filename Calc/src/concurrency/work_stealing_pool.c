@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "../../include/concurrency/work_stealing_pool.h"
+#include "../../include/datastructures/allocator.h"
+
+#define WS_CHUNKS_PER_WORKER 16
+#define WS_CACHE_LINE 64
+
+typedef struct {
+    _Alignas(WS_CACHE_LINE) _Atomic long top;
+    _Alignas(WS_CACHE_LINE) _Atomic long bottom;
+    size_t* items;
+    size_t capacity;
+} WorkDeque;
+
+typedef struct {
+    WorkStealingPool* pool;
+    size_t index;
+} WorkerArg;
+
+struct WorkStealingPool {
+    pthread_t* threads;
+    WorkerArg* args;
+    WorkDeque* deques;
+    size_t size;
+
+    pthread_mutex_t lock;
+    pthread_cond_t start_cond;
+    pthread_cond_t done_cond;
+    unsigned long generation;
+    size_t active_workers;
+    bool stopping;
+
+    ws_task_fn fn;
+    void* context;
+    size_t task_count;
+    size_t grain;
+};
+
+static void deque_push(WorkDeque* deque, size_t item) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    deque->items[(size_t)b & (deque->capacity - 1)] = item;
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+}
+
+static bool deque_take(WorkDeque* deque, size_t* item) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *item = deque->items[(size_t)b & (deque->capacity - 1)];
+    if (t == b) {
+        bool won = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                           memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return won;
+    }
+    return true;
+}
+
+// Returns 1 on success, 0 when the deque is empty, -1 when another thread won the race
+static int deque_steal(WorkDeque* deque, size_t* item) {
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+    if (t >= b) {
+        return 0;
+    }
+
+    size_t candidate = deque->items[(size_t)t & (deque->capacity - 1)];
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return -1;
+    }
+    *item = candidate;
+    return 1;
+}
+
+static bool steal_any(WorkStealingPool* pool, size_t self, size_t* item) {
+    for (size_t k = 1; k < pool->size; k++) {
+        WorkDeque* victim = &pool->deques[(self + k) % pool->size];
+        int status;
+        while ((status = deque_steal(victim, item)) < 0) {
+        }
+        if (status > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void run_chunk(WorkStealingPool* pool, size_t chunk, size_t worker) {
+    size_t begin = chunk * pool->grain;
+    size_t end = begin + pool->grain;
+    if (end > pool->task_count) end = pool->task_count;
+
+    for (size_t i = begin; i < end; i++) {
+        pool->fn(pool->context, i, worker);
+    }
+}
+
+static void* worker_main(void* arg) {
+    WorkerArg* self = (WorkerArg*)arg;
+    WorkStealingPool* pool = self->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->stopping && pool->generation == seen) {
+            pthread_cond_wait(&pool->start_cond, &pool->lock);
+        }
+        if (pool->stopping) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        // Deques are filled before a run starts and never refilled, so once
+        // the own deque and every victim are empty there is nothing left to do
+        size_t chunk;
+        while (deque_take(&pool->deques[self->index], &chunk) || steal_any(pool, self->index, &chunk)) {
+            run_chunk(pool, chunk, self->index);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active_workers == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    return NULL;
+}
+
+static size_t next_power_of_two(size_t value) {
+    size_t power = 1;
+    while (power < value) power <<= 1;
+    return power;
+}
+
+WorkStealingPool* ws_pool_create(size_t threads) {
+    if (threads == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = online > 0 ? (size_t)online : 1;
+    }
+
+    WorkStealingPool* pool = (WorkStealingPool*)calc_calloc(1, sizeof(WorkStealingPool));
+    if (!pool) return NULL;
+
+    pool->size = threads;
+    pool->threads = (pthread_t*)calc_calloc(threads, sizeof(pthread_t));
+    pool->args = (WorkerArg*)calc_calloc(threads, sizeof(WorkerArg));
+    // Cache-line aligned, so the deques come from the C library, not calc_malloc
+    pool->deques = (WorkDeque*)aligned_alloc(WS_CACHE_LINE, threads * sizeof(WorkDeque));
+    if (!pool->threads || !pool->args || !pool->deques) {
+        calc_free(pool->threads);
+        calc_free(pool->args);
+        free(pool->deques);
+        calc_free(pool);
+        return NULL;
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        atomic_init(&pool->deques[i].top, 0);
+        atomic_init(&pool->deques[i].bottom, 0);
+        pool->deques[i].items = NULL;
+        pool->deques[i].capacity = 0;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    for (size_t i = 0; i < threads; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->args[i]) != 0) {
+            pool->size = i;
+            ws_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+size_t ws_pool_size(const WorkStealingPool* pool) {
+    return pool ? pool->size : 0;
+}
+
+int ws_pool_run(WorkStealingPool* pool, ws_task_fn fn, void* context, size_t task_count, size_t grain) {
+    if (!pool || !fn) return -1;
+    if (task_count == 0) return 0;
+
+    if (grain == 0) {
+        grain = task_count / (pool->size * WS_CHUNKS_PER_WORKER);
+        if (grain == 0) grain = 1;
+    }
+    size_t chunk_count = (task_count + grain - 1) / grain;
+    size_t per_worker = next_power_of_two((chunk_count + pool->size - 1) / pool->size);
+
+    for (size_t i = 0; i < pool->size; i++) {
+        WorkDeque* deque = &pool->deques[i];
+        if (deque->capacity < per_worker) {
+            size_t* items = (size_t*)calc_realloc(deque->items, per_worker * sizeof(size_t));
+            if (!items) return -1;
+            deque->items = items;
+            deque->capacity = per_worker;
+        }
+        atomic_store_explicit(&deque->top, 0, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, 0, memory_order_relaxed);
+    }
+
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+        deque_push(&pool->deques[chunk % pool->size], chunk);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->context = context;
+    pool->task_count = task_count;
+    pool->grain = grain;
+    pool->active_workers = pool->size;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start_cond);
+    while (pool->active_workers > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return 0;
+}
+
+void ws_pool_destroy(WorkStealingPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (size_t i = 0; i < pool->size; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start_cond);
+    pthread_cond_destroy(&pool->done_cond);
+
+    for (size_t i = 0; pool->deques && i < pool->size; i++) {
+        calc_free(pool->deques[i].items);
+    }
+    free(pool->deques);
+    calc_free(pool->threads);
+    calc_free(pool->args);
+    calc_free(pool);
+}
@@ -0,0 +1,63 @@
+#include "../../include/datastructures/allocator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+static void* libc_malloc(size_t size, void* context) {
+    (void)context;
+    return malloc(size);
+}
+
+static void* libc_realloc(void* ptr, size_t size, void* context) {
+    (void)context;
+    return realloc(ptr, size);
+}
+
+static void libc_free(void* ptr, void* context) {
+    (void)context;
+    free(ptr);
+}
+
+static const calc_allocator_t LIBC_ALLOCATOR = { libc_malloc, libc_realloc, libc_free, NULL };
+
+static calc_allocator_t current_allocator = { libc_malloc, libc_realloc, libc_free, NULL };
+
+void calc_set_allocator(const calc_allocator_t* allocator) {
+    current_allocator = allocator ? *allocator : LIBC_ALLOCATOR;
+}
+
+const calc_allocator_t* calc_get_allocator(void) {
+    return &current_allocator;
+}
+
+bool calc_allocator_is_default(void) {
+    return current_allocator.malloc_fn == libc_malloc && current_allocator.realloc_fn == libc_realloc &&
+           current_allocator.free_fn == libc_free;
+}
+
+void* calc_malloc(size_t size) {
+    return current_allocator.malloc_fn(size, current_allocator.context);
+}
+
+void* calc_calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+
+    void* ptr = calc_malloc(count * size);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* calc_realloc(void* ptr, size_t size) {
+    return current_allocator.realloc_fn(ptr, size, current_allocator.context);
+}
+
+void calc_free(void* ptr) {
+    if (ptr) current_allocator.free_fn(ptr, current_allocator.context);
+}
+
+char* calc_strdup(const char* value) {
+    size_t length = strlen(value) + 1;
+    char* copy = (char*)calc_malloc(length);
+    if (copy) memcpy(copy, value, length);
+    return copy;
+}
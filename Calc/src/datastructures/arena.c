@@ -0,0 +1,95 @@
+#include "../../include/datastructures/arena.h"
+#include "../../include/datastructures/allocator.h"
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1);
+}
+
+arena_t* arena_create(void) {
+    arena_t* arena = (arena_t*)calc_malloc(sizeof(arena_t));
+    if (!arena) return NULL;
+
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->block_allocations = 0;
+    return arena;
+}
+
+static arena_block_t* arena_new_block(arena_t* arena, size_t minimum) {
+    size_t capacity = arena->current ? arena->current->capacity * 2 : ARENA_INITIAL_BLOCK_SIZE;
+    while (capacity < minimum) capacity *= 2;
+
+    arena_block_t* block = (arena_block_t*)calc_malloc(sizeof(arena_block_t) + capacity);
+    if (!block) return NULL;
+
+    block->capacity = capacity;
+    block->used = 0;
+    block->next = NULL;
+    arena->block_allocations++;
+    return block;
+}
+
+void* arena_alloc(arena_t* arena, size_t size) {
+    if (!arena) return NULL;
+
+    size = align_up(size ? size : 1);
+
+    // Walk forward through blocks kept from before the last reset
+    while (arena->current && arena->current->capacity - arena->current->used < size) {
+        if (!arena->current->next) break;
+        arena->current = arena->current->next;
+    }
+
+    arena_block_t* block = arena->current;
+    if (!block || block->capacity - block->used < size) {
+        arena_block_t* fresh = arena_new_block(arena, size);
+        if (!fresh) return NULL;
+        if (block) {
+            block->next = fresh;
+        } else {
+            arena->head = fresh;
+        }
+        arena->current = fresh;
+        block = fresh;
+    }
+
+    void* memory = block->data + block->used;
+    block->used += size;
+    return memory;
+}
+
+void* arena_calloc(arena_t* arena, size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) return NULL;
+
+    void* memory = arena_alloc(arena, count * size);
+    if (memory) {
+        memset(memory, 0, count * size);
+    }
+    return memory;
+}
+
+void arena_reset(arena_t* arena) {
+    if (!arena) return;
+
+    for (arena_block_t* block = arena->head; block; block = block->next) {
+        block->used = 0;
+    }
+    arena->current = arena->head;
+}
+
+void arena_destroy(arena_t* arena) {
+    if (!arena) return;
+
+    arena_block_t* block = arena->head;
+    while (block) {
+        arena_block_t* next = block->next;
+        calc_free(block);
+        block = next;
+    }
+    calc_free(arena);
+}
@@ -1,6 +1,8 @@
 #include "../../include/datastructures/hashmapforconst.h"
+#include "../../include/datastructures/allocator.h"
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 unsigned int hashmapconst_hash(const char* name) {
     unsigned int hash = 0;
@@ -12,15 +14,15 @@ unsigned int hashmapconst_hash(const char* name) {
 }
 
 hashmapconst_t* hashmapconst_create(void) {
-    hashmapconst_t* map = (hashmapconst_t*)malloc(sizeof(hashmapconst_t));
+    hashmapconst_t* map = (hashmapconst_t*)calc_malloc(sizeof(hashmapconst_t));
     if (!map) return NULL;
     
     map->capacity = HASHMAPCONST_INITIAL_SIZE;
     map->size = 0;
-    map->table = (hashmapconst_entry_t**)malloc(sizeof(hashmapconst_entry_t*) * map->capacity);
+    map->table = (hashmapconst_entry_t**)calc_malloc(sizeof(hashmapconst_entry_t*) * map->capacity);
     
     if (!map->table) {
-        free(map);
+        calc_free(map);
         return NULL;
     }
 
@@ -28,9 +30,40 @@ hashmapconst_t* hashmapconst_create(void) {
         map->table[i] = NULL;
     }
 
+    map->slot_count = 0;
+    map->slot_capacity = HASHMAPCONST_INITIAL_SIZE;
+    map->values = (double*)calc_malloc(sizeof(double) * map->slot_capacity);
+    map->slots = (hashmapconst_entry_t**)calc_malloc(sizeof(hashmapconst_entry_t*) * map->slot_capacity);
+    if (!map->values || !map->slots) {
+        hashmapconst_destroy(map);
+        return NULL;
+    }
+
     return map;
 }
 
+hashmapconst_t* hashmapconst_clone(const hashmapconst_t* map) {
+    if (!map) return NULL;
+
+    hashmapconst_t* copy = hashmapconst_create();
+    if (!copy) return NULL;
+
+    // Adding in slot order hands out the same slots; a removed name leaves a
+    // placeholder so later slots do not shift
+    for (size_t slot = 0; slot < map->slot_count; slot++) {
+        const hashmapconst_entry_t* entry = map->slots[slot];
+        if (!hashmapconst_add(copy, entry ? entry->name : "", map->values[slot])) {
+            hashmapconst_destroy(copy);
+            return NULL;
+        }
+        if (!entry) {
+            hashmapconst_remove(copy, "");
+        }
+    }
+
+    return copy;
+}
+
 void hashmapconst_destroy(hashmapconst_t* map) {
     if (!map) return;
 
@@ -39,16 +72,32 @@ void hashmapconst_destroy(hashmapconst_t* map) {
         while (entry) {
             hashmapconst_entry_t* temp = entry;
             entry = entry->next;
-            free(temp->name);
-            free(temp);
+            calc_free(temp->name);
+            calc_free(temp);
         }
     }
 
-    free(map->table);
-    free(map);
+    calc_free(map->table);
+    calc_free(map->values);
+    calc_free(map->slots);
+    calc_free(map);
+}
+
+static int reserve_slot(hashmapconst_t* map) {
+    if (map->slot_count < map->slot_capacity) return 1;
+
+    size_t capacity = map->slot_capacity * 2;
+    double* values = (double*)calc_realloc(map->values, sizeof(double) * capacity);
+    if (!values) return 0;
+    map->values = values;
+    hashmapconst_entry_t** slots = (hashmapconst_entry_t**)calc_realloc(map->slots, sizeof(hashmapconst_entry_t*) * capacity);
+    if (!slots) return 0;
+    map->slots = slots;
+    map->slot_capacity = capacity;
+    return 1;
 }
 
-int hashmapconst_add(hashmapconst_t* map, const char* value, const float input_value)   {
+int hashmapconst_add(hashmapconst_t* map, const char* value, const double input_value)   {
     if (!map || !value) return 0;
 
     unsigned int index = hashmapconst_hash(value) % map->capacity;
@@ -61,15 +110,19 @@ int hashmapconst_add(hashmapconst_t* map, const char* value, const float input_v
         entry = entry->next;
     }
 
-    hashmapconst_entry_t* new_entry = (hashmapconst_entry_t*)malloc(sizeof(hashmapconst_entry_t));
+    if (!reserve_slot(map)) return 0;
+
+    hashmapconst_entry_t* new_entry = (hashmapconst_entry_t*)calc_malloc(sizeof(hashmapconst_entry_t));
     if (!new_entry) return 0;
 
-    new_entry->name = strdup(value);
-    new_entry->input_value = input_value;
+    new_entry->name = calc_strdup(value);
     if (!new_entry->name) {
-        free(new_entry);
+        calc_free(new_entry);
         return 0;
     }
+    new_entry->slot = (unsigned int)map->slot_count++;
+    map->slots[new_entry->slot] = new_entry;
+    map->values[new_entry->slot] = input_value;
 
     new_entry->next = map->table[index];
     map->table[index] = new_entry;
@@ -82,7 +135,7 @@ int hashmapconst_add(hashmapconst_t* map, const char* value, const float input_v
     return 1;
 }
 
-int hashmapconst_update(hashmapconst_t* map, const char* value, const float input_value)   {
+int hashmapconst_update(hashmapconst_t* map, const char* value, const double input_value)   {
     if (!map || !value) return 0;
 
     unsigned int index = hashmapconst_hash(value) % map->capacity;
@@ -90,7 +143,7 @@ int hashmapconst_update(hashmapconst_t* map, const char* value, const float inpu
 
     while (entry) {
         if (strcmp(entry->name, value) == 0) {
-            entry->input_value =input_value;
+            map->values[entry->slot] = input_value;
             return 1;
         }
         entry = entry->next;
@@ -113,8 +166,9 @@ void hashmapconst_remove(hashmapconst_t* map, const char* name) {
                 map->table[index] = entry->next;
             }
 
-            free(entry->name);
-            free(entry);
+            map->slots[entry->slot] = NULL;
+            calc_free(entry->name);
+            calc_free(entry);
             map->size--;
             return;
         }
@@ -144,7 +198,7 @@ void hashmapconst_resize(hashmapconst_t* map) {
     if (!map) return;
 
     size_t new_capacity = map->capacity * 2;
-    hashmapconst_entry_t** new_table = (hashmapconst_entry_t**)malloc(sizeof(hashmapconst_entry_t*) * new_capacity);
+    hashmapconst_entry_t** new_table = (hashmapconst_entry_t**)calc_malloc(sizeof(hashmapconst_entry_t*) * new_capacity);
     if (!new_table) return;
 
     for (size_t i = 0; i < new_capacity; i++) {
@@ -154,26 +208,20 @@ void hashmapconst_resize(hashmapconst_t* map) {
     for (size_t i = 0; i < map->capacity; i++) {
         hashmapconst_entry_t* entry = map->table[i];
         while (entry) {
+            hashmapconst_entry_t* next = entry->next;
             unsigned int new_index = hashmapconst_hash(entry->name) % new_capacity;
-
-            hashmapconst_entry_t* new_entry = (hashmapconst_entry_t*)malloc(sizeof(hashmapconst_entry_t));
-            if (!new_entry) return;
-
-            new_entry->name = entry->name;
-            new_entry->input_value = entry->input_value;
-            new_entry->next = new_table[new_index];
-            new_table[new_index] = new_entry;
-
-            entry = entry->next;
+            entry->next = new_table[new_index];
+            new_table[new_index] = entry;
+            entry = next;
         }
     }
 
-    free(map->table);
+    calc_free(map->table);
     map->table = new_table;
     map->capacity = new_capacity;
 }
 
-float hashmapconst_get_value(hashmapconst_t* map, const char* key) {
+double hashmapconst_get_value(hashmapconst_t* map, const char* key) {
     if (!map || !key) return -1;
 
     unsigned int index = hashmapconst_hash(key) % map->capacity;
@@ -181,7 +229,7 @@ float hashmapconst_get_value(hashmapconst_t* map, const char* key) {
 
     while (entry) {
         if (strcmp(entry->name, key) == 0) {
-            return entry->input_value;
+            return map->values[entry->slot];
         }
         entry = entry->next;
     }
@@ -204,3 +252,32 @@ hashmapconst_entry_t* hashmapconst_get_entry(hashmapconst_t* map, const char* ke
 
     return NULL;
 }
+
+hashmapconst_entry_t* hashmapconst_get_entry_lowercase(hashmapconst_t* map, const char* key, size_t length) {
+    if (!map || !key) return NULL;
+
+    unsigned int hash = 0;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash * 31) + (char)tolower((unsigned char)key[i]);
+    }
+    hashmapconst_entry_t* entry = map->table[hash % map->capacity];
+
+    while (entry) {
+        size_t i = 0;
+        while (i < length && entry->name[i] == (char)tolower((unsigned char)key[i])) i++;
+        if (i == length && entry->name[length] == '\0') {
+            return entry;
+        }
+        entry = entry->next;
+    }
+
+    return NULL;
+}
+
+hashmapconst_entry_t* hashmapconst_intern(hashmapconst_t* map, const char* name, const double input_value) {
+    hashmapconst_entry_t* entry = hashmapconst_get_entry(map, name);
+    if (entry || !hashmapconst_add(map, name, input_value)) {
+        return entry;
+    }
+    return map->slots[map->slot_count - 1];
+}
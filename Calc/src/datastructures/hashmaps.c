@@ -1,4 +1,5 @@
 #include "../../include/datastructures/hashmaps.h"
+#include "../../include/datastructures/allocator.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,17 +13,17 @@ unsigned int hashmap_hash(const char* key) {
 }
 
 hashmap_t* hashmap_create(void) {
-    hashmap_t* hashmap = (hashmap_t*)malloc(sizeof(hashmap_t));
+    hashmap_t* hashmap = (hashmap_t*)calc_malloc(sizeof(hashmap_t));
     if (!hashmap) {
         return NULL;
     }
 
     hashmap->capacity = HASHMAP_INITIAL_SIZE;
     hashmap->size = 0;
-    hashmap->table = (hashmap_entry_t**)calloc(hashmap->capacity, sizeof(hashmap_entry_t*));
+    hashmap->table = (hashmap_entry_t**)calc_calloc(hashmap->capacity, sizeof(hashmap_entry_t*));
 
     if (!hashmap->table) {
-        free(hashmap);
+        calc_free(hashmap);
         return NULL;
     }
 
@@ -37,14 +38,14 @@ void hashmap_destroy(hashmap_t* hashmap) {
         while (entry) {
             hashmap_entry_t* temp = entry;
             entry = entry->next;
-            free(temp->key);
-            free(temp->value);
-            free(temp);
+            calc_free(temp->key);
+            calc_free(temp->value);
+            calc_free(temp);
         }
     }
 
-    free(hashmap->table);
-    free(hashmap);
+    calc_free(hashmap->table);
+    calc_free(hashmap);
 }
 
 void hashmap_put(hashmap_t* hashmap, const char* key, const char* value) {
@@ -53,16 +54,16 @@ void hashmap_put(hashmap_t* hashmap, const char* key, const char* value) {
 
     while (entry) {
         if (strcmp(entry->key, key) == 0) {
-            free(entry->value);
-            entry->value = strdup(value);
+            calc_free(entry->value);
+            entry->value = calc_strdup(value);
             return;
         }
         entry = entry->next;
     }
 
-    hashmap_entry_t* new_entry = (hashmap_entry_t*)malloc(sizeof(hashmap_entry_t));
-    new_entry->key = strdup(key);
-    new_entry->value = strdup(value);
+    hashmap_entry_t* new_entry = (hashmap_entry_t*)calc_malloc(sizeof(hashmap_entry_t));
+    new_entry->key = calc_strdup(key);
+    new_entry->value = calc_strdup(value);
     new_entry->next = hashmap->table[hash];
     hashmap->table[hash] = new_entry;
     hashmap->size++;
@@ -97,9 +98,9 @@ void hashmap_remove(hashmap_t* hashmap, const char* key) {
             } else {
                 hashmap->table[hash] = entry->next;
             }
-            free(entry->key);
-            free(entry->value);
-            free(entry);
+            calc_free(entry->key);
+            calc_free(entry->value);
+            calc_free(entry);
             hashmap->size--;
             return;
         }
@@ -126,7 +127,7 @@ void hashmap_resize(hashmap_t* hashmap) {
     hashmap_entry_t** old_table = hashmap->table;
 
     hashmap->capacity *= 2;
-    hashmap->table = (hashmap_entry_t**)calloc(hashmap->capacity, sizeof(hashmap_entry_t*));
+    hashmap->table = (hashmap_entry_t**)calc_calloc(hashmap->capacity, sizeof(hashmap_entry_t*));
 
     if (!hashmap->table) {
         return;
@@ -143,5 +144,5 @@ void hashmap_resize(hashmap_t* hashmap) {
         }
     }
 
-    free(old_table);
+    calc_free(old_table);
 }
@@ -1,6 +1,8 @@
 #include "../../include/datastructures/hashset.h"
+#include "../../include/datastructures/allocator.h"
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 
 unsigned int hashset_hash(const char* value) {
     unsigned int hash = 0;
@@ -12,15 +14,15 @@ unsigned int hashset_hash(const char* value) {
 }
 
 hashset_t* hashset_create(void) {
-    hashset_t* set = (hashset_t*)malloc(sizeof(hashset_t));
+    hashset_t* set = (hashset_t*)calc_malloc(sizeof(hashset_t));
     if (!set) return NULL;
     
     set->capacity = HASHSET_INITIAL_SIZE;
     set->size = 0;
-    set->table = (hashset_entry_t**)malloc(sizeof(hashset_entry_t*) * set->capacity);
+    set->table = (hashset_entry_t**)calc_malloc(sizeof(hashset_entry_t*) * set->capacity);
     
     if (!set->table) {
-        free(set);
+        calc_free(set);
         return NULL;
     }
 
@@ -39,13 +41,13 @@ void hashset_destroy(hashset_t* set) {
         while (entry) {
             hashset_entry_t* temp = entry;
             entry = entry->next;
-            free(temp->value);
-            free(temp);
+            calc_free(temp->value);
+            calc_free(temp);
         }
     }
 
-    free(set->table);
-    free(set);
+    calc_free(set->table);
+    calc_free(set);
 }
 
 int hashset_add(hashset_t* set, const char* value, const int input_spaces) {
@@ -61,13 +63,13 @@ int hashset_add(hashset_t* set, const char* value, const int input_spaces) {
         entry = entry->next;
     }
 
-    hashset_entry_t* new_entry = (hashset_entry_t*)malloc(sizeof(hashset_entry_t));
+    hashset_entry_t* new_entry = (hashset_entry_t*)calc_malloc(sizeof(hashset_entry_t));
     if (!new_entry) return 0;
 
-    new_entry->value = strdup(value);
+    new_entry->value = calc_strdup(value);
     new_entry->input_spaces = input_spaces;
     if (!new_entry->value) {
-        free(new_entry);
+        calc_free(new_entry);
         return 0;
     }
 
@@ -97,8 +99,8 @@ void hashset_remove(hashset_t* set, const char* value) {
                 set->table[index] = entry->next;
             }
 
-            free(entry->value);
-            free(entry);
+            calc_free(entry->value);
+            calc_free(entry);
             set->size--;
             return;
         }
@@ -128,7 +130,7 @@ void hashset_resize(hashset_t* set) {
     if (!set) return;
 
     size_t new_capacity = set->capacity * 2;
-    hashset_entry_t** new_table = (hashset_entry_t**)malloc(sizeof(hashset_entry_t*) * new_capacity);
+    hashset_entry_t** new_table = (hashset_entry_t**)calc_malloc(sizeof(hashset_entry_t*) * new_capacity);
     if (!new_table) return;
 
     for (size_t i = 0; i < new_capacity; i++) {
@@ -140,7 +142,7 @@ void hashset_resize(hashset_t* set) {
         while (entry) {
             unsigned int new_index = hashset_hash(entry->value) % new_capacity;
 
-            hashset_entry_t* new_entry = (hashset_entry_t*)malloc(sizeof(hashset_entry_t));
+            hashset_entry_t* new_entry = (hashset_entry_t*)calc_malloc(sizeof(hashset_entry_t));
             if (!new_entry) return;
 
             new_entry->value = entry->value;
@@ -151,7 +153,7 @@ void hashset_resize(hashset_t* set) {
         }
     }
 
-    free(set->table);
+    calc_free(set->table);
     set->table = new_table;
     set->capacity = new_capacity;
 }
@@ -187,3 +189,24 @@ hashset_entry_t* hashset_get_entry(hashset_t* set, const char* key) {
 
     return NULL;
 }
+
+hashset_entry_t* hashset_get_entry_lowercase(hashset_t* set, const char* key, size_t length) {
+    if (!set || !key) return NULL;
+
+    unsigned int hash = 0;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash * 31) + (char)tolower((unsigned char)key[i]);
+    }
+    hashset_entry_t* entry = set->table[hash % set->capacity];
+
+    while (entry) {
+        size_t i = 0;
+        while (i < length && entry->value[i] == (char)tolower((unsigned char)key[i])) i++;
+        if (i == length && entry->value[length] == '\0') {
+            return entry;
+        }
+        entry = entry->next;
+    }
+
+    return NULL;
+}
@@ -0,0 +1,84 @@
+#include "../../include/datastructures/histogram.h"
+#include <string.h>
+#include <math.h>
+
+// Bits of sub-bucket precision above the exact range (HISTOGRAM_SUB_BUCKETS == 1 << 5)
+#define SUB_BUCKET_BITS 5
+// log2(HISTOGRAM_EXACT_LIMIT): the first magnitude that is split into sub-buckets
+#define FIRST_MAGNITUDE 6
+
+static size_t bucket_index(uint64_t value) {
+    if (value < HISTOGRAM_EXACT_LIMIT) {
+        return (size_t)value;
+    }
+
+    int magnitude = 63 - __builtin_clzll(value);
+    if (magnitude >= HISTOGRAM_MAX_MAGNITUDE) {
+        return HISTOGRAM_BUCKETS - 1;
+    }
+    size_t sub_bucket = (size_t)(value >> (magnitude - SUB_BUCKET_BITS)) - HISTOGRAM_SUB_BUCKETS;
+    return HISTOGRAM_EXACT_LIMIT + (size_t)(magnitude - FIRST_MAGNITUDE) * HISTOGRAM_SUB_BUCKETS + sub_bucket;
+}
+
+// Largest value that lands in the bucket
+static uint64_t bucket_upper_bound(size_t index) {
+    if (index < HISTOGRAM_EXACT_LIMIT) {
+        return index;
+    }
+
+    size_t offset = index - HISTOGRAM_EXACT_LIMIT;
+    int shift = (int)(offset / HISTOGRAM_SUB_BUCKETS) + FIRST_MAGNITUDE - SUB_BUCKET_BITS;
+    uint64_t lower = (uint64_t)(HISTOGRAM_SUB_BUCKETS + offset % HISTOGRAM_SUB_BUCKETS) << shift;
+    return lower + ((uint64_t)1 << shift) - 1;
+}
+
+void histogram_reset(histogram_t* histogram) {
+    if (!histogram) return;
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+void histogram_record(histogram_t* histogram, uint64_t value) {
+    if (!histogram) return;
+
+    histogram->counts[bucket_index(value)]++;
+    if (histogram->total == 0 || value < histogram->min) histogram->min = value;
+    if (value > histogram->max) histogram->max = value;
+    histogram->total++;
+    histogram->sum += (double)value;
+}
+
+void histogram_merge(histogram_t* histogram, const histogram_t* other) {
+    if (!histogram || !other || other->total == 0) return;
+
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        histogram->counts[i] += other->counts[i];
+    }
+    if (histogram->total == 0 || other->min < histogram->min) histogram->min = other->min;
+    if (other->max > histogram->max) histogram->max = other->max;
+    histogram->total += other->total;
+    histogram->sum += other->sum;
+}
+
+uint64_t histogram_percentile(const histogram_t* histogram, double percentile) {
+    if (!histogram || histogram->total == 0) return 0;
+
+    if (percentile < 0.0) percentile = 0.0;
+    if (percentile > 100.0) percentile = 100.0;
+    uint64_t rank = (uint64_t)ceil(percentile / 100.0 * (double)histogram->total);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            uint64_t value = bucket_upper_bound(i);
+            return value < histogram->max ? value : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+double histogram_mean(const histogram_t* histogram) {
+    if (!histogram || histogram->total == 0) return 0.0;
+    return histogram->sum / (double)histogram->total;
+}
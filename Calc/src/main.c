@@ -5,12 +5,24 @@
 #include <readline/readline.h>
 #include <readline/history.h>
 #include <stdbool.h>
+#include <time.h>
+#include <signal.h>
 #include "../include/computation/tokenizer.h"
 #include "../include/datastructures/hashset.h"
 #include "../include/datastructures/hashmapforconst.h"
 #include "../include/computation/shunt_yard_algo.h"
 #include "../include/computation/AST_tree.h"
 #include "../include/computation/computation.h"
+#include "../include/computation/compiled_expression.h"
+#include "../include/computation/batch.h"
+#include "../include/computation/engine.h"
+#include "../include/computation/optimizer.h"
+#include "../include/computation/alloc_stats.h"
+#include "../include/computation/expression_cache.h"
+#include "../include/computation/reactive.h"
+#include "../include/computation/result_sink.h"
+#include "../include/computation/pipeline.h"
+#include "../include/server/daemon.h"
 
 #define MAX_INPUT_LENGTH 1024
 #define INITIAL_TOKEN_CAPACITY 16
@@ -18,7 +30,7 @@
 #define BUFFER_GROWTH_FACTOR 2
 #define CONFIG_FILE "tokenizer_config.json"
 
-TokenizerResult tokenize_input(const char* input) {
+TokenizerResult tokenize_input(CalcEngine* engine, const char* input) {
     TokenizerResult result = {0};
     
     if (!input || strlen(input) == 0) {
@@ -26,11 +38,9 @@ TokenizerResult tokenize_input(const char* input) {
         return result;
     }
 
-    char processed_input[MAX_INPUT_LENGTH];
-    strncpy(processed_input, input, MAX_INPUT_LENGTH - 1);
-    processed_input[MAX_INPUT_LENGTH - 1] = '\0';
-
-    result = tokenizeQuery(processed_input);
+    STAGE_TIMER_START(timer);
+    result = tokenizeQuery(engine, input);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_TOKENIZE, timer);
 
     if (result.error != TOKEN_SUCCESS) {
         return result;
@@ -39,36 +49,318 @@ TokenizerResult tokenize_input(const char* input) {
     return result;
 }
 
-ComputationResult calculate_from_tokens(TokenizerResult* tokens) {
+ComputationResult calculate_from_tokens(CalcEngine* engine, TokenizerResult* tokens) {
     ComputationResult final_result = {0};
     TokenizerResult* shunt_yard_result = NULL;
     ParseResult* ast_root = NULL;
 
-    shunt_yard_result = shunt_yard_algo(tokens);
+    STAGE_TIMER_START(timer);
+    shunt_yard_result = shunt_yard_algo(engine, tokens);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_SHUNT_YARD, timer);
     if (!shunt_yard_result || shunt_yard_result->error != TOKEN_SUCCESS) {
         final_result.error = COMPUTATION_MEMORY_ERROR;
-        free(shunt_yard_result);
         return final_result;
     }
 
-    ast_root = parse_expression(shunt_yard_result);
+    ast_root = parse_expression(engine, shunt_yard_result);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_PARSE, timer);
     if (!ast_root) {
-        cleanup_tokens(shunt_yard_result->tokens, shunt_yard_result->token_count);
-        free(shunt_yard_result);
         final_result.error = COMPUTATION_MEMORY_ERROR;
         return final_result;
     }
+    optimize_parse_result(engine, ast_root);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_OPTIMIZE, timer);
 
-    final_result = compute_ast(ast_root);
-
-    cleanup_tokens(shunt_yard_result->tokens, shunt_yard_result->token_count);
-    cleanup_ast(ast_root);
-    free(shunt_yard_result);
+    final_result = compute_ast(engine, ast_root);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_EVALUATE, timer);
 
     return final_result;
 }
 
-void process_custom_input() {
+ComputationResult calculate_from_ast(CalcEngine* engine, ParseResult* ast) {
+    STAGE_TIMER_START(timer);
+    ComputationResult result = compute_ast(engine, ast);
+    STAGE_TIMER_LAP(engine, CALC_STAGE_EVALUATE, timer);
+    return result;
+}
+
+static double elapsed_seconds(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Blank and whitespace-only lines are echoed as empty lines, so output line N always answers input line N
+static bool is_blank_line(const char* line) {
+    while (isspace((unsigned char)*line)) line++;
+    return *line == '\0';
+}
+
+// Evaluates one batch line, taking repeated expressions from the engine's cache
+static ComputationResult evaluate_batch_line(CalcEngine* engine, const char* line) {
+    calc_engine_reset(engine);
+    ParseResult* cached = expression_cache_parse(engine, line);
+    if (cached) {
+        return calculate_from_ast(engine, cached);
+    }
+
+    TokenizerResult token_result = tokenize_input(engine, line);
+    if (token_result.error != TOKEN_SUCCESS || is_malformed_assignment(line, &token_result)) {
+        ComputationResult failed = {0};
+        failed.error = COMPUTATION_INVALID_OPERATION;
+        return failed;
+    }
+    return calculate_from_tokens(engine, &token_result);
+}
+
+int process_batch_input(CalcEngine* engine, FILE* in, FILE* out) {
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t line_length;
+    size_t evaluated = 0;
+    size_t failed = 0;
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while ((line_length = getline(&line, &line_capacity, in)) != -1) {
+        while (line_length > 0 && (line[line_length - 1] == '\n' || line[line_length - 1] == '\r')) {
+            line[--line_length] = '\0';
+        }
+        if (is_blank_line(line)) {
+            fputc('\n', out);
+            continue;
+        }
+
+        evaluated++;
+        ComputationResult calc_result = evaluate_batch_line(engine, line);
+
+        if (calc_result.error == COMPUTATION_OK) {
+            fprintf(out, "%.15g\n", calc_result.value);
+        } else {
+            fputs("error\n", out);
+            failed++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(line);
+    fflush(out);
+
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT)) {
+        double seconds = elapsed_seconds(&start, &end);
+        fprintf(stderr, "Evaluated %zu expressions (%zu failed) in %.3f s: %.0f expressions/sec\n",
+                evaluated, failed, seconds, seconds > 0 ? evaluated / seconds : 0.0);
+    }
+
+    return failed == 0 ? 0 : 1;
+}
+
+static void free_lines(char** lines, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        free(lines[i]);
+    }
+}
+
+int process_zero_alloc_check(CalcEngine* engine, FILE* in) {
+    char** lines = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t line_length;
+
+    // Tree dumps allocate; only the check's own report is printed
+    if (engine->verbosity > CALC_VERBOSITY_RESULT) {
+        engine->verbosity = CALC_VERBOSITY_RESULT;
+    }
+    while ((line_length = getline(&line, &line_capacity, in)) != -1) {
+        while (line_length > 0 && (line[line_length - 1] == '\n' || line[line_length - 1] == '\r')) {
+            line[--line_length] = '\0';
+        }
+        if (line_length == 0) {
+            continue;
+        }
+        if (count == capacity) {
+            size_t grown_capacity = capacity ? capacity * BUFFER_GROWTH_FACTOR : INITIAL_TOKEN_CAPACITY;
+            char** grown = realloc(lines, grown_capacity * sizeof(char*));
+            if (grown) {
+                lines = grown;
+                capacity = grown_capacity;
+            }
+        }
+        // A partly read script would pass the check without covering every line
+        char* copy = count < capacity ? strdup(line) : NULL;
+        if (!copy) {
+            fprintf(stderr, "Out of memory reading the zero-allocation check input\n");
+            free(line);
+            free_lines(lines, count);
+            free(lines);
+            return 1;
+        }
+        lines[count++] = copy;
+    }
+    free(line);
+
+    // The first pass grows the arena and scratch buffers and registers every
+    // unknown name; the second must then run without touching the heap
+    for (size_t i = 0; i < count; i++) {
+        evaluate_batch_line(engine, lines[i]);
+    }
+    alloc_stats_reset();
+    alloc_stats_forbid(true);
+    for (size_t i = 0; i < count; i++) {
+        evaluate_batch_line(engine, lines[i]);
+    }
+    alloc_stats_forbid(false);
+
+    AllocReport report;
+    alloc_stats_report(&report);
+    alloc_stats_print(stderr);
+    fprintf(stderr, "Zero-allocation check %s: %zu expressions, %zu allocations after warmup\n",
+            report.unexpected == 0 ? "passed" : "FAILED", count, report.unexpected);
+
+    free_lines(lines, count);
+    free(lines);
+    return report.unexpected == 0 ? 0 : 1;
+}
+
+#define BATCH_WINDOW 65536
+
+typedef int (*WindowEvaluator)(void* evaluator, char* const* lines, size_t count, BatchResult* results);
+
+static int run_batch_evaluate(void* evaluator, char* const* lines, size_t count, BatchResult* results) {
+    return batch_evaluate((BatchEvaluator*)evaluator, lines, count, results);
+}
+
+static int run_pipeline_evaluate(void* evaluator, char* const* lines, size_t count, BatchResult* results) {
+    return pipeline_evaluate((PipelineEvaluator*)evaluator, lines, count, results);
+}
+
+// Feeds in to evaluate BATCH_WINDOW lines at a time and writes one result per line to out.
+// Workers evaluate in clones without a sink, so results are logged here, in input order
+static int evaluate_in_windows(FILE* in, FILE* out, ResultSink* sink, WindowEvaluator evaluate, void* evaluator,
+                               size_t* evaluated, size_t* failed, double* seconds) {
+    char** lines = malloc(BATCH_WINDOW * sizeof(char*));
+    BatchResult* results = malloc(BATCH_WINDOW * sizeof(BatchResult));
+    if (!lines || !results) {
+        free(lines);
+        free(results);
+        return -1;
+    }
+
+    char* line = NULL;
+    size_t line_capacity = 0;
+    ssize_t line_length;
+    size_t pending = 0;
+    bool at_end = false;
+    int status = 0;
+    struct timespec start, end;
+
+    *evaluated = 0;
+    *failed = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (!at_end) {
+        line_length = getline(&line, &line_capacity, in);
+        if (line_length == -1) {
+            at_end = true;
+        } else {
+            while (line_length > 0 && (line[line_length - 1] == '\n' || line[line_length - 1] == '\r')) {
+                line[--line_length] = '\0';
+            }
+            // Blank lines keep their place in the window so the output stays aligned
+            lines[pending] = strdup(line);
+            if (!lines[pending]) {
+                fprintf(stderr, "Out of memory reading batch input\n");
+                status = -1;
+                at_end = true;
+            } else {
+                pending++;
+            }
+        }
+
+        if (pending == BATCH_WINDOW || (at_end && pending > 0)) {
+            if (status != 0 || evaluate(evaluator, lines, pending, results) != 0) {
+                free_lines(lines, pending);
+                status = -1;
+                at_end = true;
+                pending = 0;
+            }
+            for (size_t i = 0; i < pending; i++) {
+                if (is_blank_line(lines[i])) {
+                    fputc('\n', out);
+                    continue;
+                }
+                (*evaluated)++;
+                if (results[i].error == COMPUTATION_OK) {
+                    fprintf(out, "%.15g\n", results[i].value);
+                    result_sink_write(sink, results[i].value);
+                } else {
+                    fputs("error\n", out);
+                    (*failed)++;
+                }
+            }
+            free_lines(lines, pending);
+            pending = 0;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fflush(out);
+    *seconds = elapsed_seconds(&start, &end);
+
+    free(line);
+    free(lines);
+    free(results);
+    return status;
+}
+
+int process_parallel_batch_input(CalcEngine* engine, FILE* in, FILE* out, size_t threads) {
+    BatchEvaluator* evaluator = batch_evaluator_create(engine, threads);
+    if (!evaluator) {
+        fprintf(stderr, "Failed to start %zu worker threads\n", threads);
+        return 1;
+    }
+
+    size_t evaluated, failed;
+    double seconds;
+    int status = evaluate_in_windows(in, out, engine->result_sink, run_batch_evaluate, evaluator, &evaluated, &failed, &seconds);
+
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT)) {
+        fprintf(stderr, "Evaluated %zu expressions (%zu failed) on %zu threads in %.3f s: %.0f expressions/sec\n",
+                evaluated, failed, ws_pool_size(evaluator->pool), seconds, seconds > 0 ? evaluated / seconds : 0.0);
+    }
+
+    batch_evaluator_destroy(evaluator);
+    return status == 0 && failed == 0 ? 0 : 1;
+}
+
+int process_pipeline_batch_input(CalcEngine* engine, FILE* in, FILE* out, size_t depth, bool print_stats) {
+    PipelineEvaluator* evaluator = pipeline_evaluator_create(engine, depth);
+    if (!evaluator) {
+        fprintf(stderr, "Failed to set up the evaluation pipeline\n");
+        return 1;
+    }
+
+    size_t evaluated, failed;
+    double seconds;
+    int status = evaluate_in_windows(in, out, engine->result_sink, run_pipeline_evaluate, evaluator, &evaluated, &failed, &seconds);
+    if (status != 0) {
+        fprintf(stderr, "Failed to start the pipeline stage threads\n");
+    }
+
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT)) {
+        fprintf(stderr, "Evaluated %zu expressions (%zu failed) in a 3-stage pipeline in %.3f s: %.0f expressions/sec\n",
+                evaluated, failed, seconds, seconds > 0 ? evaluated / seconds : 0.0);
+    }
+    if (print_stats) {
+        pipeline_evaluator_print(stderr, evaluator);
+    }
+
+    pipeline_evaluator_destroy(evaluator);
+    return status == 0 && failed == 0 ? 0 : 1;
+}
+
+void process_custom_input(CalcEngine* engine) {
     char input[MAX_INPUT_LENGTH];
     TokenizerResult token_result;
     ComputationResult calc_result;
@@ -89,96 +381,455 @@ void process_custom_input() {
             fprintf(stderr, "\nEnter another expression (or 'quit' to return to menu):\n> ");
             continue;
         }
+        else if (strncmp(input, "\\stats", 6) == 0) {
+            if (strstr(input + 6, "reset")) {
+                stage_stats_reset(engine->stage_stats);
+            } else {
+                stage_stats_print(stderr, engine->stage_stats);
+                expression_cache_print(stderr, engine->expression_cache);
+                if (engine->reactive) {
+                    reactive_graph_print(stderr, engine->reactive);
+                }
+                result_sink_print(stderr, engine->result_sink);
+            }
+            fprintf(stderr, "\nEnter another expression (or 'quit' to return to menu):\n> ");
+            continue;
+        }
+        else if (strncmp(input, "\\verbosity", 10) == 0) {
+            char level[16] = "";
+            if (sscanf(input + 10, "%15s", level) == 1 && calc_verbosity_parse(level, &engine->verbosity) == 0) {
+                fprintf(stderr, "Verbosity set to %s\n", level);
+            } else {
+                fprintf(stderr, "Usage: \\verbosity quiet|result|tokens|tree|trace\n");
+            }
+            fprintf(stderr, "\nEnter another expression (or 'quit' to return to menu):\n> ");
+            continue;
+        }
         else if (strncmp(input, "\\version", 8) == 0) {
             fprintf(stderr, "Scientific Calculator Version 1.0\n");
             fprintf(stderr, "\nEnter another expression (or 'quit' to return to menu):\n> ");
             continue;
         }
-        char *equals_pos = strchr(input, '='); 
-        token_result = tokenize_input(input);
+        calc_engine_reset(engine);
+        token_result = tokenize_input(engine, input);
         if (token_result.error != TOKEN_SUCCESS) {
             fprintf(stderr, "Error tokenizing input: ");
             continue;
         }
-        if(equals_pos != NULL && (token_result.tokens[0].type != TOKEN_VARIABLE || (token_result.tokens[0].type == TOKEN_VARIABLE && token_result.tokens[1].type != TOKEN_EQUALITY  ) )  ) {
-            cleanup_tokens(token_result.tokens, token_result.token_count);
+        if(is_malformed_assignment(input, &token_result)) {
             token_result.error = TOKEN_INVALID_INPUT;
             fprintf(stderr, "Invalid input \"VAR = VALUE\" is the kind of supported input for computation or variables \n");
             fprintf(stderr, "\nEnter another expression (or 'quit' to return to menu):\n> ");
             continue;
         }
         else {
-            fprintf(stderr, "\nTokenization result:\n");
-            for (size_t i = 0; i < token_result.token_count; i++) {
-                fprintf(stderr, "Token %zu: ", i + 1);
-                print_token(&token_result.tokens[i]);
+            if (CALC_VERBOSE(engine, CALC_VERBOSITY_TOKENS)) {
+                fprintf(stderr, "\nTokenization result:\n");
+                for (size_t i = 0; i < token_result.token_count; i++) {
+                    fprintf(stderr, "Token %zu: ", i + 1);
+                    print_token(&token_result.tokens[i]);
+                }
             }
             
-            calc_result = calculate_from_tokens(&token_result);
+            calc_result = calculate_from_tokens(engine, &token_result);
             
             if (calc_result.error == COMPUTATION_OK) {
-                fprintf(stderr, "\nResult: %f\n", calc_result.value);
+                if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT)) {
+                    fprintf(stderr, "\nResult: %f\n", calc_result.value);
+                }
+                if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT) && engine->reactive && engine->reactive->last_recomputed > 1) {
+                    fprintf(stderr, "Recomputed %zu dependent variables\n", engine->reactive->last_recomputed - 1);
+                }
+            } else if (calc_result.error == COMPUTATION_DEPENDENCY_CYCLE) {
+                fprintf(stderr, "\nAssignment rejected: it would make the variable depend on itself\n");
             } else {
                 fprintf(stderr, "\nComputation error occurred\n");
             }
-
-            cleanup_tokens(token_result.tokens, token_result.token_count);
             
             fprintf(stderr, "\nEnter another expression (or 'quit' to return to menu):\n> ");
         }
     }
 }
 
-hashset_t* SUPPORTED_FUNCTIONS;
-hashset_t* init_SUPPORTED_FUNCTIONS_() {
-    hashset_t* set = hashset_create();
-    if (!set) {
-        fprintf(stderr, "Failed to create supported functions set\n");
-        return NULL;
+#define MAX_COLUMNS 64
+#define INITIAL_ROW_CAPACITY 1024
+
+typedef struct {
+    char* names[MAX_COLUMNS];
+    double* data[MAX_COLUMNS];
+    size_t count;
+    size_t rows;
+    size_t capacity;
+} ColumnTable;
+
+static void free_column_table(ColumnTable* table) {
+    for (size_t i = 0; i < table->count; i++) {
+        free(table->names[i]);
+        free(table->data[i]);
     }
-    hashset_add(set, "sin",1);
-    hashset_add(set, "cos",1);
-    hashset_add(set, "tan",1);
-    hashset_add(set, "logbase",2);
-    hashset_add(set, "log",1);
-    hashset_add(set, "sqrt",1);
-    hashset_add(set, "exp",1);
-    hashset_add(set, "abs",1);
-    hashset_add(set, "log10",1);
-    hashset_add(set, "log2",1);
-    hashset_add(set, "loge",1);
-    return set;
 }
 
-hashmapconst_t* VARIABLES;
-hashmapconst_t* init_VARIABLES_() {
-    hashmapconst_t* map = hashmapconst_create();
-    if (!map) {
-        fprintf(stderr, "Failed to create pre-stored variables map\n");
-        return NULL;
+static char* trim_field(char* field) {
+    while (isspace((unsigned char)*field)) field++;
+    char* end = field + strlen(field);
+    while (end > field && isspace((unsigned char)end[-1])) *--end = '\0';
+    return field;
+}
+
+static int read_column_table(FILE* in, ColumnTable* table) {
+    char* line = NULL;
+    size_t line_capacity = 0;
+
+    if (getline(&line, &line_capacity, in) == -1) {
+        fprintf(stderr, "Missing CSV header naming the variables\n");
+        free(line);
+        return -1;
+    }
+
+    for (char* field = strtok(line, ","); field && table->count < MAX_COLUMNS; field = strtok(NULL, ",")) {
+        table->names[table->count] = strdup(trim_field(field));
+        table->data[table->count] = malloc(INITIAL_ROW_CAPACITY * sizeof(double));
+        if (!table->names[table->count] || !table->data[table->count]) {
+            table->count++;
+            free(line);
+            return -1;
+        }
+        table->count++;
+    }
+    table->capacity = INITIAL_ROW_CAPACITY;
+
+    while (getline(&line, &line_capacity, in) != -1) {
+        if (trim_field(line)[0] == '\0') {
+            continue;
+        }
+        if (table->rows >= table->capacity) {
+            table->capacity *= BUFFER_GROWTH_FACTOR;
+            for (size_t c = 0; c < table->count; c++) {
+                double* grown = realloc(table->data[c], table->capacity * sizeof(double));
+                if (!grown) {
+                    free(line);
+                    return -1;
+                }
+                table->data[c] = grown;
+            }
+        }
+
+        char* cursor = line;
+        for (size_t c = 0; c < table->count; c++) {
+            char* end;
+            table->data[c][table->rows] = strtod(cursor, &end);
+            if (end == cursor) {
+                fprintf(stderr, "Invalid value in row %zu, column %s\n", table->rows + 1, table->names[c]);
+                free(line);
+                return -1;
+            }
+            cursor = strchr(end, ',');
+            cursor = cursor ? cursor + 1 : end;
+        }
+        table->rows++;
     }
-    hashmapconst_add(map, "e", 2.71828f);
-    hashmapconst_add(map, "pi", 3.14159f);
-    return map;
+
+    free(line);
+    return 0;
 }
 
-int main() {
-    SUPPORTED_FUNCTIONS = init_SUPPORTED_FUNCTIONS_();
-    if (!SUPPORTED_FUNCTIONS) {
-        fprintf(stderr, "Initialization of supported functions failed\n");
+int process_column_input(CalcEngine* engine, const char* expression, FILE* in, FILE* out) {
+    ColumnTable table = {0};
+    CompileError compile_error;
+    struct timespec start, end;
+
+    if (read_column_table(in, &table) != 0) {
+        free_column_table(&table);
         return 1;
     }
 
-    VARIABLES = init_VARIABLES_();
-    if(!VARIABLES) {
-        fprintf(stderr, "Inititalisation of variables failed");
+    CompiledExpression* expr = compile_expression(engine, expression, (const char* const*)table.names, table.count, &compile_error);
+    if (!expr && compile_error == COMPILE_DUPLICATE_VARIABLE) {
+        fprintf(stderr, "Column names must be distinct\n");
+        free_column_table(&table);
+        return 1;
+    }
+    if (!expr) {
+        fprintf(stderr, "Failed to compile expression (error %d)\n", compile_error);
+        free_column_table(&table);
+        return 1;
+    }
+    if (expr->variable_count > table.count) {
+        fprintf(stderr, "Variable '%s' has no column\n", expr->variables[table.count]->name);
+        compiled_expression_free(expr);
+        free_column_table(&table);
         return 1;
     }
 
-    process_custom_input();
+    double* results = malloc((table.rows + 1) * sizeof(double));
+    if (!results) {
+        compiled_expression_free(expr);
+        free_column_table(&table);
+        return 1;
+    }
 
-    hashset_destroy(SUPPORTED_FUNCTIONS);
-    hashmapconst_destroy(VARIABLES);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = compiled_expression_evaluate_columns(expr, (const double* const*)table.data, table.rows, results);
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-    return 0;
+    if (status == 0) {
+        for (size_t i = 0; i < table.rows; i++) {
+            fprintf(out, "%.15g\n", results[i]);
+        }
+        fflush(out);
+        double seconds = elapsed_seconds(&start, &end);
+        if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT)) {
+            fprintf(stderr, "Evaluated %zu rows in %.6f s (%s kernels): %.0f rows/sec\n",
+                    table.rows, seconds, bytecode_column_isa(), seconds > 0 ? table.rows / seconds : 0.0);
+        }
+    }
+
+    free(results);
+    compiled_expression_free(expr);
+    free_column_table(&table);
+    return status == 0 ? 0 : 1;
+}
+
+static CalcDaemon* serving_daemon;
+
+static void stop_serving(int signal_number) {
+    (void)signal_number;
+    calc_daemon_stop(serving_daemon);
+}
+
+int process_daemon(CalcEngine* engine, const char* path, size_t threads) {
+    serving_daemon = calc_daemon_create(engine, path, threads);
+    if (!serving_daemon) {
+        perror(path);
+        return 1;
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stop_serving;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT)) {
+        fprintf(stderr, "Serving on %s with %zu workers; SIGINT or SIGTERM stops\n",
+                path, calc_daemon_workers(serving_daemon));
+    }
+    int status = calc_daemon_run(serving_daemon) == 0 ? 0 : 1;
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    if (CALC_VERBOSE(engine, CALC_VERBOSITY_RESULT)) {
+        calc_daemon_print(stderr, serving_daemon);
+    }
+    calc_daemon_destroy(serving_daemon);
+    serving_daemon = NULL;
+    return status;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--verbosity LEVEL] [--trace-optimizer] [--stats] [--alloc-stats] [--cache-bytes N] [--reactive]\n"
+                    "          [--sink off|buffered|async] [--sink-file PATH]\n"
+                    "          [--batch [FILE] [--threads N | --pipeline [DEPTH]] | --check-zero-alloc [FILE] | --columns EXPRESSION [FILE]\n"
+                    "           | --serve SOCKET [--threads N]]\n", program);
+    fprintf(stderr, "  --batch [FILE]                Evaluate one expression per line from FILE (or stdin),\n");
+    fprintf(stderr, "                                writing one result per line to stdout (an empty\n");
+    fprintf(stderr, "                                line for a blank or whitespace-only input line)\n");
+    fprintf(stderr, "  --threads N                   Spread batch evaluation over N worker threads\n");
+    fprintf(stderr, "                                (0 = one per CPU); output keeps input order\n");
+    fprintf(stderr, "  --pipeline [DEPTH]            Tokenize, parse and evaluate batch lines on three threads\n");
+    fprintf(stderr, "                                joined by queues of DEPTH entries (default %d); --stats\n", PIPELINE_DEFAULT_DEPTH);
+    fprintf(stderr, "                                adds each stage's busy and waiting time\n");
+    fprintf(stderr, "  --serve SOCKET                Answer length-prefixed requests on a Unix domain socket\n");
+    fprintf(stderr, "                                until SIGINT or SIGTERM; --threads N sets the workers\n");
+    fprintf(stderr, "                                (0 = one per CPU, the default)\n");
+    fprintf(stderr, "  --columns EXPRESSION [FILE]   Evaluate EXPRESSION over every row of a CSV whose\n");
+    fprintf(stderr, "                                header names the variables, one result per row\n");
+    fprintf(stderr, "  --verbosity LEVEL             Diagnostics printed to stderr: quiet, result, tokens,\n");
+    fprintf(stderr, "                                tree or trace; each level adds to the last (default\n");
+    fprintf(stderr, "                                tree at the prompt, result in batch modes)\n");
+    fprintf(stderr, "  --trace-optimizer             Same as --verbosity trace: print each expression tree\n");
+    fprintf(stderr, "                                before and after constant folding and simplification\n");
+    fprintf(stderr, "  --check-zero-alloc [FILE]     Evaluate every line of FILE (or stdin) twice and fail\n");
+    fprintf(stderr, "                                if the second, warmed-up pass allocates\n");
+    fprintf(stderr, "  --stats                       Print per-stage latency percentiles on exit\n");
+    fprintf(stderr, "                                (\\stats prints them from the prompt)\n");
+    fprintf(stderr, "  --cache-bytes N               Memory cap of the parsed-expression cache used in\n");
+    fprintf(stderr, "                                batch modes (0 disables it, default %u)\n", EXPRESSION_CACHE_DEFAULT_BYTES);
+    fprintf(stderr, "  --alloc-stats                 Count allocations, bytes and peak live bytes per\n");
+    fprintf(stderr, "                                stage and print them on exit\n");
+    fprintf(stderr, "  --reactive                    Keep assignments as formulas: reassigning a variable\n");
+    fprintf(stderr, "                                recomputes every variable that depends on it\n");
+    fprintf(stderr, "  --sink MODE                   How results are appended to the log: off, buffered\n");
+    fprintf(stderr, "                                (default) or async (a writer thread does the I/O)\n");
+    fprintf(stderr, "  --sink-file PATH              Result log (default %s)\n", RESULT_SINK_DEFAULT_PATH);
+}
+
+static bool is_path_argument(const char* arg) {
+    return arg[0] != '-' || strcmp(arg, "-") == 0;
+}
+
+int main(int argc, char** argv) {
+    bool batch_mode = false;
+    bool parallel = false;
+    size_t threads = 0;
+    bool pipeline = false;
+    size_t pipeline_depth = 0;
+    const char* column_expression = NULL;
+    const char* socket_path = NULL;
+    const char* input_path = NULL;
+    CalcVerbosity verbosity = CALC_VERBOSITY_RESULT;
+    bool verbosity_set = false;
+    bool print_stats = false;
+    bool alloc_stats = false;
+    bool zero_alloc_check = false;
+    bool reactive = false;
+    ResultSinkMode sink_mode = RESULT_SINK_BUFFERED;
+    const char* sink_path = RESULT_SINK_DEFAULT_PATH;
+    size_t cache_bytes = EXPRESSION_CACHE_DEFAULT_BYTES;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--batch") == 0) {
+            batch_mode = true;
+            if (i + 1 < argc && is_path_argument(argv[i + 1])) {
+                input_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            parallel = true;
+            threads = (size_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            pipeline = true;
+            if (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) {
+                pipeline_depth = (size_t)strtoul(argv[++i], NULL, 10);
+            }
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc) {
+            column_expression = argv[++i];
+            if (i + 1 < argc && is_path_argument(argv[i + 1])) {
+                input_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--trace-optimizer") == 0) {
+            verbosity = CALC_VERBOSITY_TRACE;
+            verbosity_set = true;
+        } else if (strcmp(argv[i], "--verbosity") == 0 && i + 1 < argc && calc_verbosity_parse(argv[i + 1], &verbosity) == 0) {
+            verbosity_set = true;
+            i++;
+        } else if (strcmp(argv[i], "--check-zero-alloc") == 0) {
+            zero_alloc_check = true;
+            if (i + 1 < argc && is_path_argument(argv[i + 1])) {
+                input_path = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            print_stats = true;
+        } else if (strcmp(argv[i], "--cache-bytes") == 0 && i + 1 < argc) {
+            cache_bytes = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--alloc-stats") == 0) {
+            alloc_stats = true;
+        } else if (strcmp(argv[i], "--reactive") == 0) {
+            reactive = true;
+        } else if (strcmp(argv[i], "--sink") == 0 && i + 1 < argc && result_sink_parse_mode(argv[i + 1], &sink_mode) == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--sink-file") == 0 && i + 1 < argc) {
+            sink_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Modifiers of a mode that is not running are refused rather than dropped
+    bool plain_batch = batch_mode && !column_expression && !zero_alloc_check && !socket_path;
+    const char* conflict = NULL;
+    if (parallel && !plain_batch && !socket_path) {
+        conflict = "--threads applies only to --batch and --serve";
+    } else if (pipeline && !plain_batch) {
+        conflict = "--pipeline applies only to --batch";
+    } else if (pipeline && parallel) {
+        conflict = "--pipeline runs its own three threads and cannot be combined with --threads";
+    }
+    if (conflict) {
+        fprintf(stderr, "%s\n", conflict);
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Counting starts before the engine exists so its registry is accounted for
+    if ((alloc_stats || zero_alloc_check) && alloc_stats_enable() != 0) {
+        fprintf(stderr, "Allocation counting needs the C library allocator\n");
+        return 1;
+    }
+
+    CalcEngine* engine = calc_engine_create();
+    if (!engine) {
+        fprintf(stderr, "Initialization of the calculator engine failed\n");
+        return 1;
+    }
+    // The prompt shows tokens and trees unless told otherwise; other modes only their summary
+    bool interactive = !(batch_mode || column_expression || zero_alloc_check || socket_path);
+    engine->verbosity = verbosity_set || !interactive ? verbosity : CALC_VERBOSITY_TREE;
+    expression_cache_set_limit(engine->expression_cache, cache_bytes);
+    if (reactive && reactive_enable(engine) != 0) {
+        fprintf(stderr, "Initialization of reactive mode failed\n");
+        calc_engine_destroy(engine);
+        return 1;
+    }
+    ResultSink* sink = result_sink_open(sink_mode, sink_path);
+    if (!sink) {
+        perror(sink_path);
+        calc_engine_destroy(engine);
+        return 1;
+    }
+    engine->result_sink = sink;
+
+    int status = 0;
+    if (socket_path) {
+        status = process_daemon(engine, socket_path, threads);
+    } else if (!interactive) {
+        FILE* in = stdin;
+        if (input_path && strcmp(input_path, "-") != 0) {
+            in = fopen(input_path, "r");
+            if (!in) {
+                perror(input_path);
+                calc_engine_destroy(engine);
+                result_sink_close(sink);
+                return 1;
+            }
+        }
+        if (zero_alloc_check) {
+            status = process_zero_alloc_check(engine, in);
+        } else if (column_expression) {
+            status = process_column_input(engine, column_expression, in, stdout);
+        } else if (pipeline) {
+            status = process_pipeline_batch_input(engine, in, stdout, pipeline_depth, print_stats);
+        } else if (parallel) {
+            status = process_parallel_batch_input(engine, in, stdout, threads);
+        } else {
+            status = process_batch_input(engine, in, stdout);
+        }
+        if (in != stdin) {
+            fclose(in);
+        }
+    } else {
+        process_custom_input(engine);
+    }
+
+    if (print_stats) {
+        stage_stats_print(stderr, engine->stage_stats);
+        expression_cache_print(stderr, engine->expression_cache);
+        if (engine->reactive) {
+            reactive_graph_print(stderr, engine->reactive);
+        }
+        result_sink_print(stderr, sink);
+    }
+    calc_engine_destroy(engine);
+    if (result_sink_close(sink) != 0) {
+        fprintf(stderr, "Some results could not be written to %s\n", sink_path);
+        status = 1;
+    }
+    if (alloc_stats) {
+        alloc_stats_print(stderr);
+    }
+
+    return status;
 }
@@ -0,0 +1,601 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include "../../include/server/daemon.h"
+#include "../../include/computation/batch.h"
+#include "../../include/computation/expression_cache.h"
+#include "../../include/datastructures/allocator.h"
+
+#define MAX_EVENTS 64
+#define READ_CHUNK (64 * 1024)
+// Unread requests or unsent responses a connection may hold before the loop stops reading from it
+#define MAX_BUFFERED (1024 * 1024)
+// Longest text a response carries ("%.17g" of a double fits)
+#define MAX_RESPONSE_TEXT 32
+
+/*
+ * A connection belongs to the loop thread except while busy, when one worker
+ * is evaluating its requests. in, out and closing are shared with that worker
+ * and guarded by lock; the other fields are only touched by the loop.
+ */
+typedef struct Connection {
+    int fd;
+    CalcEngine* engine;           // Session of this client (a clone of the daemon's engine)
+
+    pthread_mutex_t lock;
+    char* in;                     // Received bytes no worker has taken yet
+    size_t in_length;
+    size_t in_capacity;
+    char* out;                    // Encoded responses; out_sent of them already written
+    size_t out_length;
+    size_t out_sent;
+    size_t out_capacity;
+    bool closing;                 // No more requests will be read: close once answered and flushed
+
+    bool busy;                    // Queued for or held by a worker
+    bool broken;                  // Socket error or hang-up: close as soon as no worker holds it
+    uint32_t events;              // Events registered with epoll (0 once removed)
+    struct Connection* next;      // Link in the work queue or the completion list
+    struct Connection* next_open; // Link in the daemon's list of open connections
+    struct Connection* prev_open;
+} Connection;
+
+struct CalcDaemon {
+    CalcEngine* engine;           // Prototype every connection is cloned from
+    char* path;
+    int listen_fd;
+    int epoll_fd;
+    int wake_fd;                  // eventfd: workers finished a connection, or a stop request
+    atomic_int stopping;
+
+    pthread_t* threads;
+    size_t worker_count;
+    size_t started;               // Workers actually running
+    pthread_mutex_t queue_lock;
+    pthread_cond_t queue_ready;
+    Connection* queue_head;       // Connections with complete requests waiting for a worker
+    Connection* queue_tail;
+    bool workers_stopping;
+
+    pthread_mutex_t done_lock;
+    Connection* done;             // Connections handed back by workers, not yet seen by the loop
+
+    Connection* open;             // Every open connection (loop thread only)
+    size_t open_count;
+    size_t connections;
+    size_t peak_connections;
+    atomic_size_t requests;
+    atomic_size_t failed;
+};
+
+typedef struct {
+    char* requests;               // Frames taken from a connection
+    size_t requests_capacity;
+    char* responses;              // Frames to append to the connection's output
+    size_t responses_capacity;
+    char expression[CALC_DAEMON_MAX_REQUEST + 1];
+} WorkerScratch;
+
+static int reserve(char** buffer, size_t* capacity, size_t needed) {
+    if (needed <= *capacity) return 0;
+    size_t grown = *capacity ? *capacity : 4096;
+    while (grown < needed) grown *= 2;
+    char* resized = (char*)calc_realloc(*buffer, grown);
+    if (!resized) return -1;
+    *buffer = resized;
+    *capacity = grown;
+    return 0;
+}
+
+static uint32_t read_length(const char* bytes) {
+    const unsigned char* b = (const unsigned char*)bytes;
+    return ((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) | ((uint32_t)b[2] << 8) | (uint32_t)b[3];
+}
+
+static void write_length(char* bytes, uint32_t length) {
+    bytes[0] = (char)(length >> 24);
+    bytes[1] = (char)(length >> 16);
+    bytes[2] = (char)(length >> 8);
+    bytes[3] = (char)length;
+}
+
+static void wake_loop(CalcDaemon* daemon) {
+    uint64_t one = 1;
+    ssize_t written = write(daemon->wake_fd, &one, sizeof(one));
+    (void)written; // A full counter already guarantees a wake-up
+}
+
+// Whether a worker has something to do: a whole request or an oversized header. Caller holds lock
+static bool has_request(const Connection* conn) {
+    if (conn->in_length < CALC_DAEMON_HEADER_BYTES) return false;
+    uint32_t length = read_length(conn->in);
+    return length > CALC_DAEMON_MAX_REQUEST || conn->in_length - CALC_DAEMON_HEADER_BYTES >= length;
+}
+
+static int append_response(WorkerScratch* scratch, size_t* length, CalcDaemonStatus status, const char* text) {
+    size_t text_length = strlen(text);
+    size_t frame = CALC_DAEMON_HEADER_BYTES + 1 + text_length;
+    if (reserve(&scratch->responses, &scratch->responses_capacity, *length + frame) != 0) return -1;
+
+    char* at = scratch->responses + *length;
+    write_length(at, (uint32_t)(1 + text_length));
+    at[CALC_DAEMON_HEADER_BYTES] = (char)status;
+    memcpy(at + CALC_DAEMON_HEADER_BYTES + 1, text, text_length);
+    *length += frame;
+    return 0;
+}
+
+// Evaluates every complete request the connection has buffered and queues the responses
+static void serve_connection(CalcDaemon* daemon, Connection* conn, WorkerScratch* scratch) {
+    size_t taken = 0;
+    bool too_large = false;
+
+    pthread_mutex_lock(&conn->lock);
+    while (conn->in_length - taken >= CALC_DAEMON_HEADER_BYTES) {
+        uint32_t length = read_length(conn->in + taken);
+        if (length > CALC_DAEMON_MAX_REQUEST) {
+            too_large = true;
+            break;
+        }
+        if (conn->in_length - taken - CALC_DAEMON_HEADER_BYTES < length) break;
+        taken += CALC_DAEMON_HEADER_BYTES + length;
+    }
+    bool copied = reserve(&scratch->requests, &scratch->requests_capacity, taken) == 0;
+    if (copied) {
+        memcpy(scratch->requests, conn->in, taken);
+        memmove(conn->in, conn->in + taken, conn->in_length - taken);
+        conn->in_length -= taken;
+    }
+    if (too_large || !copied) {
+        // Nothing after the bad frame can be trusted
+        conn->in_length = 0;
+        conn->closing = true;
+    }
+    pthread_mutex_unlock(&conn->lock);
+    if (!copied) return;
+
+    size_t response_length = 0;
+    bool out_of_memory = false;
+    size_t requests = 0;
+    size_t failed = 0;
+    char text[MAX_RESPONSE_TEXT];
+
+    for (size_t offset = 0; offset < taken;) {
+        uint32_t length = read_length(scratch->requests + offset);
+        memcpy(scratch->expression, scratch->requests + offset + CALC_DAEMON_HEADER_BYTES, length);
+        scratch->expression[length] = '\0';
+        offset += CALC_DAEMON_HEADER_BYTES + length;
+
+        BatchResult result = evaluate_expression_text(conn->engine, scratch->expression);
+        int status;
+        if (result.error == COMPUTATION_OK) {
+            snprintf(text, sizeof(text), "%.17g", result.value);
+            status = append_response(scratch, &response_length, CALC_DAEMON_OK, text);
+        } else {
+            failed++;
+            status = append_response(scratch, &response_length, CALC_DAEMON_EVAL_ERROR, "error");
+        }
+        if (status != 0) {
+            out_of_memory = true;
+            break;
+        }
+        requests++;
+    }
+    if (too_large && append_response(scratch, &response_length, CALC_DAEMON_TOO_LARGE, "request too large") == 0) {
+        requests++;
+        failed++;
+    }
+
+    pthread_mutex_lock(&conn->lock);
+    if (reserve(&conn->out, &conn->out_capacity, conn->out_length + response_length) == 0) {
+        memcpy(conn->out + conn->out_length, scratch->responses, response_length);
+        conn->out_length += response_length;
+    } else {
+        out_of_memory = true;
+    }
+    if (out_of_memory) {
+        // Responses must not go missing from the middle of a pipeline: answer
+        // what was evaluated and hang up
+        conn->in_length = 0;
+        conn->closing = true;
+    }
+    pthread_mutex_unlock(&conn->lock);
+
+    atomic_fetch_add_explicit(&daemon->requests, requests, memory_order_relaxed);
+    atomic_fetch_add_explicit(&daemon->failed, failed, memory_order_relaxed);
+}
+
+static void* worker_main(void* arg) {
+    CalcDaemon* daemon = (CalcDaemon*)arg;
+    WorkerScratch* scratch = (WorkerScratch*)calc_calloc(1, sizeof(WorkerScratch));
+
+    for (;;) {
+        pthread_mutex_lock(&daemon->queue_lock);
+        while (!daemon->queue_head && !daemon->workers_stopping) {
+            pthread_cond_wait(&daemon->queue_ready, &daemon->queue_lock);
+        }
+        if (daemon->workers_stopping) {
+            pthread_mutex_unlock(&daemon->queue_lock);
+            break;
+        }
+        Connection* conn = daemon->queue_head;
+        daemon->queue_head = conn->next;
+        if (!daemon->queue_head) daemon->queue_tail = NULL;
+        pthread_mutex_unlock(&daemon->queue_lock);
+
+        if (scratch) {
+            serve_connection(daemon, conn, scratch);
+        } else {
+            pthread_mutex_lock(&conn->lock);
+            conn->closing = true;
+            pthread_mutex_unlock(&conn->lock);
+        }
+
+        pthread_mutex_lock(&daemon->done_lock);
+        conn->next = daemon->done;
+        daemon->done = conn;
+        pthread_mutex_unlock(&daemon->done_lock);
+        wake_loop(daemon);
+    }
+
+    if (scratch) {
+        calc_free(scratch->requests);
+        calc_free(scratch->responses);
+        calc_free(scratch);
+    }
+    return NULL;
+}
+
+static void dispatch(CalcDaemon* daemon, Connection* conn) {
+    conn->busy = true;
+    conn->next = NULL;
+    pthread_mutex_lock(&daemon->queue_lock);
+    if (daemon->queue_tail) {
+        daemon->queue_tail->next = conn;
+    } else {
+        daemon->queue_head = conn;
+    }
+    daemon->queue_tail = conn;
+    pthread_cond_signal(&daemon->queue_ready);
+    pthread_mutex_unlock(&daemon->queue_lock);
+}
+
+static void close_connection(CalcDaemon* daemon, Connection* conn) {
+    if (conn->events) {
+        epoll_ctl(daemon->epoll_fd, EPOLL_CTL_DEL, conn->fd, NULL);
+    }
+    close(conn->fd);
+
+    if (conn->prev_open) {
+        conn->prev_open->next_open = conn->next_open;
+    } else {
+        daemon->open = conn->next_open;
+    }
+    if (conn->next_open) conn->next_open->prev_open = conn->prev_open;
+    daemon->open_count--;
+
+    stage_stats_merge(daemon->engine->stage_stats, conn->engine->stage_stats);
+    expression_cache_merge_counters(daemon->engine->expression_cache, conn->engine->expression_cache);
+    calc_engine_destroy(conn->engine);
+    pthread_mutex_destroy(&conn->lock);
+    calc_free(conn->in);
+    calc_free(conn->out);
+    calc_free(conn);
+}
+
+static void set_events(CalcDaemon* daemon, Connection* conn, uint32_t events) {
+    if (events == conn->events) return;
+
+    struct epoll_event event = { .events = events, .data.ptr = conn };
+    int op = conn->events == 0 ? EPOLL_CTL_ADD : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+    if (epoll_ctl(daemon->epoll_fd, op, conn->fd, &event) == 0) {
+        conn->events = events;
+    } else {
+        conn->broken = true;
+    }
+}
+
+static void flush_output(Connection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    while (conn->out_sent < conn->out_length) {
+        ssize_t sent = send(conn->fd, conn->out + conn->out_sent, conn->out_length - conn->out_sent,
+                            MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent > 0) {
+            conn->out_sent += (size_t)sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (sent == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) conn->broken = true;
+            break;
+        }
+    }
+    if (conn->out_sent == conn->out_length) {
+        conn->out_sent = conn->out_length = 0;
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+static void read_input(Connection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    if (reserve(&conn->in, &conn->in_capacity, conn->in_length + READ_CHUNK) != 0) {
+        conn->broken = true;
+    } else {
+        ssize_t received;
+        do {
+            received = recv(conn->fd, conn->in + conn->in_length, READ_CHUNK, MSG_DONTWAIT);
+        } while (received < 0 && errno == EINTR);
+
+        if (received > 0) {
+            conn->in_length += (size_t)received;
+        } else if (received == 0) {
+            conn->closing = true;
+        } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            conn->broken = true;
+        }
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+// Decides what happens next to a connection the loop holds: evaluate, wait for I/O or close
+static void update_connection(CalcDaemon* daemon, Connection* conn) {
+    pthread_mutex_lock(&conn->lock);
+    bool request = has_request(conn);
+    bool pending_output = conn->out_sent < conn->out_length;
+    bool closing = conn->closing;
+    bool full = conn->in_length >= MAX_BUFFERED || conn->out_length - conn->out_sent >= MAX_BUFFERED;
+    pthread_mutex_unlock(&conn->lock);
+
+    if (conn->broken) {
+        if (conn->busy) {
+            set_events(daemon, conn, 0);
+        } else {
+            close_connection(daemon, conn);
+        }
+        return;
+    }
+    if (!conn->busy && request) {
+        dispatch(daemon, conn);
+    }
+    if (!conn->busy && closing && !pending_output) {
+        close_connection(daemon, conn);
+        return;
+    }
+    set_events(daemon, conn, (closing || full ? 0 : EPOLLIN) | (pending_output ? EPOLLOUT : 0));
+}
+
+static void drain_completed(CalcDaemon* daemon) {
+    pthread_mutex_lock(&daemon->done_lock);
+    Connection* conn = daemon->done;
+    daemon->done = NULL;
+    pthread_mutex_unlock(&daemon->done_lock);
+
+    while (conn) {
+        Connection* next = conn->next;
+        conn->busy = false;
+        flush_output(conn);
+        update_connection(daemon, conn);
+        conn = next;
+    }
+}
+
+static void accept_connections(CalcDaemon* daemon) {
+    for (;;) {
+        int fd = accept(daemon->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN, or out of descriptors: the backlog keeps the rest
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+        Connection* conn = (Connection*)calc_calloc(1, sizeof(Connection));
+        if (conn) conn->engine = calc_engine_clone(daemon->engine);
+        if (!conn || !conn->engine) {
+            calc_free(conn);
+            close(fd);
+            continue;
+        }
+        conn->fd = fd;
+        pthread_mutex_init(&conn->lock, NULL);
+
+        conn->next_open = daemon->open;
+        if (daemon->open) daemon->open->prev_open = conn;
+        daemon->open = conn;
+        daemon->open_count++;
+        daemon->connections++;
+        if (daemon->open_count > daemon->peak_connections) {
+            daemon->peak_connections = daemon->open_count;
+        }
+
+        set_events(daemon, conn, EPOLLIN);
+        if (conn->broken) close_connection(daemon, conn);
+    }
+}
+
+static int open_listener(const char* path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    // A socket left behind by an earlier daemon would make bind() fail
+    struct stat info;
+    if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+CalcDaemon* calc_daemon_create(CalcEngine* engine, const char* path, size_t workers) {
+    if (!engine || !path) return NULL;
+
+    CalcDaemon* daemon = (CalcDaemon*)calc_calloc(1, sizeof(CalcDaemon));
+    if (!daemon) return NULL;
+    daemon->engine = engine;
+    daemon->listen_fd = daemon->epoll_fd = daemon->wake_fd = -1;
+    pthread_mutex_init(&daemon->queue_lock, NULL);
+    pthread_cond_init(&daemon->queue_ready, NULL);
+    pthread_mutex_init(&daemon->done_lock, NULL);
+
+    if (workers == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (size_t)online : 1;
+    }
+    daemon->worker_count = workers;
+
+    daemon->path = calc_strdup(path);
+    daemon->listen_fd = daemon->path ? open_listener(path) : -1;
+    if (daemon->listen_fd < 0) {
+        calc_daemon_destroy(daemon);
+        return NULL;
+    }
+    daemon->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    daemon->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (daemon->epoll_fd < 0 || daemon->wake_fd < 0) {
+        calc_daemon_destroy(daemon);
+        return NULL;
+    }
+
+    // The listening socket is tagged NULL and the eventfd with the daemon itself
+    struct epoll_event listen_event = { .events = EPOLLIN, .data.ptr = NULL };
+    struct epoll_event wake_event = { .events = EPOLLIN, .data.ptr = daemon };
+    if (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->listen_fd, &listen_event) != 0 ||
+        epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, daemon->wake_fd, &wake_event) != 0) {
+        calc_daemon_destroy(daemon);
+        return NULL;
+    }
+
+    daemon->threads = (pthread_t*)calc_calloc(workers, sizeof(pthread_t));
+    if (!daemon->threads) {
+        calc_daemon_destroy(daemon);
+        return NULL;
+    }
+    for (; daemon->started < workers; daemon->started++) {
+        if (pthread_create(&daemon->threads[daemon->started], NULL, worker_main, daemon) != 0) {
+            calc_daemon_destroy(daemon);
+            return NULL;
+        }
+    }
+
+    return daemon;
+}
+
+size_t calc_daemon_workers(const CalcDaemon* daemon) {
+    return daemon->worker_count;
+}
+
+int calc_daemon_run(CalcDaemon* daemon) {
+    struct epoll_event events[MAX_EVENTS];
+
+    while (!atomic_load_explicit(&daemon->stopping, memory_order_acquire)) {
+        int ready = epoll_wait(daemon->epoll_fd, events, MAX_EVENTS, -1);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        bool woken = false;
+        for (int i = 0; i < ready; i++) {
+            void* tag = events[i].data.ptr;
+            if (tag == NULL) {
+                accept_connections(daemon);
+            } else if (tag == daemon) {
+                woken = true;
+            } else {
+                Connection* conn = (Connection*)tag;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    conn->broken = true;
+                } else {
+                    if (events[i].events & EPOLLOUT) flush_output(conn);
+                    if (events[i].events & EPOLLIN) read_input(conn);
+                }
+                update_connection(daemon, conn);
+            }
+        }
+
+        // Completed connections are handled last: closing one frees it, and
+        // it may still have an entry further down this batch of events
+        if (woken) {
+            uint64_t count;
+            ssize_t drained = read(daemon->wake_fd, &count, sizeof(count));
+            (void)drained;
+            drain_completed(daemon);
+        }
+    }
+    return 0;
+}
+
+void calc_daemon_stop(CalcDaemon* daemon) {
+    atomic_store_explicit(&daemon->stopping, 1, memory_order_release);
+    wake_loop(daemon);
+}
+
+void calc_daemon_get_stats(const CalcDaemon* daemon, CalcDaemonStats* stats) {
+    stats->connections = daemon->connections;
+    stats->peak_connections = daemon->peak_connections;
+    stats->requests = atomic_load_explicit(&daemon->requests, memory_order_relaxed);
+    stats->failed = atomic_load_explicit(&daemon->failed, memory_order_relaxed);
+}
+
+void calc_daemon_print(FILE* out, const CalcDaemon* daemon) {
+    CalcDaemonStats stats;
+    calc_daemon_get_stats(daemon, &stats);
+    fprintf(out, "Daemon on %s (%zu workers): %zu connections (peak %zu open), %zu requests (%zu failed)\n",
+            daemon->path, daemon->worker_count, stats.connections, stats.peak_connections,
+            stats.requests, stats.failed);
+}
+
+void calc_daemon_destroy(CalcDaemon* daemon) {
+    if (!daemon) return;
+
+    pthread_mutex_lock(&daemon->queue_lock);
+    daemon->workers_stopping = true;
+    pthread_cond_broadcast(&daemon->queue_ready);
+    pthread_mutex_unlock(&daemon->queue_lock);
+    for (size_t i = 0; i < daemon->started; i++) {
+        pthread_join(daemon->threads[i], NULL);
+    }
+
+    // With the workers gone every connection is the loop's again
+    while (daemon->open) {
+        close_connection(daemon, daemon->open);
+    }
+
+    if (daemon->listen_fd >= 0) {
+        close(daemon->listen_fd);
+        unlink(daemon->path);
+    }
+    if (daemon->epoll_fd >= 0) close(daemon->epoll_fd);
+    if (daemon->wake_fd >= 0) close(daemon->wake_fd);
+    pthread_mutex_destroy(&daemon->queue_lock);
+    pthread_cond_destroy(&daemon->queue_ready);
+    pthread_mutex_destroy(&daemon->done_lock);
+    calc_free(daemon->threads);
+    calc_free(daemon->path);
+    calc_free(daemon);
+}
@@ -0,0 +1,55 @@
+#include <stdlib.h>
+#include "test_common.h"
+#include "computation/alloc_stats.h"
+#include "datastructures/allocator.h"
+
+static size_t custom_calls;
+
+static void* custom_malloc(size_t size, void* context) {
+    (void)context;
+    custom_calls++;
+    return malloc(size);
+}
+
+static void* custom_realloc(void* ptr, size_t size, void* context) {
+    (void)context;
+    custom_calls++;
+    return realloc(ptr, size);
+}
+
+static void custom_free(void* ptr, void* context) {
+    (void)context;
+    custom_calls++;
+    free(ptr);
+}
+
+static size_t total_allocations(void) {
+    AllocReport report;
+    alloc_stats_report(&report);
+    size_t total = 0;
+    for (int i = 0; i <= ALLOC_STAGE_OTHER; i++) total += report.stages[i].allocations;
+    return total;
+}
+
+int main(void) {
+    // Over the C library allocator: blocks from before enabling can be freed while counting and vice versa
+    void* before = calc_malloc(32);
+    CHECK(alloc_stats_enable() == 0, "enabling over the C library allocator failed");
+    alloc_stats_reset();
+    void* during = calc_malloc(64);
+    CHECK(total_allocations() == 1, "%zu allocations counted, expected 1", total_allocations());
+    calc_free(before);
+    alloc_stats_disable();
+    calc_free(during);
+    CHECK(calc_allocator_is_default(), "disabling did not restore the C library allocator");
+
+    // A custom allocator's blocks cannot be sized, so counting refuses to replace it
+    static const calc_allocator_t CUSTOM = { custom_malloc, custom_realloc, custom_free, NULL };
+    calc_set_allocator(&CUSTOM);
+    CHECK(alloc_stats_enable() == -1, "enabling over a custom allocator did not fail");
+    calc_free(calc_malloc(16));
+    CHECK(custom_calls == 2, "the custom allocator made %zu calls, expected 2", custom_calls);
+    calc_set_allocator(NULL);
+
+    return test_report("test_alloc_stats");
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test_common.h"
+#include "computation/batch.h"
+#include "computation/pipeline.h"
+
+#define LINE_COUNT 400
+
+// Unknown names, names used before and after their first assignment, reassignment
+// (an error outside reactive mode), blank lines and more new names than a table starts with
+static char** build_lines(void) {
+    static const char* FIXED[] = {
+        "y", "y = 3", "", "y", "z = 2", "   ", "z + q", "q = 1", "q", "z = z + 1", "w * 2 + y", "w = 5", "w",
+    };
+    size_t fixed = sizeof(FIXED) / sizeof(FIXED[0]);
+    char** lines = malloc(LINE_COUNT * sizeof(char*));
+    char buffer[64];
+    for (size_t i = 0; i < LINE_COUNT; i++) {
+        if (i < fixed) {
+            snprintf(buffer, sizeof(buffer), "%s", FIXED[i]);
+        } else if (i % 50 == 0) {
+            snprintf(buffer, sizeof(buffer), "v%zu = %zu", i % 70, i);
+        } else {
+            snprintf(buffer, sizeof(buffer), "v%zu + 1 - y * v%zu", i % 70, (i * 7) % 70);
+        }
+        lines[i] = strdup(buffer);
+    }
+    return lines;
+}
+
+static void check_same(const char* mode, char* const* lines, const BatchResult* expected, const BatchResult* results) {
+    for (size_t i = 0; i < LINE_COUNT; i++) {
+        bool same = expected[i].error == results[i].error &&
+                    (expected[i].error != COMPUTATION_OK || expected[i].value == results[i].value);
+        CHECK(same, "%s, line %zu \"%s\": serial %g (error %d), got %g (error %d)", mode, i, lines[i],
+              expected[i].value, expected[i].error, results[i].value, results[i].error);
+    }
+}
+
+int main(void) {
+    char** lines = build_lines();
+    BatchResult* expected = malloc(LINE_COUNT * sizeof(BatchResult));
+    BatchResult* results = malloc(LINE_COUNT * sizeof(BatchResult));
+
+    CalcEngine* serial = test_engine();
+    for (size_t i = 0; i < LINE_COUNT; i++) {
+        expected[i] = evaluate_expression_text(serial, lines[i]);
+    }
+    calc_engine_destroy(serial);
+
+    CalcEngine* engine = test_engine();
+    BatchEvaluator* evaluator = batch_evaluator_create(engine, 4);
+    CHECK(evaluator && batch_evaluate(evaluator, lines, LINE_COUNT, results) == 0, "threaded evaluation failed");
+    check_same("threads", lines, expected, results);
+    batch_evaluator_destroy(evaluator);
+    calc_engine_destroy(engine);
+
+    static const size_t DEPTHS[] = { 1, 4, 64 };
+    for (size_t d = 0; d < sizeof(DEPTHS) / sizeof(DEPTHS[0]); d++) {
+        engine = test_engine();
+        PipelineEvaluator* pipeline = pipeline_evaluator_create(engine, DEPTHS[d]);
+        // Two runs, so the second starts from the names and values the first left behind
+        size_t half = LINE_COUNT / 2;
+        CHECK(pipeline && pipeline_evaluate(pipeline, lines, half, results) == 0 &&
+              pipeline_evaluate(pipeline, lines + half, LINE_COUNT - half, results + half) == 0,
+              "pipeline evaluation at depth %zu failed", DEPTHS[d]);
+        char mode[32];
+        snprintf(mode, sizeof(mode), "pipeline depth %zu", DEPTHS[d]);
+        check_same(mode, lines, expected, results);
+        pipeline_evaluator_destroy(pipeline);
+        calc_engine_destroy(engine);
+    }
+
+    for (size_t i = 0; i < LINE_COUNT; i++) free(lines[i]);
+    free(lines);
+    free(expected);
+    free(results);
+    return test_report("test_batch_equivalence");
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Checks the CLI's batch modes against each other: one output line per input
+# line (blank lines included) and every result logged to the result sink.
+# Usage: test_cli.sh PATH_TO_CALC
+calc=${1:?usage: test_cli.sh PATH_TO_CALC}
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+failures=0
+
+fail() {
+    echo "tests/test_cli.sh: $*" >&2
+    failures=$((failures + 1))
+}
+
+# Blank and whitespace-only lines keep output aligned with input
+printf '1+1\n\n2+2\n   \n3+3\n' > "$work/blank.txt"
+for mode in "" "--threads 4" "--pipeline"; do
+    "$calc" --batch "$work/blank.txt" $mode --sink off > "$work/out.txt" 2>/dev/null
+    printf '2\n\n4\n\n6\n' | cmp -s - "$work/out.txt" || fail "--batch $mode: blank lines misaligned the output"
+done
+
+
+# Every mode logs the same results, in input order, to the result sink
+i=0
+: > "$work/mixed.txt"
+while [ $i -lt 1000 ]; do
+    case $((i % 100)) in
+        0) echo "v$i = $i" ;;
+        50) echo "1 +" ;;
+        *) echo "$i * 2 + v$((i / 100 * 100))" ;;
+    esac >> "$work/mixed.txt"
+    i=$((i + 1))
+done
+"$calc" --batch "$work/mixed.txt" --sink-file "$work/serial.log" > /dev/null 2>&1
+logged=$(wc -l < "$work/serial.log")
+[ "$logged" -eq 990 ] || fail "--batch logged $logged results, expected 990"
+for mode in "--threads 4" "--pipeline" "--threads 4 --sink async"; do
+    rm -f "$work/mode.log"
+    "$calc" --batch "$work/mixed.txt" $mode --sink-file "$work/mode.log" > /dev/null 2>&1
+    cmp -s "$work/serial.log" "$work/mode.log" || fail "--batch $mode logged different results than serial"
+done
+
+echo "test_cli                 $([ $failures -eq 0 ] && echo ok || echo "FAILED ($failures checks)")"
+[ $failures -eq 0 ]
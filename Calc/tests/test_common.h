@@ -0,0 +1,43 @@
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H
+
+#include <stdio.h>
+#include "computation/engine.h"
+
+// Failed checks in the current test program
+static int test_failures;
+
+/**
+ * @brief Records a failed check with its location, without stopping the test
+ */
+#define CHECK(condition, ...) do {                                  \
+    if (!(condition)) {                                             \
+        test_failures++;                                            \
+        fprintf(stderr, "%s:%d: ", __FILE__, __LINE__);             \
+        fprintf(stderr, __VA_ARGS__);                               \
+        fputc('\n', stderr);                                        \
+    }                                                               \
+} while (0)
+
+/**
+ * @brief Creates the engine a test runs in, with diagnostics silenced
+ * @return The engine or NULL on failure
+ */
+static inline CalcEngine* test_engine(void) {
+    CalcEngine* engine = calc_engine_create();
+    if (engine) engine->verbosity = CALC_VERBOSITY_QUIET;
+    return engine;
+}
+
+/**
+ * @brief Prints the test's verdict
+ * @param name Test program name
+ * @return Process exit status: 0 when every check passed
+ */
+static inline int test_report(const char* name) {
+    printf("%-24s %s", name, test_failures == 0 ? "ok\n" : "FAILED");
+    if (test_failures) printf(" (%d checks)\n", test_failures);
+    return test_failures == 0 ? 0 : 1;
+}
+
+#endif /* TEST_COMMON_H */
@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "test_common.h"
+#include "computation/computation.h"
+#include "computation/compiled_expression.h"
+#include "computation/jit.h"
+
+#define SAMPLES 10000
+
+static const char* VARIABLE_NAMES[] = { "x", "y" };
+
+// Every opcode the JIT emits, inline and through libm, plus unary minus and division by zero
+static const char* FORMULAS[] = {
+    "x*2 + y",
+    "-(x - y)^3 / (x + 0.5) + -x",
+    "x / (y - y)",
+    "sqrt(x^2+y^2) * cos(x) - logbase(2, y+1) / (1 + abs(x-y))",
+    "sin(x)*tan(y) + exp(-x) - log10(abs(y)+1) + log2(abs(x)+1) + loge(abs(x*y)+1) + log(abs(y)+2)",
+    "((((x*1.01+0.5)*1.01+0.5)*1.01+0.5)*1.01+y)*((x+y)*(x-y)+x*y)/(x*x+y*y+1)",
+};
+
+// Deterministic inputs spanning negatives, zero and large magnitudes
+static double next_value(unsigned long long* state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    double unit = (double)(*state >> 11) / 9007199254740992.0;
+    return (unit - 0.5) * 200.0;
+}
+
+static bool same_result(double a, double b) {
+    return a == b || (isnan(a) && isnan(b));
+}
+
+// Compares the native code with traversal() on the expression's own tree
+static void check_formula(CalcEngine* engine, const char* formula) {
+    CompileError error;
+    CompiledExpression* expr = compile_expression(engine, formula, VARIABLE_NAMES, 2, &error);
+    CHECK(expr, "%s: failed to compile", formula);
+    if (!expr) return;
+
+    JitFunction native = compiled_expression_enable_jit(expr);
+    CHECK(native, "%s: JIT compilation failed", formula);
+    if (!native) {
+        compiled_expression_free(expr);
+        return;
+    }
+
+    size_t token_bytes = sizeof(Token) * expr->postfix->token_count;
+    Token* pristine = malloc(token_bytes);
+    memcpy(pristine, expr->postfix->tokens, token_bytes);
+
+    unsigned long long state = 42;
+    size_t mismatches = 0;
+    for (int sample = 0; sample < SAMPLES; sample++) {
+        for (size_t slot = 0; slot < expr->variable_count; slot++) {
+            compiled_expression_set_variable(expr, slot, sample == 0 ? 0.0 : next_value(&state));
+        }
+
+        // traversal() overwrites the tokens it evaluates, so each sample starts from a pristine copy
+        memcpy(expr->postfix->tokens, pristine, token_bytes);
+        traversal(expr->ast->root, expr->symbols->values);
+        double expected = expr->ast->root->token->data.num_value;
+        if (!same_result(expected, native(expr->values))) mismatches++;
+    }
+    CHECK(mismatches == 0, "%s: %zu of %d samples differ from traversal()", formula, mismatches, SAMPLES);
+
+    memcpy(expr->postfix->tokens, pristine, token_bytes);
+    free(pristine);
+    compiled_expression_free(expr);
+}
+
+int main(void) {
+    CalcEngine* engine = test_engine();
+    if (!engine) return 1;
+
+    if (jit_supported()) {
+        for (size_t i = 0; i < sizeof(FORMULAS) / sizeof(FORMULAS[0]); i++) {
+            check_formula(engine, FORMULAS[i]);
+        }
+    } else {
+        printf("JIT not supported on this platform; skipping\n");
+    }
+
+    calc_engine_destroy(engine);
+    return test_report("test_jit");
+}
@@ -0,0 +1,37 @@
+#include "test_common.h"
+#include "computation/batch.h"
+
+typedef struct {
+    const char* input;
+    double expected;
+} Case;
+
+// A sign binds tighter than '*' and '/' but looser than '^', and a later binary operator pops it
+static const Case CASES[] = {
+    { "-3+4", 1 },
+    { "-(3)+1", -2 },
+    { "2*-3", -6 },
+    { "2*-3+1", -5 },
+    { "-3*2+1", -5 },
+    { "-2^2", -4 },
+    { "2^-1", 0.5 },
+    { "-2*3^2", -18 },
+    { "--3", 3 },
+    { "1 - -3", 4 },
+    { "-sqrt(4)*3", -6 },
+    { "+2-5", -3 },
+};
+
+int main(void) {
+    CalcEngine* engine = test_engine();
+    if (!engine) return 1;
+
+    for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+        BatchResult result = evaluate_expression_text(engine, CASES[i].input);
+        CHECK(result.error == COMPUTATION_OK && result.value == CASES[i].expected,
+              "%s: expected %g, got %g (error %d)", CASES[i].input, CASES[i].expected, result.value, result.error);
+    }
+
+    calc_engine_destroy(engine);
+    return test_report("test_unary");
+}